@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <Histogram.h>
+
+// ==================== AUDIO POWER GATING ====================
+// A silent DFPlayer keeps drawing its idle current, and so does the
+// amplifier behind it. Once the box has been quiet for the idle timeout,
+// the amplifier's shutdown input goes low and the DFPlayer is sent to
+// sleep. The next play wakes both without waiting for a reply: the
+// amplifier pin goes high and a wake frame leads the play burst, so the
+// module works through wake, settings and play from its input FIFO.
+// Selecting the SD card again keeps volume and EQ; a reset also works but
+// costs a full card mount and forgets both. The emulator's assumed
+// latencies make the first about three times faster (test_native_player);
+// test_hardware times both to BUSY on a real module, and checks that the
+// play frame is taken while the card is still starting up.
+//
+// Wake-to-audio runs from the wake burst to the DFPlayer's BUSY line going
+// low, sampled on the service tick. The savings are the time spent in
+// audio.sleep, priced at the audio.idle current it replaced (see energy.h).
+// Boards without a DFPlayer only gate the amplifier.
+const uint16_t DEFAULT_AUDIO_IDLE_TIMEOUT = 60;  // seconds, 0 never sleeps
+const unsigned long AUDIO_WAKE_TIMEOUT = 3000;   // BUSY never went low: not measured
+
+struct AudioPowerStats {
+  uint32_t sleeps = 0;
+  uint32_t wakes = 0;
+  uint32_t unmeasuredWakes = 0;
+  Histogram wakeToAudioMicros;
+};
+
+extern AudioPowerStats audioPowerStats;
+
+// dfPlayerSerial is null on boards without a DFPlayer
+void audioPowerBegin(Print* dfPlayerSerial);
+// Audio has stopped; the idle timeout starts
+void audioPowerIdle();
+// Before every play. Writes the wake frame into `frame` if the chain was
+// asleep and returns its length, 0 otherwise.
+size_t audioPowerWake(uint8_t* frame);
+bool audioPowerAsleep();
+// From the service tick: watches BUSY after a wake
+void audioPowerService();
+void audioPowerSetIdleTimeout(uint16_t seconds);
+void printAudioPower();
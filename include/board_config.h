@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== PIN DEFINITIONS ====================
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define SDA_PIN 8
+#define SCL_PIN 9
+#define DFPLAYER_TX_PIN 17
+#define DFPLAYER_RX_PIN 18
+#define VOLUME_UP_PIN 4
+#define VOLUME_DOWN_PIN 5
+#define LED_PIN 2
+#elif defined(CONFIG_IDF_TARGET_ESP32)
+#define SDA_PIN 21
+#define SCL_PIN 22
+#define DFPLAYER_TX_PIN 17
+#define DFPLAYER_RX_PIN 16
+#define VOLUME_UP_PIN 32
+#define VOLUME_DOWN_PIN 33
+#define LED_PIN 2
+#else  // ESP32-C3 (original board)
+#define SDA_PIN 9
+#define SCL_PIN 8
+#define DFPLAYER_TX_PIN 0
+#define DFPLAYER_RX_PIN 1
+#define VOLUME_UP_PIN 5
+#define VOLUME_DOWN_PIN 6
+#define LED_PIN 4
+#endif
+
+// Cost-reduced boards without a DFPlayer (-D ENABLE_PWM_AUDIO): the SD card
+// on SPI and the audio pin that feeds the RC filter and amplifier
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define SD_SCK_PIN 12
+#define SD_MISO_PIN 13
+#define SD_MOSI_PIN 11
+#define SD_CS_PIN 10
+#define PWM_AUDIO_PIN 6
+#elif defined(CONFIG_IDF_TARGET_ESP32)
+#define SD_SCK_PIN 18
+#define SD_MISO_PIN 19
+#define SD_MOSI_PIN 23
+#define SD_CS_PIN 5
+#define PWM_AUDIO_PIN 25
+#else  // ESP32-C3: the DFPlayer's UART pins are free
+#define SD_SCK_PIN 10
+#define SD_MISO_PIN 3
+#define SD_MOSI_PIN 7
+#define SD_CS_PIN 1
+#define PWM_AUDIO_PIN 0
+#endif
+
+// Audio power gating (see audio_power.h): the DFPlayer's BUSY output, low
+// while it plays, and the amplifier's shutdown input, high to enable
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define DFPLAYER_BUSY_PIN 15
+#define AMP_SHUTDOWN_PIN 16
+#elif defined(CONFIG_IDF_TARGET_ESP32)
+#define DFPLAYER_BUSY_PIN 26
+#define AMP_SHUTDOWN_PIN 27
+#else  // ESP32-C3: the console is on USB, so the UART0 pins are free
+#define DFPLAYER_BUSY_PIN 20
+#define AMP_SHUTDOWN_PIN 21
+#endif
+
+// NFC polling on its own core (see nfc_reader.h)
+#if defined(DUAL_CORE_NFC) && CONFIG_FREERTOS_UNICORE
+#error "DUAL_CORE_NFC needs a dual-core ESP32 (esp32dev or esp32-s3 envs)"
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== CODEC BENCHMARK ====================
+// `codecs`: decodes a second of generated 22.05 kHz audio from RAM with
+// each built-in codec and prints one CODEC line per codec with the cycles
+// per second of audio and the share of this CPU it takes. MP3 needs real
+// files; tools/codec_bench.cpp compares it on a PC.
+#ifdef ENABLE_ESP32_AUDIO
+void printCodecBenchmark();
+#else
+inline void printCodecBenchmark() { Serial.println("Codec benchmark needs -D ENABLE_ESP32_AUDIO"); }
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== ENERGY ACCOUNTING ====================
+// Each power-relevant part of the box is always in exactly one state;
+// callers report transitions and the module adds up how long every state
+// lasted. Multiplying residency by a per-state current gives an estimate of
+// where a battery's charge goes, without a meter on the bench. The currents
+// are typical datasheet figures until `energy <state> <mA>` replaces them
+// with values measured on the real board (kept in NVS).
+enum PowerState : uint8_t {
+  POWER_NFC_FIELD_OFF,  // PN532 between polls
+  POWER_NFC_FIELD_ON,   // PN532 polling or reading a tag
+  POWER_AUDIO_SLEEP,
+  POWER_AUDIO_IDLE,
+  POWER_AUDIO_PLAYING,
+  // Waiting for the next timer in loop(). That is light sleep when the
+  // power manager has automatic light sleep enabled, plain idle otherwise;
+  // the current figure decides which one is modelled.
+  POWER_CPU_SLEEP,
+  POWER_CPU_ACTIVE,
+  POWER_LED_OFF,
+  POWER_LED_ON,
+  POWER_STATE_COUNT,
+};
+
+const uint16_t DEFAULT_BATTERY_CAPACITY = 2000;  // mAh
+
+void energyBegin();
+// Cheap enough for every poll and every loop() pass; safe from the NFC task.
+void energyEnter(PowerState state);
+void energyReset();
+bool energySetCurrent(const char* stateName, float milliamps);
+void energySetBattery(uint16_t milliampHours);
+// Charge that time in `state` saved over spending it in `baseline`
+float energySavedMilliampHours(PowerState state, PowerState baseline);
+void printEnergy();
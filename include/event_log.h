@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== EVENT LOG ====================
+// A persistent history for support cases: fixed 16-byte binary entries,
+// buffered in RAM and appended to two rotating files on LittleFS. Entries
+// go to flash a page at a time, when the box has been quiet for a while
+// or before it sleeps, and never more than LOG_MAX_WRITES_PER_HOUR times
+// an hour; anything beyond that waits in RAM, and if RAM fills up the
+// newest entries are dropped and counted.
+const uint16_t LOG_PAGE_SIZE = 256;
+const uint8_t LOG_BUFFER_PAGES = 4;
+const uint16_t LOG_FILE_SIZE = 16384;  // two of these
+const uint8_t LOG_MAX_WRITES_PER_HOUR = 12;
+const unsigned long LOG_IDLE_FLUSH_DELAY = 30000;
+
+enum LogEventType : uint8_t {
+  LOG_BOOT = 1,      // a: reset reason
+  LOG_PLAY,          // a: folder, b: track, c: tag-to-play µs
+  LOG_STOP,
+  LOG_READ_FAILURE,  // c: first UID bytes
+  LOG_GRACE_STOP,
+  LOG_CONTROL,       // a: command, b: argument
+  LOG_TAG_WRITE,     // a: ok, b: pages written
+  LOG_TAG_BOUND,     // a: 1 for a folder, b: track or folder
+  LOG_DROPPED,       // b: entries lost while the buffer was full
+};
+
+void eventLogBegin();
+void logEvent(LogEventType type, uint8_t a = 0, uint32_t b = 0, uint32_t c = 0);
+// Before sleeping; still bounded by the hourly write budget
+void eventLogFlush();
+void eventLogDump();
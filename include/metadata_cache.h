@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+#include <TagMetadata.h>
+
+// ==================== METADATA CACHE ====================
+// Extended metadata of recently seen tags, keyed by UID and payload
+// checksum. A tag that comes back unchanged gets its metadata at arrival
+// and the background read is skipped. RAM only: it refills on its own.
+const uint8_t METADATA_CACHE_SIZE = 8;
+
+const TagMetadata* metadataCacheFind(const uint8_t* uid, uint8_t uidLength, uint8_t checksum);
+void metadataCacheStore(const uint8_t* uid, uint8_t uidLength, uint8_t checksum, const TagMetadata& metadata);
+void metadataCacheForget(const uint8_t* uid, uint8_t uidLength);
+void printTagMetadata(const TagMetadata& metadata);
+void printMetadataCache();
@@ -0,0 +1,74 @@
+#pragma once
+#include <Adafruit_PN532.h>
+#include <TagMetadata.h>
+#include <TagRecord.h>
+
+// ==================== NFC READER ====================
+// Polling, UID tracking and record reads turn into TagEvents for the
+// playback side. On single-core boards nfcNextEvent() polls inline from
+// loop(). With DUAL_CORE_NFC the polling runs in a task pinned to the other
+// core, so PN532 waits never stall audio, buttons or the console; events
+// and commands cross between the cores through lock-free queues.
+//
+// A tag bound by UID in the tag library is not read at all, presets on it
+// included (see tag_library.h). Any other arrival reads pages 4..9 (record
+// slots, metadata header and first metadata page) in one FAST_READ, enough
+// to start playback. Extended
+// metadata is fetched afterwards, one NTAG READ per poll while the tag
+// stays put, and delivered as a separate TAG_EVENT_METADATA.
+//
+// Bank and transit cards and phones are ISO14443A too. Anything whose
+// ATQA/SAK is not an NTAG21x is reported as TAG_READ_IGNORED without a page
+// read (a read would only time out). Those targets, and NTAGs that read as
+// unprogrammed, go into a small negative cache keyed by UID, ATQA and SAK,
+// so coming back in and out of the field costs no reads either. An entry
+// expires once its target has been gone for NFC_NEGATIVE_CACHE_HOLD, so a
+// blank tag programmed elsewhere is read again next time; console reads
+// and writes (nfcAcquire) clear the cache.
+const unsigned long NFC_CHECK_INTERVAL = 200;
+const uint8_t NFC_NEGATIVE_CACHE_SIZE = 8;
+const unsigned long NFC_NEGATIVE_CACHE_HOLD = 1000;
+
+// How often loop() calls nfcNextEvent(): once per poll on single-core
+// boards, often enough to drain the event queue promptly otherwise.
+#ifdef DUAL_CORE_NFC
+const unsigned long NFC_EVENT_INTERVAL = 10;
+#else
+const unsigned long NFC_EVENT_INTERVAL = NFC_CHECK_INTERVAL;
+#endif
+
+enum TagReadStatus : uint8_t {
+  TAG_READ_OK,
+  TAG_READ_FAILED,        // page read failed (tag pulled away, RF error)
+  TAG_READ_UNPROGRAMMED,  // read fine, but no valid record
+  TAG_READ_SKIPPED,       // bound by UID in the tag library, no page read
+  TAG_READ_IGNORED,       // not an NTAG, or a blank one just seen; no page read
+};
+
+enum TagEventType : uint8_t { TAG_EVENT_ARRIVED, TAG_EVENT_REMOVED, TAG_EVENT_METADATA };
+
+struct TagEvent {
+  TagEventType type;
+  uint8_t uid[7];
+  uint8_t uidLength;
+  TagReadStatus readStatus;
+  TagRecord record;
+  TagMetadataHeader metadataHeader;  // ARRIVED: what the background read will fetch
+  TagMetadata metadata;              // METADATA only
+  unsigned long detectedAt;  // micros() right after the UID was read
+  unsigned long lastSeen;    // millis() of the latest detection
+};
+
+extern Adafruit_PN532 nfc;
+
+void initializeNFC();
+void nfcBegin();
+// Single-core: one blocking poll per call. Dual-core: the next queued event.
+bool nfcNextEvent(TagEvent& event);
+// From loop(): folds the NFC task's counters into `stats` (dual-core only)
+void nfcMergeStats();
+void nfcAcquire();
+void nfcRelease();
+// The current tag's metadata is already cached; skip the background read.
+void nfcSkipMetadata();
+TagReadStatus readTagRecord(TagRecord& record);
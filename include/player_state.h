@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+#include <SeqLock.h>
+
+// ==================== PLAYER STATE SNAPSHOT ====================
+// loop() owns SystemState and ButtonState. After every pass that changed
+// something it publishes this copy through a seqlock, so the console, web
+// UI and telemetry task read a consistent state from any core without a
+// mutex, and publishing costs loop() a few dozen stores.
+struct PlayerSnapshot {
+  bool tagPresent;
+  bool playing;
+  uint8_t track;
+  uint8_t folder;  // 0 for a single track
+  uint8_t volume;
+  uint8_t eq;
+  bool shuffle;
+  bool buttonsLocked;
+  bool sleepTimerArmed;
+  bool learning;
+};
+
+extern SeqLock<PlayerSnapshot> playerState;
+
+void publishPlayerState(const PlayerSnapshot& snapshot);
+PlayerSnapshot readPlayerState();
+void printPlayerState();
@@ -0,0 +1,27 @@
+#pragma once
+#include <Adafruit_PN532.h>
+
+// ==================== RAW PN532 DATA EXCHANGE ====================
+// The Adafruit driver only exposes single-page NTAG reads, although the tag
+// answers every READ with four pages. These helpers send InDataExchange
+// through the driver and read the response frame straight off the I2C bus.
+const uint8_t NTAG_CMD_READ = 0x30;
+const uint8_t NTAG_CMD_FAST_READ = 0x3A;
+const uint8_t NTAG_READ_SIZE = 16;
+// FAST_READ returns any page range in one frame; the ESP32 Wire buffer
+// (128 bytes, 11 of them frame overhead) caps it at 28 pages.
+const uint8_t NTAG_FAST_READ_MAX_PAGES = 28;
+
+bool pn532DataExchange(Adafruit_PN532& nfc, const uint8_t* tagCommand, uint8_t commandLength,
+                       uint8_t* response, uint8_t responseLength);
+bool pn532ReadPages(Adafruit_PN532& nfc, uint8_t startPage, uint8_t* data);
+// Pages startPage..endPage inclusive, 4 bytes each
+bool pn532FastRead(Adafruit_PN532& nfc, uint8_t startPage, uint8_t endPage, uint8_t* data);
+
+// ATQA (SENS_RES) and SAK (SEL_RES) of the target found by the last
+// readPassiveTargetID(), taken from the driver's response buffer: the
+// driver reads them but does not return them.
+void pn532LastTarget(uint16_t& atqa, uint8_t& sak);
+// NTAG213/215/216 answer ATQA 0044 and SAK 00. Bank and transit cards,
+// phones and MIFARE Classic fobs all report something else.
+inline bool isNtag21x(uint16_t atqa, uint8_t sak) { return atqa == 0x0044 && sak == 0x00; }
@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== PWM AUDIO OUTPUT (optional) ====================
+// For boards without a DFPlayer or DAC (-D ENABLE_ESP32_AUDIO plus
+// -D ENABLE_PWM_AUDIO): tracks are found through the track index, decoded
+// on the ESP32 and played on PWM_AUDIO_PIN by the sigma-delta modulator
+// (or LEDC PWM at 312.5 kHz with -D PWM_AUDIO_LEDC) behind an RC low-pass.
+//
+// pwmPlayerService(), on every service tick, decodes blocks into duty
+// values (lib/PwmAudio) and queues them in a lock-free ring; a hardware
+// timer interrupt takes one per sample and writes it to the pin. Nothing
+// but that write happens at the sample rate. The ring holds
+// PWM_AUDIO_RING_SIZE samples, about 185 ms at 22.05 kHz, so a late
+// service tick does not run it dry; if it does, the interrupt outputs
+// silence and counts an underrun.
+//
+// The player reports the DFPlayer's events (play finished, file missing),
+// so playlists work the same way on both backends. Single tracks play from
+// folder PWM_SINGLE_TRACK_FOLDER. EQ presets are ignored.
+const uint16_t PWM_AUDIO_RING_SIZE = 4096;
+const uint8_t PWM_SINGLE_TRACK_FOLDER = 1;
+
+#if defined(ENABLE_PWM_AUDIO) && !defined(ENABLE_ESP32_AUDIO)
+#error "ENABLE_PWM_AUDIO is part of the on-chip audio path, add -D ENABLE_ESP32_AUDIO"
+#endif
+
+#if defined(ENABLE_ESP32_AUDIO) && defined(ENABLE_PWM_AUDIO)
+bool pwmAudioBegin();
+// volume 0..30 like the DFPlayer, 2 dB a step; gain in quarter dB (TrackGain.h).
+// An MP3 can start near positionMs, at the last seek index point before it
+// (seek_cache.h), once the index reaches that far; until then, and for
+// WAV, it plays from the start.
+bool pwmPlayerPlay(uint8_t folder, uint8_t track, int volume, int8_t gain, uint32_t positionMs = 0);
+// Saves where an unfinished MP3 stopped (resume_position.h)
+void pwmPlayerStop();
+// Jumps within the playing MP3, to the last seek index point before positionMs
+void pwmPlayerSeek(uint32_t positionMs);
+void pwmPlayerSetVolume(int volume);
+void pwmPlayerService();
+// DFPlayer event type and value (DFPlayerPlayFinished, DFPlayerError)
+bool pwmPlayerNextEvent(uint8_t& type, uint16_t& value);
+void printPwmAudio();
+#else
+inline void pwmPlayerService() {}
+inline void printPwmAudio() { Serial.println("PWM audio needs -D ENABLE_ESP32_AUDIO -D ENABLE_PWM_AUDIO"); }
+inline void pwmPlayerSeek(uint32_t) { printPwmAudio(); }
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+// ==================== RESUME POSITIONS (optional) ====================
+// Part of the on-chip audio path (-D ENABLE_ESP32_AUDIO). Where each of the
+// last RESUME_POSITION_COUNT MP3s stopped part-way, by folder and track, so
+// an audiobook chapter carries on when its tag comes back. A track that
+// plays to the end is forgotten and starts from the beginning next time.
+// Kept in NVS as one record; like the tag library's, the write waits until
+// the positions have been quiet for a moment.
+#ifdef ENABLE_ESP32_AUDIO
+#include <stdint.h>
+
+const uint8_t RESUME_POSITION_COUNT = 16;
+
+void resumePositionBegin();
+// 0 for a track that has no saved position
+uint32_t resumePositionFor(uint8_t folder, uint8_t track);
+// The least recently stopped track makes room; positionMs 0 forgets the track.
+void resumePositionSave(uint8_t folder, uint8_t track, uint32_t positionMs);
+#endif
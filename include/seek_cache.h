@@ -0,0 +1,33 @@
+#pragma once
+
+// ==================== MP3 SEEK CACHE (optional) ====================
+// Part of the on-chip audio path (-D ENABLE_ESP32_AUDIO), where the ESP32
+// decodes files itself instead of handing track numbers to the DFPlayer.
+// Resume points come from an Mp3SeekIndex per track, cached on LittleFS as
+// /seek-<folder>-<track>.idx and checked against the file's size and first
+// cluster, so a replaced file is indexed again. The most recent index
+// stays in RAM.
+//
+// Building an index reads the whole file once (minutes for a long chapter
+// on an SPI SD card), so it is never done in one go: the player opens the
+// cache when a track starts, and seekCacheService() reads the next
+// SEEK_CACHE_CHUNK bytes on every service tick, through a file handle of
+// its own, while the track plays. Until the scan has got past a position,
+// the track cannot be resumed there.
+#ifdef ENABLE_ESP32_AUDIO
+#include <AudioCodec.h>
+#include <Mp3Seek.h>
+
+const size_t SEEK_CACHE_CHUNK = 2048;  // 4 sectors per 10 ms tick, ~5 min for 60 min at 128 kbit/s
+
+// Makes this track the current one: its index is loaded from flash, or
+// built from `file`, which must stay open until the index is done. stamp
+// tells two files of the same size apart (e.g. their first cluster).
+void seekCacheOpen(uint8_t folder, uint8_t track, uint32_t size, uint32_t stamp, AudioSource& file);
+void seekCacheService();
+// Where to start decoding the current track to play from positionMs: the
+// indexed frame at or before it, so at most one index interval early (a
+// second for a song, a few seconds for a long chapter) and no file access
+// at all. False while the index does not reach that far.
+bool seekCacheFind(uint32_t positionMs, Mp3SeekPoint& point);
+#endif
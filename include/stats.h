@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+#include <Histogram.h>
+#include <StatsDump.h>
+
+// ==================== USAGE & HEALTH COUNTERS ====================
+// Cheap counters updated from loop(). Telemetry and the console only ever
+// read copies of this struct, so recording never waits on anything.
+const uint8_t STATS_MAX_TAGS = 16;
+
+struct TagPlayCount {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  uint8_t track;
+  uint32_t plays;
+};
+
+struct Stats {
+  uint32_t tagDetections = 0;
+  uint32_t plays = 0;
+  uint32_t readFailures = 0;
+  uint32_t graceStops = 0;
+  TagPlayCount tags[STATS_MAX_TAGS] = {};
+  uint8_t tagCount = 0;
+  Histogram tagToPlayMicros;
+  Histogram pollLatenessMicros;  // NFC poll start vs. schedule
+};
+
+extern Stats stats;
+
+void statsRecordDetection();
+void statsRecordPlay(const uint8_t* uid, uint8_t uidLength, int track);
+void statsRecordReadFailure();
+void statsRecordGraceStop();
+void statsRecordTagToPlay(unsigned long elapsedMicros);
+void statsRecordPollLateness(unsigned long lateMicros);
+void printStats();
+// Binary snapshot for the fleet tool (tools/fleet_stats.cpp)
+size_t encodeStats(const Stats& snapshot, uint8_t* out, size_t capacity);
+void printStatsDump();
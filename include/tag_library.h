@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== TAG LIBRARY ====================
+// Tags the box has seen, plus optional on-device assignments. An assigned
+// track or playlist (DFPlayer folder) overrides whatever is written on the
+// tag, so tags can be re-programmed without touching them. Lookups go
+// through a UID hash index, so the reader can check for a binding before
+// it reads a single page. The price: volume and EQ presets written on a
+// bound tag are not read either, and the box's own volume applies.
+const uint8_t TAG_LIBRARY_SIZE = 32;
+
+struct TagEntry {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  uint8_t tagTrack;  // track written on the tag, 0 if unreadable
+  uint8_t track;     // assigned track, 0 if none
+  uint8_t folder;    // assigned playlist folder, 0 if none
+};
+
+void tagLibraryBegin();
+const TagEntry* tagLibraryFind(const uint8_t* uid, uint8_t uidLength);
+// Safe from the NFC task; copies the entry if it has an assignment.
+bool tagLibraryLookup(const uint8_t* uid, uint8_t uidLength, TagEntry& binding);
+void tagLibraryNoteSeen(const uint8_t* uid, uint8_t uidLength, int tagTrack);
+bool tagLibraryAssign(const uint8_t* uid, uint8_t uidLength, uint8_t track, uint8_t folder);
+uint8_t tagLibraryCount();
+const TagEntry& tagLibraryEntry(uint8_t index);
+void printTagLibrary();
+
+bool parseUid(const char* text, uint8_t* uid, uint8_t* uidLength);
@@ -0,0 +1,25 @@
+#pragma once
+#include <Arduino.h>
+#include <TagRecord.h>
+
+// ==================== TAG WRITER ====================
+// Reprogramming only touches pages that actually change: the current
+// contents come back in one FAST_READ, differing pages are written, and a
+// second FAST_READ verifies the result. Records go into the spare slot of
+// the dual-slot layout, which is safe even when the verify is skipped.
+const uint8_t TAG_WRITE_MAX_PAGES = 36;  // NTAG213 user memory, pages 4..39
+
+struct TagWriteResult {
+  bool ok = false;
+  bool verified = false;
+  uint8_t pageCount = 0;
+  uint8_t pagesWritten = 0;
+  unsigned long elapsedMicros = 0;  // read, writes and verify
+  unsigned long savedMicros = 0;    // page writes skipped, at the measured page write time
+};
+
+bool readTagPages(uint8_t firstPage, uint8_t pageCount, uint8_t* data);
+// current: what the pages hold now, if already read; nullptr reads them first
+TagWriteResult writeTagPages(uint8_t firstPage, const uint8_t* data, uint8_t pageCount,
+                             const uint8_t* current = nullptr, bool verify = true);
+TagWriteResult writeRecordSlot(const TagRecord& record, bool verify = true);
@@ -0,0 +1,19 @@
+#pragma once
+
+// ==================== MQTT TELEMETRY (optional) ====================
+// Build with -D ENABLE_TELEMETRY (see the *-telemetry env in platformio.ini).
+#ifndef MQTT_BROKER_HOST
+#define MQTT_BROKER_HOST ""
+#endif
+#ifndef MQTT_BROKER_PORT
+#define MQTT_BROKER_PORT 1883
+#endif
+#ifndef TELEMETRY_TOPIC_PREFIX
+#define TELEMETRY_TOPIC_PREFIX "avatarbox"
+#endif
+
+#ifdef ENABLE_TELEMETRY
+void telemetryBegin();
+#else
+inline void telemetryBegin() {}
+#endif
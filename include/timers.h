@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+#include <TimerWheel.h>
+
+// ==================== FIRMWARE TIMERS ====================
+// Every deadline in the firmware (polls, debounce, grace period, sleep
+// timer, deferred saves, ...) is a WheelTimer on this one wheel. loop()
+// fires whatever is due and then sleeps until the next deadline.
+extern TimerWheel timers;
+
+void timersBegin();
+void armTimer(WheelTimer& timer, unsigned long delayMs);
+void armTimerAt(WheelTimer& timer, unsigned long when);
+// For periodic timers, called from their own callback: keeps the original
+// phase, but skips periods that were missed entirely.
+void armPeriodic(WheelTimer& timer, unsigned long period);
+void runTimers();
+void sleepUntilNextTimer();
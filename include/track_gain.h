@@ -0,0 +1,17 @@
+#pragma once
+#include <Arduino.h>
+#include <TrackGain.h>
+
+// ==================== TRACK GAIN TABLE ====================
+// Loudness gains measured by tools/loudness_scan.cpp, kept in NVS and
+// looked up once per track start. The tool prints the whole table as a
+// single `gains <hex>` console line, so a library of a thousand tracks is
+// one paste; `gain <folder> <track> <dB>` corrects a single track.
+void trackGainBegin();
+// Quarter dB, 0 for tracks that were never measured
+int8_t trackGainFor(uint8_t folder, uint8_t track);
+bool trackGainSet(uint8_t folder, uint8_t track, float db);
+// Replaces the table with an encoded one ("AMTG", see TrackGain.h) in hex
+bool trackGainLoad(const String& hex);
+void trackGainClear();
+void printTrackGains();
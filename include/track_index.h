@@ -0,0 +1,23 @@
+#pragma once
+
+// ==================== TRACK INDEX (optional) ====================
+// Part of the on-chip audio path (-D ENABLE_ESP32_AUDIO). Resolving
+// "folder 12 / track 87" through the SD library means scanning two FAT
+// directories on every play, which gets slow and uneven with thousands of
+// files. The index maps (folder, track) to first cluster and size and is
+// kept on LittleFS as /tracks.idx. At boot an index for the card's volume
+// serial is used straight away, while trackIndexService() works out the
+// directory checksum (see TrackScan.h) a few sectors per tick; only a
+// changed checksum rebuilds it, in the same slices. Checking costs one
+// pass over the directories, never the files.
+#ifdef ENABLE_ESP32_AUDIO
+#include <SD.h>
+#include <FatVolume.h>
+
+bool trackIndexBegin(fs::SDFS& sd);
+// Call every service tick
+void trackIndexService();
+// No directory access: a binary search in the index file, then the file's
+// own cluster chain as it is read.
+bool trackIndexOpen(uint8_t folder, uint8_t track, FatFile& file);
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+#define FIRMWARE_VERSION "1.0"
@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== LED VISUALISER (optional) ====================
+// Part of the on-chip audio path (-D ENABLE_ESP32_AUDIO plus
+// -D ENABLE_VISUALIZER). The audio path hands every decoded block to
+// visualizerAudio(); band levels from lib/Spectrum then set the status
+// LED's brightness through LEDC, or colour a WS2812 strip through RMT when
+// VISUALIZER_STRIP_PIN is defined (VISUALIZER_STRIP_LEDS pixels, bass
+// first).
+//
+// Each block gets VISUALIZER_BUDGET_US. An analysis step only starts if
+// the slowest recent step still fits in what is left, so the
+// visualiser can never push the audio path past its deadline; a window
+// that does not finish in time is dropped. `visualizer` prints the counts.
+const uint32_t VISUALIZER_BUDGET_US = 200;
+
+#if defined(ENABLE_ESP32_AUDIO) && defined(ENABLE_VISUALIZER)
+void visualizerBegin();
+void visualizerAudio(const int16_t* pcm, size_t frames, uint8_t channels, uint32_t sampleRate);
+// The LED belongs to the visualiser: off, or on and following the music.
+// Returns false when the LED is a plain GPIO.
+bool visualizerSetLed(bool on);
+void printVisualizer();
+#else
+inline void visualizerBegin() {}
+inline void visualizerAudio(const int16_t*, size_t, uint8_t, uint32_t) {}
+inline bool visualizerSetLed(bool) { return false; }
+inline void printVisualizer() { Serial.println("Visualiser needs -D ENABLE_ESP32_AUDIO -D ENABLE_VISUALIZER"); }
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+// ==================== LOCAL WEB UI (optional) ====================
+// Build with -D ENABLE_WEB_UI (see the *-webui env in platformio.ini).
+#ifdef ENABLE_WEB_UI
+void webUiBegin();
+void webUiLoop();
+#else
+inline void webUiBegin() {}
+inline void webUiLoop() {}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+
+// ==================== WEB UI PAGE ====================
+// The single page served at "/". It fetches /api/stats and /api/tags and
+// posts assignments back; web_ui.cpp streams it in WEB_CHUNK_SIZE pieces.
+static const char INDEX_HTML[] PROGMEM = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width">
+<title>Avatar Music Box</title>
+<style>body{font-family:sans-serif;margin:1em}td,th{padding:4px 8px;text-align:left}</style>
+</head><body><h2>🎵 Avatar Music Box</h2>
+<p id="stats"></p>
+<table><thead><tr><th>UID</th><th>On tag</th><th>Assigned</th><th>Plays</th></tr></thead>
+<tbody id="tags"></tbody></table>
+<h3>Assign</h3>
+<form id="f">UID <input name="uid" size="20">
+<select name="kind"><option value="track">Track</option><option value="folder">Playlist folder</option></select>
+<input name="num" type="number" min="0" max="99" style="width:4em">
+<button>Save</button></form>
+<script>
+async function load(){
+ const s=await (await fetch('/api/stats')).json();
+ document.getElementById('stats').textContent=`Up ${s.up}s · ${s.plays} plays · ${s.rf} read failures · tag-to-play p50 ${s.lat.p50}µs p99 ${s.lat.p99}µs`;
+ const t=await (await fetch('/api/tags')).json();
+ document.getElementById('tags').innerHTML=t.map(e=>`<tr><td>${e.uid}</td><td>${e.tag||'-'}</td><td>${e.folder?'folder '+e.folder:(e.track||'-')}</td><td>${e.plays}</td></tr>`).join('');
+}
+document.getElementById('f').onsubmit=async ev=>{
+ ev.preventDefault();const f=new FormData(ev.target);
+ await fetch(`/api/tags?uid=${f.get('uid')}&${f.get('kind')}=${f.get('num')}`,{method:'POST'});load();
+};
+load();
+</script></body></html>
+)HTML";
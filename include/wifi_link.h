@@ -0,0 +1,30 @@
+#pragma once
+
+// Wi-Fi is only brought up when a feature that needs it is compiled in.
+#if defined(ENABLE_TELEMETRY) || defined(ENABLE_WEB_UI)
+#define USE_WIFI
+#endif
+
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+// Access point used by the web UI when no WIFI_SSID is configured.
+#ifndef WIFI_AP_SSID
+#define WIFI_AP_SSID "AvatarMusicBox"
+#endif
+#ifndef WIFI_AP_PASSWORD
+#define WIFI_AP_PASSWORD ""
+#endif
+
+#ifdef USE_WIFI
+#include <Arduino.h>
+
+void wifiLinkBegin();
+bool wifiLinkConnected();
+String wifiLinkDeviceId();
+#else
+inline void wifiLinkBegin() {}
+#endif
@@ -0,0 +1,80 @@
+#include "AudioCodec.h"
+#include <string.h>
+#include "Mp3Decoder.h"
+#include "WavDecoder.h"
+
+size_t MemorySource::read(uint8_t* out, size_t length) {
+  if (length > size - offset) length = size - offset;
+  memcpy(out, data + offset, length);
+  offset += length;
+  return length;
+}
+
+bool MemorySource::seek(uint32_t position) {
+  if (position > size) return false;
+  offset = position;
+  return true;
+}
+
+// WAV by the format tag of its "fmt " chunk, found by the same chunk walk
+// the decoders use; MP3 by an ID3v2 tag or a Layer III frame sync at the
+// very start.
+AudioCodecType detectAudioCodec(AudioSource& source) {
+  uint8_t bytes[AUDIO_DETECT_BYTES];
+  if (!source.seek(0)) return AUDIO_CODEC_UNKNOWN;
+  size_t length = source.read(bytes, sizeof(bytes));
+  if (length >= 12 && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WAVE", 4) == 0) {
+    WavInfo info;
+    if (!readWavInfo(source, info)) return AUDIO_CODEC_UNKNOWN;
+    if (info.format == WAV_FORMAT_PCM) return AUDIO_CODEC_PCM;
+    if (info.format == WAV_FORMAT_IMA_ADPCM) return AUDIO_CODEC_IMA_ADPCM;
+    return AUDIO_CODEC_UNKNOWN;
+  }
+  if (length >= 3 && memcmp(bytes, "ID3", 3) == 0) return AUDIO_CODEC_MP3;
+  if (length >= 2 && bytes[0] == 0xFF && (bytes[1] & 0xE6) == 0xE2) return AUDIO_CODEC_MP3;
+  return AUDIO_CODEC_UNKNOWN;
+}
+
+const char* audioCodecName(AudioCodecType type) {
+  switch (type) {
+    case AUDIO_CODEC_PCM: return "PCM";
+    case AUDIO_CODEC_IMA_ADPCM: return "IMA ADPCM";
+    case AUDIO_CODEC_MP3: return "MP3";
+    default: return "unknown";
+  }
+}
+
+static PcmWavDecoder pcmDecoder;
+static ImaWavDecoder imaDecoder;
+#ifdef ENABLE_MP3_CODEC
+static Mp3Decoder mp3Decoder;
+#endif
+
+AudioDecoder* openAudioDecoder(AudioSource& source, AudioCodecType* type) {
+  AudioCodecType codec = detectAudioCodec(source);
+  if (type) *type = codec;
+  if (!source.seek(0)) return nullptr;
+  AudioDecoder* decoder = nullptr;
+  if (codec == AUDIO_CODEC_PCM) decoder = &pcmDecoder;
+  else if (codec == AUDIO_CODEC_IMA_ADPCM) decoder = &imaDecoder;
+#ifdef ENABLE_MP3_CODEC
+  else if (codec == AUDIO_CODEC_MP3) decoder = &mp3Decoder;
+#endif
+  return decoder && decoder->begin(source) ? decoder : nullptr;
+}
+
+bool benchmarkDecode(AudioSource& source, uint64_t (*cycleCounter)(), DecodeBenchmark& result) {
+  result = DecodeBenchmark();
+  AudioDecoder* decoder = openAudioDecoder(source, &result.codec);
+  if (!decoder) return false;
+  result.sampleRate = decoder->sampleRate();
+  static int16_t pcm[AUDIO_BLOCK_MAX_FRAMES * AUDIO_MAX_CHANNELS];
+  for (;;) {
+    uint64_t start = cycleCounter();
+    size_t frames = decoder->decode(pcm);
+    result.cycles += cycleCounter() - start;
+    if (frames == 0) break;
+    result.frames += frames;
+  }
+  return result.frames > 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== AUDIO CODECS ====================
+// Decoders for the on-chip audio path, picked by the first bytes of the
+// file: PCM WAV costs nothing to decode, IMA ADPCM WAV a little, MP3 a
+// lot (tools/codec_bench.cpp and the `codecs` command put numbers on it).
+// tools/audio_convert.cpp turns a PCM library into IMA ADPCM.
+//
+// Every decoder hands out one block per call, at most AUDIO_BLOCK_MAX_FRAMES
+// frames of interleaved 16-bit PCM, mono or stereo.
+const uint16_t AUDIO_BLOCK_MAX_FRAMES = 1152;  // one MPEG-1 Layer III frame
+const uint8_t AUDIO_MAX_CHANNELS = 2;
+const uint8_t AUDIO_DETECT_BYTES = 32;
+
+class AudioSource {
+ public:
+  virtual ~AudioSource() {}
+  virtual size_t read(uint8_t* data, size_t length) = 0;
+  virtual bool seek(uint32_t offset) = 0;
+};
+
+class MemorySource : public AudioSource {
+ public:
+  MemorySource(const uint8_t* data, size_t size) : data(data), size(size) {}
+  size_t read(uint8_t* out, size_t length) override;
+  bool seek(uint32_t offset) override;
+
+ private:
+  const uint8_t* data;
+  size_t size;
+  size_t offset = 0;
+};
+
+class AudioDecoder {
+ public:
+  virtual ~AudioDecoder() {}
+  // Reads the stream header; false if the stream is not this format or
+  // uses a variant the decoder does not handle.
+  virtual bool begin(AudioSource& source) = 0;
+  // pcm holds AUDIO_BLOCK_MAX_FRAMES × channels samples. Returns frames,
+  // 0 at the end of the stream.
+  virtual size_t decode(int16_t* pcm) = 0;
+  // Carries on decoding at offset, the first byte of a frame (Mp3Seek.h).
+  // False for formats that cannot jump.
+  virtual bool seekTo(uint32_t) { return false; }
+  uint32_t sampleRate() const { return rate; }
+  uint8_t channels() const { return channelCount; }
+
+ protected:
+  AudioSource* source = nullptr;
+  uint32_t rate = 0;
+  uint8_t channelCount = 0;
+};
+
+enum AudioCodecType : uint8_t {
+  AUDIO_CODEC_UNKNOWN,
+  AUDIO_CODEC_PCM,
+  AUDIO_CODEC_IMA_ADPCM,
+  AUDIO_CODEC_MP3,
+};
+
+// From the first AUDIO_DETECT_BYTES of the source, and for WAV its chunks.
+// Leaves the source anywhere.
+AudioCodecType detectAudioCodec(AudioSource& source);
+const char* audioCodecName(AudioCodecType type);
+// Detects the format and starts the matching decoder, rewinding the source
+// first. Decoders are static, one per format: the result stays valid until
+// the next call for the same format. nullptr if nothing can play it (MP3
+// needs ENABLE_MP3_CODEC, see Mp3Decoder.h).
+AudioDecoder* openAudioDecoder(AudioSource& source, AudioCodecType* type = nullptr);
+
+struct DecodeBenchmark {
+  AudioCodecType codec = AUDIO_CODEC_UNKNOWN;
+  uint32_t frames = 0;
+  uint32_t sampleRate = 0;
+  uint64_t cycles = 0;
+  // Per second of audio, the figure that decides whether a codec fits
+  uint64_t cyclesPerAudioSecond() const { return frames ? cycles * sampleRate / frames : 0; }
+};
+
+// Decodes the whole stream, reading cycleCounter (ESP.getCycleCount() on
+// the device, the TSC on a PC) around each block, so only decoding is timed.
+bool benchmarkDecode(AudioSource& source, uint64_t (*cycleCounter)(), DecodeBenchmark& result);
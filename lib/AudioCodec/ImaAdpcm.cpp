@@ -0,0 +1,102 @@
+#include "ImaAdpcm.h"
+
+const int8_t INDEX_TABLE[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+const uint16_t STEP_TABLE[89] = {
+  7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+  31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+  130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+  544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+  2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+  9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+int16_t imaDecodeSample(ImaState& state, uint8_t nibble) {
+  int step = STEP_TABLE[state.index];
+  int diff = step >> 3;
+  if (nibble & 4) diff += step;
+  if (nibble & 2) diff += step >> 1;
+  if (nibble & 1) diff += step >> 2;
+  int predictor = state.predictor + (nibble & 8 ? -diff : diff);
+  if (predictor > 32767) predictor = 32767;
+  if (predictor < -32768) predictor = -32768;
+  int index = state.index + INDEX_TABLE[nibble & 0x0F];
+  state.index = index < 0 ? 0 : index > 88 ? 88 : index;
+  state.predictor = predictor;
+  return predictor;
+}
+
+// Picks the nibble whose decoded value is closest, then runs the decoder so
+// encoder and decoder state never drift apart.
+uint8_t imaEncodeSample(ImaState& state, int16_t sample) {
+  int step = STEP_TABLE[state.index];
+  int diff = sample - state.predictor;
+  uint8_t nibble = 0;
+  if (diff < 0) {
+    nibble = 8;
+    diff = -diff;
+  }
+  if (diff >= step) {
+    nibble |= 4;
+    diff -= step;
+  }
+  if (diff >= step >> 1) {
+    nibble |= 2;
+    diff -= step >> 1;
+  }
+  if (diff >= step >> 2) nibble |= 1;
+  imaDecodeSample(state, nibble);
+  return nibble;
+}
+
+uint16_t imaSamplesPerBlock(uint16_t blockAlign, uint8_t channels) {
+  return (blockAlign - 4 * channels) * 2 / channels + 1;
+}
+
+size_t imaEncodeBlock(const int16_t* pcm, uint8_t channels, uint16_t blockAlign, ImaState* states,
+                      uint8_t* block) {
+  uint16_t frames = imaSamplesPerBlock(blockAlign, channels);
+  uint8_t* out = block;
+  for (uint8_t c = 0; c < channels; c++) {
+    states[c].predictor = pcm[c];
+    *out++ = (uint16_t)states[c].predictor;
+    *out++ = (uint16_t)states[c].predictor >> 8;
+    *out++ = states[c].index;
+    *out++ = 0;
+  }
+  for (uint16_t group = 1; group < frames; group += 8) {
+    for (uint8_t c = 0; c < channels; c++) {
+      for (uint8_t i = 0; i < 8; i += 2) {
+        uint8_t low = imaEncodeSample(states[c], pcm[(group + i) * channels + c]);
+        uint8_t high = imaEncodeSample(states[c], pcm[(group + i + 1) * channels + c]);
+        *out++ = low | high << 4;
+      }
+    }
+  }
+  return out - block;
+}
+
+size_t imaDecodeBlock(const uint8_t* block, size_t length, uint8_t channels, int16_t* pcm) {
+  if (channels == 0 || channels > 2 || length < 4u * channels) return 0;
+  ImaState states[2];
+  for (uint8_t c = 0; c < channels; c++) {
+    states[c].predictor = (int16_t)(block[4 * c] | block[4 * c + 1] << 8);
+    states[c].index = block[4 * c + 2] > 88 ? 88 : block[4 * c + 2];
+    pcm[c] = states[c].predictor;
+  }
+  const uint8_t* in = block + 4 * channels;
+  size_t groups = (length - 4 * channels) / (4 * channels);
+  for (size_t group = 0; group < groups; group++) {
+    for (uint8_t c = 0; c < channels; c++) {
+      int16_t* out = pcm + (1 + group * 8) * channels + c;
+      for (uint8_t i = 0; i < 4; i++) {
+        uint8_t byte = *in++;
+        *out = imaDecodeSample(states[c], byte & 0x0F);
+        out += channels;
+        *out = imaDecodeSample(states[c], byte >> 4);
+        out += channels;
+      }
+    }
+  }
+  return 1 + groups * 8;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== IMA ADPCM ====================
+// 4 bits per sample, decoded with a table lookup, a few adds and a clamp
+// per sample: no multiplies, so it costs the C3's FPU-less core a small
+// fraction of what MP3 does, at a quarter of the size of 16-bit PCM.
+//
+// WAV block layout (format tag 0x11): per channel a 4-byte header
+// <first sample s16> <step index> <0>, then 4-byte words of 8 samples of
+// one channel, channels interleaved word by word, low nibble first.
+struct ImaState {
+  int16_t predictor = 0;
+  uint8_t index = 0;
+};
+
+uint8_t imaEncodeSample(ImaState& state, int16_t sample);
+int16_t imaDecodeSample(ImaState& state, uint8_t nibble);
+
+uint16_t imaSamplesPerBlock(uint16_t blockAlign, uint8_t channels);
+// pcm: interleaved, imaSamplesPerBlock() frames; states carry each
+// channel's step index from block to block. Returns the block size.
+size_t imaEncodeBlock(const int16_t* pcm, uint8_t channels, uint16_t blockAlign, ImaState* states,
+                      uint8_t* block);
+// A short final block decodes to fewer frames. Returns frames written.
+size_t imaDecodeBlock(const uint8_t* block, size_t length, uint8_t channels, int16_t* pcm);
@@ -0,0 +1,85 @@
+#ifdef ENABLE_MP3_CODEC
+#include "Mp3Decoder.h"
+#include <string.h>
+
+// Moves what is left to the front and tops the buffer up, so a whole frame
+// (at most MAINBUF_SIZE bytes) is always in view.
+bool Mp3Decoder::refill() {
+  memmove(input, next, available);
+  next = input;
+  if (!endOfFile) {
+    size_t got = source->read(input + available, sizeof(input) - available);
+    if (got == 0) endOfFile = true;
+    available += got;
+  }
+  return available > 0;
+}
+
+// The stream is parsed up to the first frame header for its format. A
+// leading ID3v2 tag is skipped with a seek instead of being read.
+bool Mp3Decoder::begin(AudioSource& stream) {
+  source = &stream;
+  if (!helix) helix = MP3InitDecoder();
+  if (!helix) return false;
+  next = input;
+  available = 0;
+  endOfFile = false;
+
+  uint8_t id3[10];
+  uint32_t start = 0;
+  if (stream.read(id3, sizeof(id3)) == sizeof(id3) && memcmp(id3, "ID3", 3) == 0) {
+    start = 10 + ((uint32_t)(id3[6] & 0x7F) << 21 | (uint32_t)(id3[7] & 0x7F) << 14 | (id3[8] & 0x7F) << 7 |
+                  (id3[9] & 0x7F)) + (id3[5] & 0x10 ? 10 : 0);
+  }
+  if (!stream.seek(start) || !refill()) return false;
+  int offset = MP3FindSyncWord(next, available);
+  if (offset < 0) return false;
+  next += offset;
+  available -= offset;
+  MP3FrameInfo frame;
+  if (MP3GetNextFrameInfo(helix, &frame, next) != ERR_MP3_NONE) return false;
+  rate = frame.samprate;
+  channelCount = frame.nChans;
+  return channelCount >= 1 && channelCount <= AUDIO_MAX_CHANNELS;
+}
+
+// Underflows are normal: the first frames after a seek point back into a
+// bit reservoir that was never read, and a frame can straddle a refill.
+size_t Mp3Decoder::decode(int16_t* pcm) {
+  for (;;) {
+    if (available < MAINBUF_SIZE && !endOfFile) refill();
+    if (available <= 0) return 0;
+    int offset = MP3FindSyncWord(next, available);
+    if (offset < 0) {
+      available = 0;
+      if (endOfFile) return 0;
+      continue;
+    }
+    next += offset;
+    available -= offset;
+    int result = MP3Decode(helix, &next, &available, pcm, 0);
+    if (result == ERR_MP3_NONE) {
+      MP3FrameInfo frame;
+      MP3GetLastFrameInfo(helix, &frame);
+      if (frame.nChans == channelCount) return frame.outputSamps / frame.nChans;
+    } else if (result == ERR_MP3_INDATA_UNDERFLOW) {
+      if (endOfFile) return 0;
+      refill();
+    } else if (result != ERR_MP3_MAINDATA_UNDERFLOW) {
+      // Corrupt frame: step over its sync word and look for the next one
+      next++;
+      available--;
+    }
+  }
+}
+
+// The frames after the jump start with a bit reservoir from before it;
+// decode() drops them until the reservoir has refilled.
+bool Mp3Decoder::seekTo(uint32_t offset) {
+  if (!source->seek(offset)) return false;
+  next = input;
+  available = 0;
+  endOfFile = false;
+  return refill();
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+#include "AudioCodec.h"
+
+// ==================== MP3 ====================
+// Fixed-point Helix decoder, built with -D ENABLE_MP3_CODEC and the
+// pschatzmann/arduino-libhelix library (or its sources on a PC). It needs
+// about 30 KB of heap for decoder state and most of a C3's core at 44.1 kHz
+// stereo, which is why the converter exists.
+#ifdef ENABLE_MP3_CODEC
+#include <libhelix-mp3/mp3dec.h>
+
+class Mp3Decoder : public AudioDecoder {
+ public:
+  bool begin(AudioSource& source) override;
+  size_t decode(int16_t* pcm) override;
+  bool seekTo(uint32_t offset) override;
+
+ private:
+  bool refill();
+
+  HMP3Decoder helix = nullptr;
+  uint8_t input[2 * MAINBUF_SIZE];
+  uint8_t* next = input;  // unread input starts here
+  int available = 0;
+  bool endOfFile = false;
+};
+#endif
@@ -0,0 +1,147 @@
+#include "WavDecoder.h"
+#include <string.h>
+
+static uint16_t get16(const uint8_t* in) { return in[0] | in[1] << 8; }
+
+static uint32_t get32(const uint8_t* in) {
+  return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static void put16(uint8_t* out, uint16_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+}
+
+static void put32(uint8_t* out, uint32_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+  out[2] = v >> 16;
+  out[3] = v >> 24;
+}
+
+bool readWavInfo(AudioSource& source, WavInfo& info) {
+  info = WavInfo();
+  uint8_t header[20];
+  if (!source.seek(0) || source.read(header, 12) != 12) return false;
+  if (memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) return false;
+  // Every chunk must end inside the RIFF chunk, so the walk can neither wrap
+  // nor run on past the end of a corrupt file; 64 bits keep the sums exact
+  // and offsets stay within what seek() takes
+  uint64_t riffEnd = 8 + (uint64_t)get32(header + 4);
+  if (riffEnd > UINT32_MAX) riffEnd = UINT32_MAX;
+  uint64_t offset = 12;
+  bool haveFormat = false;
+  for (;;) {
+    if (offset + 8 > riffEnd) return false;  // no data chunk
+    if (!source.seek(offset) || source.read(header, 8) != 8) return false;
+    uint32_t size = get32(header + 4);
+    if (size > riffEnd - offset - 8) return false;
+    if (memcmp(header, "fmt ", 4) == 0 && size >= 16) {
+      if (source.read(header, 16) != 16) return false;
+      info.format = get16(header);
+      info.channels = get16(header + 2);
+      info.sampleRate = get32(header + 4);
+      info.blockAlign = get16(header + 12);
+      info.bitsPerSample = get16(header + 14);
+      haveFormat = true;
+    } else if (memcmp(header, "fact", 4) == 0 && size >= 4) {
+      if (source.read(header, 4) != 4) return false;
+      info.frames = get32(header);
+    } else if (memcmp(header, "data", 4) == 0) {
+      info.dataOffset = offset + 8;
+      info.dataSize = size;
+      break;
+    }
+    offset += 8 + (uint64_t)size + (size & 1);  // chunks are word aligned
+  }
+  if (!haveFormat || info.channels == 0 || info.channels > AUDIO_MAX_CHANNELS || info.blockAlign == 0) return false;
+  if (info.format == WAV_FORMAT_PCM) info.frames = info.dataSize / info.blockAlign;
+  return source.seek(info.dataOffset);
+}
+
+size_t writeWavPcmHeader(uint8_t* out, uint32_t sampleRate, uint8_t channels, uint32_t dataSize) {
+  memcpy(out, "RIFF", 4);
+  put32(out + 4, WAV_PCM_HEADER_SIZE - 8 + dataSize);
+  memcpy(out + 8, "WAVEfmt ", 8);
+  put32(out + 16, 16);
+  put16(out + 20, WAV_FORMAT_PCM);
+  put16(out + 22, channels);
+  put32(out + 24, sampleRate);
+  put32(out + 28, sampleRate * channels * 2);
+  put16(out + 32, channels * 2);
+  put16(out + 34, 16);
+  memcpy(out + 36, "data", 4);
+  put32(out + 40, dataSize);
+  return WAV_PCM_HEADER_SIZE;
+}
+
+size_t writeWavImaHeader(uint8_t* out, uint32_t sampleRate, uint8_t channels, uint16_t blockAlign,
+                         uint32_t frames, uint32_t dataSize) {
+  uint16_t samplesPerBlock = imaSamplesPerBlock(blockAlign, channels);
+  memcpy(out, "RIFF", 4);
+  put32(out + 4, WAV_IMA_HEADER_SIZE - 8 + dataSize);
+  memcpy(out + 8, "WAVEfmt ", 8);
+  put32(out + 16, 20);
+  put16(out + 20, WAV_FORMAT_IMA_ADPCM);
+  put16(out + 22, channels);
+  put32(out + 24, sampleRate);
+  put32(out + 28, (uint64_t)sampleRate * blockAlign / samplesPerBlock);
+  put16(out + 32, blockAlign);
+  put16(out + 34, 4);
+  put16(out + 36, 2);  // extension size
+  put16(out + 38, samplesPerBlock);
+  memcpy(out + 40, "fact", 4);
+  put32(out + 44, 4);
+  put32(out + 48, frames);
+  memcpy(out + 52, "data", 4);
+  put32(out + 56, dataSize);
+  return WAV_IMA_HEADER_SIZE;
+}
+
+bool PcmWavDecoder::begin(AudioSource& stream) {
+  source = &stream;
+  if (!readWavInfo(stream, info) || info.format != WAV_FORMAT_PCM) return false;
+  if (info.bitsPerSample != 8 && info.bitsPerSample != 16) return false;
+  rate = info.sampleRate;
+  channelCount = info.channels;
+  remaining = info.dataSize;
+  return true;
+}
+
+// 16-bit samples are read straight into the output; 8-bit ones are
+// unsigned and widened in place from the back.
+size_t PcmWavDecoder::decode(int16_t* pcm) {
+  uint32_t bytes = (uint32_t)AUDIO_BLOCK_MAX_FRAMES * info.blockAlign;
+  if (bytes > remaining) bytes = remaining - remaining % info.blockAlign;
+  size_t got = source->read((uint8_t*)pcm, bytes);
+  remaining -= got;
+  size_t samples = got * 8 / info.bitsPerSample;
+  if (info.bitsPerSample == 8) {
+    const uint8_t* in = (const uint8_t*)pcm;
+    for (size_t i = samples; i-- > 0;) pcm[i] = (int16_t)((in[i] - 128) * 256);
+  }
+  return samples / channelCount;
+}
+
+bool ImaWavDecoder::begin(AudioSource& stream) {
+  source = &stream;
+  if (!readWavInfo(stream, info) || info.format != WAV_FORMAT_IMA_ADPCM || info.bitsPerSample != 4) return false;
+  if (info.blockAlign > MAX_BLOCK_ALIGN || info.blockAlign <= 4 * info.channels) return false;
+  uint16_t samplesPerBlock = imaSamplesPerBlock(info.blockAlign, info.channels);
+  if (samplesPerBlock > AUDIO_BLOCK_MAX_FRAMES) return false;
+  rate = info.sampleRate;
+  channelCount = info.channels;
+  remaining = info.dataSize;
+  framesRemaining = info.frames ? info.frames : UINT32_MAX;
+  return true;
+}
+
+size_t ImaWavDecoder::decode(int16_t* pcm) {
+  uint32_t bytes = remaining < info.blockAlign ? remaining : info.blockAlign;
+  size_t got = source->read(block, bytes);
+  remaining -= got;
+  size_t frames = imaDecodeBlock(block, got, channelCount, pcm);
+  if (frames > framesRemaining) frames = framesRemaining;
+  framesRemaining -= frames;
+  return frames;
+}
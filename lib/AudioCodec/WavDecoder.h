@@ -0,0 +1,51 @@
+#pragma once
+#include "AudioCodec.h"
+#include "ImaAdpcm.h"
+
+// ==================== WAV ====================
+// RIFF WAVE with 8/16-bit PCM (format tag 1) or IMA ADPCM (0x11). Chunks
+// other than "fmt ", "fact" and "data" are skipped wherever they are.
+const uint16_t WAV_FORMAT_PCM = 1;
+const uint16_t WAV_FORMAT_IMA_ADPCM = 0x11;
+const size_t WAV_PCM_HEADER_SIZE = 44;
+const size_t WAV_IMA_HEADER_SIZE = 60;  // with the 2-byte fmt extension and a fact chunk
+
+struct WavInfo {
+  uint16_t format = 0;
+  uint8_t channels = 0;
+  uint32_t sampleRate = 0;
+  uint16_t blockAlign = 0;
+  uint16_t bitsPerSample = 0;
+  uint32_t frames = 0;  // from the fact chunk, or derived for PCM
+  uint32_t dataOffset = 0;
+  uint32_t dataSize = 0;
+};
+
+bool readWavInfo(AudioSource& source, WavInfo& info);
+// Header for a file whose data chunk is dataSize bytes; returns its size
+size_t writeWavPcmHeader(uint8_t* out, uint32_t sampleRate, uint8_t channels, uint32_t dataSize);
+size_t writeWavImaHeader(uint8_t* out, uint32_t sampleRate, uint8_t channels, uint16_t blockAlign,
+                         uint32_t frames, uint32_t dataSize);
+
+class PcmWavDecoder : public AudioDecoder {
+ public:
+  bool begin(AudioSource& source) override;
+  size_t decode(int16_t* pcm) override;
+
+ private:
+  WavInfo info;
+  uint32_t remaining = 0;  // data bytes
+};
+
+class ImaWavDecoder : public AudioDecoder {
+ public:
+  bool begin(AudioSource& source) override;
+  size_t decode(int16_t* pcm) override;
+
+ private:
+  static const uint16_t MAX_BLOCK_ALIGN = 2048;
+  WavInfo info;
+  uint32_t remaining = 0;        // data bytes
+  uint32_t framesRemaining = 0;  // the last block is padded
+  uint8_t block[MAX_BLOCK_ALIGN];
+};
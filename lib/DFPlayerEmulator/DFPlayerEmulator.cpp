@@ -0,0 +1,334 @@
+#include "DFPlayerEmulator.h"
+#include <DFPlayerFrame.h>
+#include <string.h>
+
+const uint8_t CMD_VOLUME_UP = 0x04;
+const uint8_t CMD_VOLUME_DOWN = 0x05;
+const uint8_t CMD_OUTPUT_DEVICE = 0x09;
+const uint8_t CMD_SLEEP = 0x0A;
+const uint8_t CMD_WAKE = 0x0B;
+const uint8_t CMD_RESET = 0x0C;
+const uint8_t CMD_START = 0x0D;
+const uint8_t CMD_PAUSE = 0x0E;
+const uint8_t CMD_PLAY_MP3_FOLDER = 0x12;
+const uint8_t CMD_PLAY_LARGE_FOLDER = 0x14;
+const uint8_t CMD_STOP = 0x16;
+const uint8_t CMD_QUERY_STATUS = 0x42;
+const uint8_t CMD_QUERY_VOLUME = 0x43;
+const uint8_t CMD_QUERY_EQ = 0x44;
+const uint8_t CMD_QUERY_SD_FILES = 0x48;
+const uint8_t CMD_QUERY_SD_TRACK = 0x4C;
+const uint8_t CMD_QUERY_FOLDER_FILES = 0x4E;
+
+const uint8_t REPLY_PLAY_FINISHED = 0x3D;
+const uint8_t REPLY_ONLINE = 0x3F;
+const uint8_t REPLY_ERROR = 0x40;
+const uint8_t REPLY_ACK = 0x41;
+
+const uint16_t DEVICE_SD = 0x02;
+const uint16_t ERROR_SLEEPING = 0x02;
+const uint16_t ERROR_FILE_MISMATCH = 0x06;
+const uint8_t MAX_VOLUME = 30;
+const uint8_t MAX_EQ = 5;
+const uint8_t OUTPUT_BYTES = DFPLAYER_EMULATOR_OUTPUT_FRAMES * DFPLAYER_FRAME_SIZE;
+
+static bool reached(uint32_t now, uint32_t when) { return (int32_t)(now - when) >= 0; }
+static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+static uint32_t later(uint32_t a, uint32_t b) { return (int32_t)(a - b) >= 0 ? a : b; }
+
+void DFPlayerEmulator::reset() {
+  DFPlayerLatencies keepLatencies = latencies;
+  uint16_t keepTracks[DFPLAYER_EMULATOR_FOLDERS];
+  memcpy(keepTracks, trackCounts, sizeof(keepTracks));
+  *this = DFPlayerEmulator();
+  latencies = keepLatencies;
+  memcpy(trackCounts, keepTracks, sizeof(keepTracks));
+}
+
+void DFPlayerEmulator::setTrackCount(uint8_t folderNumber, uint16_t count) {
+  if (folderNumber < DFPLAYER_EMULATOR_FOLDERS) trackCounts[folderNumber] = count;
+}
+
+const DFPlayerAudioEvent& DFPlayerEmulator::audioEvent(uint8_t index) const {
+  return audioLog[(logHead + index) % DFPLAYER_EMULATOR_LOG_SIZE];
+}
+
+bool DFPlayerEmulator::playing(uint32_t now) {
+  run(now);
+  return audio;
+}
+
+bool DFPlayerEmulator::sleeping(uint32_t now) {
+  run(now);
+  return asleep;
+}
+
+void DFPlayerEmulator::receive(uint8_t c, uint32_t at) {
+  if (rxIndex == 0 && c != 0x7E) return;  // line noise between frames
+  rxFrame[rxIndex++] = c;
+  if (rxIndex < DFPLAYER_FRAME_SIZE) return;
+  rxIndex = 0;
+  uint8_t command;
+  uint16_t parameter;
+  if (!decodeDFPlayerFrame(rxFrame, &command, &parameter)) {
+    stats.badFrames++;
+    return;
+  }
+  // Host bytes arrive in order, so nothing can change the module's state
+  // before this frame is in: the FIFO is checked as it is at `at`.
+  run(at);
+  if (inputCount == DFPLAYER_EMULATOR_INPUT_FRAMES) {
+    stats.droppedFrames++;
+    return;
+  }
+  stats.frames++;
+  Frame& frame = input[(inputHead + inputCount++) % DFPLAYER_EMULATOR_INPUT_FRAMES];
+  frame.at = at;
+  frame.command = command;
+  frame.ack = rxFrame[4] != 0;
+  frame.parameter = parameter;
+}
+
+int DFPlayerEmulator::send(uint32_t now) {
+  run(now);
+  if (outputCount == 0 || !reached(now, output[outputHead].at)) return -1;
+  uint8_t value = output[outputHead].value;
+  outputHead = (outputHead + 1) % OUTPUT_BYTES;
+  outputCount--;
+  return value;
+}
+
+// Events are handled in time order: a track running out, the processor
+// finishing a long command, then the next frame, which waits while the
+// processor is busy.
+void DFPlayerEmulator::run(uint32_t now) {
+  if (!reached(now, simulatedTo)) return;
+  for (;;) {
+    enum { NONE, TRACK_END, COMPLETION, FRAME } next = NONE;
+    uint32_t at = now;
+    if (audio && reached(now, endAt)) {
+      next = TRACK_END;
+      at = endAt;
+    }
+    if (completion != COMPLETE_NONE && reached(now, busyUntil) && (next == NONE || before(busyUntil, at))) {
+      next = COMPLETION;
+      at = busyUntil;
+    }
+    uint32_t frameAt = inputCount ? later(input[inputHead].at, busyUntil) : 0;
+    if (inputCount && completion == COMPLETE_NONE && reached(now, frameAt) &&
+        (next == NONE || before(frameAt, at))) {
+      next = FRAME;
+      at = frameAt;
+    }
+
+    if (next == NONE) break;
+    if (next == TRACK_END) {
+      finishTrack();
+    } else if (next == COMPLETION) {
+      complete(at);
+    } else {
+      Frame frame = input[inputHead];
+      inputHead = (inputHead + 1) % DFPLAYER_EMULATOR_INPUT_FRAMES;
+      inputCount--;
+      process(frame, at);
+    }
+  }
+  simulatedTo = now;
+}
+
+void DFPlayerEmulator::process(const Frame& frame, uint32_t at) {
+  uint32_t done = at + latencies.commandMicros;
+  busyUntil = done;
+  if (frame.ack) {
+    transmit(REPLY_ACK, 0, done);
+    stats.acks++;
+  }
+  if (asleep && frame.command != CMD_WAKE && frame.command != CMD_OUTPUT_DEVICE && frame.command != CMD_RESET) {
+    transmit(REPLY_ERROR, ERROR_SLEEPING, done);
+    stats.errors++;
+    return;
+  }
+
+  uint16_t parameter = frame.parameter;
+  switch (frame.command) {
+    case DFPLAYER_CMD_PLAY:
+    case CMD_PLAY_MP3_FOLDER:
+      seek(0, parameter, frame.at, done);
+      return;
+    case DFPLAYER_CMD_PLAY_FOLDER:
+      seek(parameter >> 8, parameter & 0xFF, frame.at, done);
+      return;
+    case CMD_PLAY_LARGE_FOLDER:
+      seek(parameter >> 12, parameter & 0x0FFF, frame.at, done);
+      return;
+    case DFPLAYER_CMD_VOLUME:
+      currentVolume = parameter > MAX_VOLUME ? MAX_VOLUME : parameter;
+      return;
+    case CMD_VOLUME_UP:
+      if (currentVolume < MAX_VOLUME) currentVolume++;
+      return;
+    case CMD_VOLUME_DOWN:
+      if (currentVolume > 0) currentVolume--;
+      return;
+    case DFPLAYER_CMD_EQ:
+      if (parameter <= MAX_EQ) currentEq = parameter;
+      return;
+    case CMD_OUTPUT_DEVICE:
+    case CMD_WAKE:
+      // Selecting the card again is the other way out of sleep
+      if (asleep) {
+        completion = COMPLETE_WAKE;
+        busyUntil = done + latencies.wakeMicros;
+      }
+      return;
+    case CMD_SLEEP:
+      stopAudio(done, frame.at, DFPLAYER_AUDIO_STOPPED);
+      paused = false;
+      asleep = true;
+      return;
+    case CMD_RESET:
+      stopAudio(done, frame.at, DFPLAYER_AUDIO_STOPPED);
+      paused = false;
+      asleep = false;
+      currentVolume = MAX_VOLUME;
+      currentEq = 0;
+      completion = COMPLETE_ONLINE;
+      busyUntil = done + latencies.resetMicros;
+      return;
+    case CMD_START:
+      if (!paused) return;
+      paused = false;
+      audio = true;
+      endAt = done + remaining;
+      audioCommandAt = frame.at;
+      logAudio(done, frame.at, DFPLAYER_AUDIO_STARTED);
+      return;
+    case CMD_PAUSE:
+      if (!audio || reached(done, endAt)) {
+        stopAudio(done, frame.at, DFPLAYER_AUDIO_STOPPED);
+        return;
+      }
+      remaining = endAt - done;
+      stopAudio(done, frame.at, DFPLAYER_AUDIO_STOPPED);
+      paused = true;
+      return;
+    case CMD_STOP:
+      stopAudio(done, frame.at, DFPLAYER_AUDIO_STOPPED);
+      paused = false;
+      return;
+    case CMD_QUERY_STATUS:
+      transmit(CMD_QUERY_STATUS, DEVICE_SD << 8 | statusCode(), done);
+      return;
+    case CMD_QUERY_VOLUME:
+      transmit(CMD_QUERY_VOLUME, currentVolume, done);
+      return;
+    case CMD_QUERY_EQ:
+      transmit(CMD_QUERY_EQ, currentEq, done);
+      return;
+    case CMD_QUERY_SD_FILES: {
+      uint16_t total = 0;
+      for (uint16_t count : trackCounts) total += count;
+      transmit(CMD_QUERY_SD_FILES, total, done);
+      return;
+    }
+    case CMD_QUERY_SD_TRACK:
+      transmit(CMD_QUERY_SD_TRACK, track, done);
+      return;
+    case CMD_QUERY_FOLDER_FILES:
+      transmit(CMD_QUERY_FOLDER_FILES, parameter < DFPLAYER_EMULATOR_FOLDERS ? trackCounts[parameter] : 0, done);
+      return;
+    default:
+      return;  // accepted and ignored
+  }
+}
+
+// The old track stops as soon as the command is taken; the new one starts
+// once the file is found and its first frame decoded. A missing file takes
+// the same search before the error comes back.
+void DFPlayerEmulator::seek(uint8_t folderNumber, uint16_t trackNumber, uint32_t commandAt, uint32_t done) {
+  stopAudio(done, commandAt, DFPLAYER_AUDIO_STOPPED);
+  paused = false;
+  folder = folderNumber;
+  track = trackNumber;
+  bool exists = folderNumber < DFPLAYER_EMULATOR_FOLDERS && trackNumber >= 1 && trackNumber <= trackCounts[folderNumber];
+  completion = exists ? COMPLETE_AUDIO_START : COMPLETE_FILE_ERROR;
+  completionCommandAt = commandAt;
+  busyUntil = done + latencies.seekMicros + (folderNumber ? latencies.folderSeekMicros : 0);
+}
+
+void DFPlayerEmulator::complete(uint32_t at) {
+  switch (completion) {
+    case COMPLETE_AUDIO_START:
+      audio = true;
+      endAt = at + latencies.trackMicros;
+      audioCommandAt = completionCommandAt;
+      logAudio(at, completionCommandAt, DFPLAYER_AUDIO_STARTED);
+      break;
+    case COMPLETE_FILE_ERROR:
+      transmit(REPLY_ERROR, ERROR_FILE_MISMATCH, at);
+      stats.errors++;
+      break;
+    case COMPLETE_ONLINE:
+      transmit(REPLY_ONLINE, DEVICE_SD, at);
+      break;
+    case COMPLETE_WAKE:
+      asleep = false;
+      break;
+    case COMPLETE_NONE:
+      break;
+  }
+  completion = COMPLETE_NONE;
+}
+
+void DFPlayerEmulator::finishTrack() {
+  audio = false;
+  logAudio(endAt, audioCommandAt, DFPLAYER_AUDIO_FINISHED);
+  transmit(REPLY_PLAY_FINISHED, track, endAt);
+  transmit(REPLY_PLAY_FINISHED, track, endAt);
+}
+
+// A command takes effect when it is done; the track may have run out by then
+void DFPlayerEmulator::stopAudio(uint32_t at, uint32_t commandAt, DFPlayerAudioChange change) {
+  if (!audio) return;
+  if (reached(at, endAt)) {
+    finishTrack();
+    return;
+  }
+  audio = false;
+  logAudio(at, commandAt, change);
+}
+
+void DFPlayerEmulator::logAudio(uint32_t at, uint32_t commandAt, DFPlayerAudioChange change) {
+  if (logCount == DFPLAYER_EMULATOR_LOG_SIZE) {
+    logHead = (logHead + 1) % DFPLAYER_EMULATOR_LOG_SIZE;
+    logCount--;
+  }
+  DFPlayerAudioEvent& e = audioLog[(logHead + logCount++) % DFPLAYER_EMULATOR_LOG_SIZE];
+  e.at = at;
+  e.commandAt = commandAt;
+  e.change = change;
+  e.folder = folder;
+  e.track = track;
+}
+
+// Frames leave back to back at 9600 baud, whoever queued them
+void DFPlayerEmulator::transmit(uint8_t command, uint16_t parameter, uint32_t at) {
+  if (outputCount + DFPLAYER_FRAME_SIZE > OUTPUT_BYTES) {
+    stats.outputOverflows++;
+    return;
+  }
+  uint8_t frame[DFPLAYER_FRAME_SIZE];
+  encodeDFPlayerFrame(command, parameter, false, frame);
+  uint32_t start = later(at, txFreeAt);
+  for (uint8_t i = 0; i < DFPLAYER_FRAME_SIZE; i++) {
+    OutputByte& out = output[(outputHead + outputCount++) % OUTPUT_BYTES];
+    out.at = start + (i + 1) * DFPLAYER_EMULATOR_CHARACTER_MICROS;
+    out.value = frame[i];
+  }
+  txFreeAt = start + DFPLAYER_FRAME_SIZE * DFPLAYER_EMULATOR_CHARACTER_MICROS;
+}
+
+uint8_t DFPlayerEmulator::statusCode() const {
+  if (audio) return 1;
+  return paused ? 2 : 0;
+}
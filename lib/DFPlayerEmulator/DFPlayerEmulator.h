@@ -0,0 +1,150 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== DFPLAYER SERIAL EMULATOR ====================
+// The DFPlayer Mini as the host sees it on its UART, for host tests of the
+// DFRobotDFPlayerMini library and of the firmware's own frame bursts.
+// Bytes come in with the time their stop bit ended. Complete 10-byte
+// frames wait in a small input FIFO and are processed one after another;
+// each keeps the module busy for a while, and frames that find the FIFO
+// full are lost. A play command then seeks on the SD card before the first
+// sample reaches the speaker. That moment, and every moment audio stops,
+// goes into an audio log, so a test measures what the listener hears
+// rather than when a library call returned.
+//
+// Answers are real frames, paced at 9600 baud: the ACK (41) for frames
+// that ask for one, "card online" (3F) once a reset is done, "play
+// finished" (3D) at the end of a track, twice as the module sends it,
+// errors (40) for missing files and for commands sent to a sleeping
+// module, and the status, volume, EQ and file count queries.
+//
+// Like the PN532 emulator it knows nothing about Arduino: every call takes
+// the current time in microseconds, and the module is simulated up to that
+// time on demand.
+const uint8_t DFPLAYER_EMULATOR_INPUT_FRAMES = 4;
+const uint8_t DFPLAYER_EMULATOR_OUTPUT_FRAMES = 8;
+const uint8_t DFPLAYER_EMULATOR_LOG_SIZE = 32;
+const uint8_t DFPLAYER_EMULATOR_FOLDERS = 100;  // 0 is the root, 01..99 are playlist folders
+const uint32_t DFPLAYER_EMULATOR_CHARACTER_MICROS = 1042;  // 9600 baud 8N1
+
+// Rough, assumed figures for an MH2024K-based module with a class 10 card,
+// not measurements; test_hardware times the real thing
+struct DFPlayerLatencies {
+  uint32_t commandMicros = 20000;      // frame in, command done and ACK sent
+  uint32_t seekMicros = 150000;        // play command done, first sample out
+  uint32_t folderSeekMicros = 30000;   // on top of that for a folder track
+  uint32_t resetMicros = 1200000;      // reset to "card online": card mount and file count
+  uint32_t wakeMicros = 250000;        // out of sleep: the card is initialised again
+  uint32_t trackMicros = 180000000;    // length of every track
+};
+
+struct DFPlayerEmulatorStats {
+  uint32_t frames = 0;         // valid frames received
+  uint32_t droppedFrames = 0;  // arrived with the input FIFO full
+  uint32_t badFrames = 0;      // framing or checksum errors
+  uint32_t acks = 0;
+  uint32_t errors = 0;         // 40 frames sent
+  uint32_t outputOverflows = 0;
+};
+
+enum DFPlayerAudioChange : uint8_t {
+  DFPLAYER_AUDIO_STARTED,
+  DFPLAYER_AUDIO_FINISHED,  // the track ran out
+  DFPLAYER_AUDIO_STOPPED,   // stop, pause, another play, sleep or reset
+};
+
+struct DFPlayerAudioEvent {
+  uint32_t at;         // when the speaker started or went quiet
+  uint32_t commandAt;  // when the frame behind it had arrived; a finished track's is its play frame
+  DFPlayerAudioChange change;
+  uint8_t folder;      // 0 for a root track
+  uint16_t track;
+};
+
+class DFPlayerEmulator {
+ public:
+  DFPlayerLatencies latencies;
+  DFPlayerEmulatorStats stats;
+
+  // Power-on state: awake, idle, volume 30, no files
+  void reset();
+
+  // Files on the card: tracks 1..count in the root or in folder 01..99
+  void setTrackCount(uint8_t folder, uint16_t count);
+
+  // One byte from the host, complete at `at`
+  void receive(uint8_t c, uint32_t at);
+  // The next byte sent by `now`, or -1
+  int send(uint32_t now);
+
+  bool playing(uint32_t now);
+  bool sleeping(uint32_t now);
+  uint8_t volume() const { return currentVolume; }
+  uint8_t eq() const { return currentEq; }
+
+  // Oldest first
+  uint8_t audioEvents() const { return logCount; }
+  const DFPlayerAudioEvent& audioEvent(uint8_t index) const;
+  void clearAudioLog() { logCount = 0; }
+
+ private:
+  enum Completion : uint8_t { COMPLETE_NONE, COMPLETE_AUDIO_START, COMPLETE_FILE_ERROR, COMPLETE_ONLINE, COMPLETE_WAKE };
+
+  struct Frame {
+    uint32_t at;
+    uint8_t command;
+    bool ack;
+    uint16_t parameter;
+  };
+
+  void run(uint32_t now);
+  void process(const Frame& frame, uint32_t at);
+  void complete(uint32_t at);
+  void seek(uint8_t folder, uint16_t track, uint32_t commandAt, uint32_t done);
+  void finishTrack();
+  void stopAudio(uint32_t at, uint32_t commandAt, DFPlayerAudioChange change);
+  void logAudio(uint32_t at, uint32_t commandAt, DFPlayerAudioChange change);
+  void transmit(uint8_t command, uint16_t parameter, uint32_t at);
+  uint8_t statusCode() const;
+
+  // Card contents
+  uint16_t trackCounts[DFPLAYER_EMULATOR_FOLDERS] = {0};
+
+  // Receiver and input FIFO
+  uint8_t rxFrame[10];
+  uint8_t rxIndex = 0;
+  Frame input[DFPLAYER_EMULATOR_INPUT_FRAMES];
+  uint8_t inputHead = 0;
+  uint8_t inputCount = 0;
+
+  // Module state, simulated up to simulatedTo
+  uint32_t simulatedTo = 0;
+  uint32_t busyUntil = 0;
+  Completion completion = COMPLETE_NONE;
+  uint32_t completionCommandAt = 0;
+  bool asleep = false;
+  bool audio = false;    // the speaker is playing
+  bool paused = false;
+  uint8_t folder = 0;
+  uint16_t track = 0;
+  uint32_t audioCommandAt = 0;
+  uint32_t endAt = 0;
+  uint32_t remaining = 0;  // of a paused track
+  uint8_t currentVolume = 30;
+  uint8_t currentEq = 0;
+
+  // Transmitter: bytes with the time their stop bit ends
+  struct OutputByte {
+    uint32_t at;
+    uint8_t value;
+  };
+  OutputByte output[DFPLAYER_EMULATOR_OUTPUT_FRAMES * 10];
+  uint8_t outputHead = 0;
+  uint8_t outputCount = 0;
+  uint32_t txFreeAt = 0;
+
+  DFPlayerAudioEvent audioLog[DFPLAYER_EMULATOR_LOG_SIZE];
+  uint8_t logHead = 0;
+  uint8_t logCount = 0;
+};
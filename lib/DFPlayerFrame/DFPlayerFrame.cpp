@@ -0,0 +1,30 @@
+#include "DFPlayerFrame.h"
+
+static uint16_t frameChecksum(const uint8_t* frame) {
+  uint16_t sum = 0;
+  for (uint8_t i = 1; i < 7; i++) sum += frame[i];
+  return -sum;
+}
+
+void encodeDFPlayerFrame(uint8_t command, uint16_t parameter, bool requestAck, uint8_t* frame) {
+  frame[0] = 0x7E;
+  frame[1] = 0xFF;
+  frame[2] = 0x06;
+  frame[3] = command;
+  frame[4] = requestAck ? 0x01 : 0x00;
+  frame[5] = parameter >> 8;
+  frame[6] = parameter & 0xFF;
+  uint16_t checksum = frameChecksum(frame);
+  frame[7] = checksum >> 8;
+  frame[8] = checksum & 0xFF;
+  frame[9] = 0xEF;
+}
+
+bool decodeDFPlayerFrame(const uint8_t* frame, uint8_t* command, uint16_t* parameter) {
+  if (frame[0] != 0x7E || frame[1] != 0xFF || frame[2] != 0x06 || frame[9] != 0xEF) return false;
+  uint16_t checksum = frameChecksum(frame);
+  if (frame[7] != (checksum >> 8) || frame[8] != (checksum & 0xFF)) return false;
+  *command = frame[3];
+  *parameter = (frame[5] << 8) | frame[6];
+  return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== DFPLAYER SERIAL FRAMES ====================
+// 7E FF 06 <cmd> <ack> <param hi> <param lo> <checksum hi> <checksum lo> EF
+const uint8_t DFPLAYER_FRAME_SIZE = 10;
+
+const uint8_t DFPLAYER_CMD_PLAY = 0x03;
+const uint8_t DFPLAYER_CMD_VOLUME = 0x06;
+const uint8_t DFPLAYER_CMD_EQ = 0x07;
+const uint8_t DFPLAYER_CMD_PLAY_FOLDER = 0x0F;
+
+void encodeDFPlayerFrame(uint8_t command, uint16_t parameter, bool requestAck, uint8_t* frame);
+bool decodeDFPlayerFrame(const uint8_t* frame, uint8_t* command, uint16_t* parameter);
@@ -0,0 +1,129 @@
+#include "FatVolume.h"
+#include <string.h>
+
+static uint16_t get16(const uint8_t* in) { return in[0] | in[1] << 8; }
+
+static uint32_t get32(const uint8_t* in) {
+  return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+// A FAT32 boot sector: 512-byte sectors, no FAT16 root directory or FAT size
+static bool isFat32BootSector(const uint8_t* boot) {
+  if (get16(boot + 510) != 0xAA55) return false;
+  if (boot[0] != 0xEB && boot[0] != 0xE9) return false;
+  return get16(boot + 11) == FAT_SECTOR_SIZE && boot[13] != 0 && get16(boot + 17) == 0 &&
+         get16(boot + 22) == 0 && get32(boot + 36) != 0;
+}
+
+bool FatVolume::mount(FatSectorReader sectorReader, void* context) {
+  reader = sectorReader;
+  readerContext = context;
+  cachedFatSector = UINT32_MAX;
+  if (!readSector(0, sector)) return false;
+  uint32_t partitionStart = 0;
+  if (!isFat32BootSector(sector)) {
+    if (get16(sector + 510) != 0xAA55) return false;
+    partitionStart = get32(sector + 446 + 8);  // first partition entry, LBA start
+    if (partitionStart == 0 || !readSector(partitionStart, sector) || !isFat32BootSector(sector)) return false;
+  }
+  sectorsPerCluster = sector[13];
+  uint16_t reservedSectors = get16(sector + 14);
+  uint8_t fatCount = sector[16];
+  uint32_t fatSize = get32(sector + 36);
+  uint32_t totalSectors = get32(sector + 32);
+  root = get32(sector + 44);
+  volumeSerial = get32(sector + 67);
+  fatStart = partitionStart + reservedSectors;
+  dataStart = fatStart + fatCount * fatSize;
+  clusterCount = (totalSectors - (dataStart - partitionStart)) / sectorsPerCluster;
+  return root >= 2 && root < clusterCount + 2;
+}
+
+uint32_t FatVolume::nextCluster(uint32_t cluster) {
+  uint32_t fatSectorNumber = fatStart + cluster / (FAT_SECTOR_SIZE / 4);
+  if (fatSectorNumber != cachedFatSector) {
+    if (!readSector(fatSectorNumber, fatSector)) return 0;
+    cachedFatSector = fatSectorNumber;
+  }
+  uint32_t next = get32(fatSector + cluster % (FAT_SECTOR_SIZE / 4) * 4) & 0x0FFFFFFF;
+  return next >= 2 && next < clusterCount + 2 ? next : 0;
+}
+
+bool FatVolume::forEachEntry(uint32_t firstCluster, EntryVisitor visit, void* context) {
+  FatDirCursor cursor = openDirectory(firstCluster);
+  while (cursor.cluster != 0) {
+    if (!readDirectorySector(cursor, visit, context)) return false;
+  }
+  return true;
+}
+
+bool FatVolume::readDirectorySector(FatDirCursor& cursor, EntryVisitor visit, void* context) {
+  if (cursor.cluster == 0) return true;
+  if (!readSector(clusterSector(cursor.cluster) + cursor.sector, sector)) return false;
+  uint16_t i = 0;
+  for (; i < FAT_SECTOR_SIZE; i += 32) {
+    const uint8_t* raw = sector + i;
+    if (raw[0] == 0x00) break;  // no entries after this one, nor in later sectors
+    uint8_t attributes = raw[11];
+    if (raw[0] == 0xE5 || (attributes & 0x0F) == 0x0F || (attributes & 0x08)) continue;
+    FatDirEntry entry;
+    memcpy(entry.name, raw, sizeof(entry.name));
+    entry.attributes = attributes;
+    entry.firstCluster = (uint32_t)get16(raw + 20) << 16 | get16(raw + 26);
+    entry.size = get32(raw + 28);
+    if (!visit(entry, context)) break;
+  }
+  if (i < FAT_SECTOR_SIZE) {
+    cursor.cluster = 0;
+  } else if (++cursor.sector == sectorsPerCluster) {
+    cursor.cluster = nextCluster(cursor.cluster);
+    cursor.sector = 0;
+  }
+  return true;
+}
+
+void FatFile::open(FatVolume& fatVolume, uint32_t first, uint32_t size) {
+  volume = &fatVolume;
+  firstCluster = first;
+  fileSize = size;
+  offset = 0;
+  cluster = first;
+  clusterStart = 0;
+  bufferedSector = UINT32_MAX;
+}
+
+bool FatFile::seek(uint32_t position) {
+  if (!volume || position > fileSize) return false;
+  if (position < clusterStart) {
+    cluster = firstCluster;
+    clusterStart = 0;
+  }
+  offset = position;
+  return true;
+}
+
+size_t FatFile::read(uint8_t* data, size_t length) {
+  if (!volume) return 0;
+  uint32_t clusterBytes = volume->clusterBytes();
+  size_t done = 0;
+  while (done < length && offset < fileSize) {
+    while (offset - clusterStart >= clusterBytes) {
+      cluster = volume->nextCluster(cluster);
+      if (cluster == 0) return done;
+      clusterStart += clusterBytes;
+    }
+    uint32_t sectorNumber = volume->clusterSector(cluster) + (offset - clusterStart) / FAT_SECTOR_SIZE;
+    if (sectorNumber != bufferedSector) {
+      if (!volume->readSector(sectorNumber, buffer)) return done;
+      bufferedSector = sectorNumber;
+    }
+    uint16_t inSector = offset % FAT_SECTOR_SIZE;
+    size_t n = FAT_SECTOR_SIZE - inSector;
+    if (n > length - done) n = length - done;
+    if (n > fileSize - offset) n = fileSize - offset;
+    memcpy(data + done, buffer + inSector, n);
+    done += n;
+    offset += n;
+  }
+  return done;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== RAW FAT32 ACCESS ====================
+// Just enough FAT32 to list directories and read files by their first
+// cluster, on top of raw 512-byte sector reads. Opening a file this way is
+// a cluster-chain walk; no directory is searched by name. Long file names
+// are ignored: the DFPlayer layout (folders "01".."99", files starting
+// with a three-digit track number) only needs the 8.3 names.
+const uint16_t FAT_SECTOR_SIZE = 512;
+
+// Reads one sector into data; context is passed through.
+typedef bool (*FatSectorReader)(uint32_t sector, uint8_t* data, void* context);
+
+struct FatDirEntry {
+  char name[11];  // 8.3, space padded, no dot
+  uint8_t attributes;
+  uint32_t firstCluster;
+  uint32_t size;
+};
+
+const uint8_t FAT_ATTR_DIRECTORY = 0x10;
+
+// Where a directory listing stands, for reading it a sector at a time
+struct FatDirCursor {
+  uint32_t cluster;  // 0 once the listing is finished
+  uint8_t sector;    // within the cluster
+};
+
+class FatVolume {
+ public:
+  // Superfloppy or the first MBR partition. FAT32 only: every SD card
+  // above 2 GB is formatted that way.
+  bool mount(FatSectorReader reader, void* context);
+  uint32_t serial() const { return volumeSerial; }
+  uint32_t rootCluster() const { return root; }
+  uint32_t clusterBytes() const { return sectorsPerCluster * FAT_SECTOR_SIZE; }
+
+  // Calls visit for every live entry of the directory, stopping early when
+  // it returns false. Deleted entries, long-name parts and the volume label
+  // are skipped.
+  typedef bool (*EntryVisitor)(const FatDirEntry& entry, void* context);
+  bool forEachEntry(uint32_t firstCluster, EntryVisitor visit, void* context);
+  // The same, one sector per call: visits that sector's entries and moves
+  // the cursor on. False on a read error.
+  static FatDirCursor openDirectory(uint32_t firstCluster) { return {firstCluster, 0}; }
+  bool readDirectorySector(FatDirCursor& cursor, EntryVisitor visit, void* context);
+
+  // 0 at the end of the chain or on a read error
+  uint32_t nextCluster(uint32_t cluster);
+  uint32_t clusterSector(uint32_t cluster) const { return dataStart + (cluster - 2) * sectorsPerCluster; }
+  bool readSector(uint32_t sector, uint8_t* data) { return reader(sector, data, readerContext); }
+  uint8_t clusterSectors() const { return sectorsPerCluster; }
+
+ private:
+  FatSectorReader reader = nullptr;
+  void* readerContext = nullptr;
+  uint32_t fatStart = 0;
+  uint32_t dataStart = 0;
+  uint32_t root = 0;
+  uint32_t clusterCount = 0;
+  uint32_t volumeSerial = 0;
+  uint8_t sectorsPerCluster = 0;
+  uint32_t cachedFatSector = UINT32_MAX;
+  uint8_t fatSector[FAT_SECTOR_SIZE];
+  uint8_t sector[FAT_SECTOR_SIZE];
+};
+
+// A file opened by first cluster and size, e.g. from a track index
+class FatFile {
+ public:
+  void open(FatVolume& volume, uint32_t firstCluster, uint32_t size);
+  size_t read(uint8_t* data, size_t length);
+  // Backwards seeks restart at the first cluster; the chain is walked on
+  // the next read, one FAT lookup per cluster skipped.
+  bool seek(uint32_t offset);
+  uint32_t position() const { return offset; }
+  uint32_t size() const { return fileSize; }
+  uint32_t startCluster() const { return firstCluster; }
+
+ private:
+  FatVolume* volume = nullptr;
+  uint32_t firstCluster = 0;
+  uint32_t fileSize = 0;
+  uint32_t offset = 0;
+  uint32_t cluster = 0;       // the chain is followed lazily, so this may
+  uint32_t clusterStart = 0;  // start before offset by several clusters
+  uint32_t bufferedSector = UINT32_MAX;
+  uint8_t buffer[FAT_SECTOR_SIZE];
+};
@@ -0,0 +1,110 @@
+#include "TrackScan.h"
+#include <string.h>
+
+struct ScanState {
+  FatVolume* volume;
+  TrackVisitor found;
+  void* context;
+  TrackScanStatus status;
+  uint8_t folder;  // 0 while listing the root
+  FatDirCursor cursor;
+  uint32_t checksum;
+  uint32_t folders[TRACK_SCAN_MAX_FOLDER + 1];  // first cluster, 0 if absent
+  struct {
+    uint32_t firstCluster;
+    uint32_t size;
+  } tracks[256];  // firstCluster 0 if absent
+};
+
+static ScanState scan;
+
+// FNV-1a, continued across entries
+static void hashBytes(const void* data, size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < length; i++) scan.checksum = (scan.checksum ^ bytes[i]) * 16777619u;
+}
+
+static void hashEntry(const FatDirEntry& entry) {
+  hashBytes(entry.name, sizeof(entry.name));
+  hashBytes(&entry.attributes, 1);
+  hashBytes(&entry.firstCluster, 4);
+  hashBytes(&entry.size, 4);
+}
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+static bool visitRoot(const FatDirEntry& entry, void*) {
+  hashEntry(entry);
+  if (!(entry.attributes & FAT_ATTR_DIRECTORY) || !isDigit(entry.name[0]) || !isDigit(entry.name[1])) return true;
+  for (uint8_t i = 2; i < sizeof(entry.name); i++) {
+    if (entry.name[i] != ' ') return true;
+  }
+  uint8_t folder = (entry.name[0] - '0') * 10 + entry.name[1] - '0';
+  if (folder >= 1 && scan.folders[folder] == 0) scan.folders[folder] = entry.firstCluster;
+  return true;
+}
+
+static bool visitFolder(const FatDirEntry& entry, void*) {
+  hashEntry(entry);
+  if (entry.attributes & FAT_ATTR_DIRECTORY || entry.firstCluster == 0) return true;
+  if (!isDigit(entry.name[0]) || !isDigit(entry.name[1]) || !isDigit(entry.name[2])) return true;
+  const char* extension = entry.name + 8;
+  if (memcmp(extension, "MP3", 3) != 0 && memcmp(extension, "WAV", 3) != 0) return true;
+  int track = (entry.name[0] - '0') * 100 + (entry.name[1] - '0') * 10 + entry.name[2] - '0';
+  if (track < 1 || track > 255 || scan.tracks[track].firstCluster != 0) return true;
+  scan.tracks[track].firstCluster = entry.firstCluster;
+  scan.tracks[track].size = entry.size;
+  return true;
+}
+
+// Reports the finished folder's tracks, then opens the next folder
+static void nextFolder() {
+  if (scan.folder != 0 && scan.found) {
+    for (uint16_t track = 1; track <= 255; track++) {
+      if (scan.tracks[track].firstCluster == 0) continue;
+      scan.found({scan.folder, (uint8_t)track, scan.tracks[track].firstCluster, scan.tracks[track].size}, scan.context);
+    }
+  }
+  do {
+    if (scan.folder == TRACK_SCAN_MAX_FOLDER) {
+      scan.status = TRACK_SCAN_DONE;
+      return;
+    }
+    scan.folder++;
+  } while (scan.folders[scan.folder] == 0);
+  memset(scan.tracks, 0, sizeof(scan.tracks));
+  hashBytes(&scan.folder, 1);
+  scan.cursor = FatVolume::openDirectory(scan.folders[scan.folder]);
+}
+
+void trackScanBegin(FatVolume& volume, TrackVisitor found, void* context) {
+  scan.volume = &volume;
+  scan.found = found;
+  scan.context = context;
+  scan.status = TRACK_SCAN_RUNNING;
+  scan.folder = 0;
+  scan.cursor = FatVolume::openDirectory(volume.rootCluster());
+  scan.checksum = 2166136261u;
+  memset(scan.folders, 0, sizeof(scan.folders));
+}
+
+TrackScanStatus trackScanStep(uint16_t sectors) {
+  for (; sectors > 0 && scan.status == TRACK_SCAN_RUNNING; sectors--) {
+    if (!scan.volume->readDirectorySector(scan.cursor, scan.folder == 0 ? visitRoot : visitFolder, nullptr)) {
+      scan.status = TRACK_SCAN_FAILED;
+    } else if (scan.cursor.cluster == 0) {
+      nextFolder();
+    }
+  }
+  return scan.status;
+}
+
+uint32_t trackScanChecksum() { return scan.checksum; }
+
+bool scanTrackFolders(FatVolume& volume, TrackVisitor found, void* context, uint32_t& checksum) {
+  trackScanBegin(volume, found, context);
+  TrackScanStatus status = TRACK_SCAN_RUNNING;
+  while (status == TRACK_SCAN_RUNNING) status = trackScanStep(UINT16_MAX);
+  checksum = scan.checksum;
+  return status == TRACK_SCAN_DONE;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "FatVolume.h"
+
+// ==================== DFPLAYER FOLDER LAYOUT ====================
+// The layout the DFPlayer's play-folder command expects: folders "01".."99"
+// in the root, each holding files whose 8.3 names start with a track
+// number "001".."255", ending in .MP3 or .WAV.
+const uint8_t TRACK_SCAN_MAX_FOLDER = 99;
+
+struct TrackLocation {
+  uint8_t folder;
+  uint8_t track;
+  uint32_t firstCluster;
+  uint32_t size;
+};
+
+typedef void (*TrackVisitor)(const TrackLocation& location, void* context);
+
+// Calls found (if not null) for every track, ordered by folder, then track;
+// of two files with the same number the first in the directory wins. The
+// checksum covers name, attributes, cluster and size of every entry in the
+// root and the track folders, so any copy, rename or delete changes it.
+// Not reentrant.
+bool scanTrackFolders(FatVolume& volume, TrackVisitor found, void* context, uint32_t& checksum);
+
+// The same scan in slices, so it can run in the background: each step
+// reads at most the given number of directory sectors. It shares its state
+// with scanTrackFolders, so only one scan of either kind runs at a time.
+enum TrackScanStatus : uint8_t { TRACK_SCAN_RUNNING, TRACK_SCAN_DONE, TRACK_SCAN_FAILED };
+
+void trackScanBegin(FatVolume& volume, TrackVisitor found, void* context);
+TrackScanStatus trackScanStep(uint16_t sectors);
+// Valid once the scan is done
+uint32_t trackScanChecksum();
@@ -0,0 +1,64 @@
+#include "Histogram.h"
+
+uint16_t Histogram::bucketIndex(uint32_t value) {
+  if (value < SUB_BUCKETS) return value;
+  uint8_t msb = 31 - __builtin_clz(value);
+  uint8_t shift = msb - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint32_t Histogram::bucketLowerBound(uint16_t index) {
+  if (index < SUB_BUCKETS) return index;
+  uint8_t shift = index / SUB_BUCKETS - 1;
+  uint32_t sub = index % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << shift;
+}
+
+uint32_t Histogram::bucketUpperBound(uint16_t index) {
+  if (index + 1 >= BUCKET_COUNT) return 0xFFFFFFFF;
+  return bucketLowerBound(index + 1) - 1;
+}
+
+void Histogram::record(uint32_t value) {
+  buckets[bucketIndex(value)]++;
+  total++;
+  if (value > maximum) maximum = value;
+}
+
+void Histogram::addToBucket(uint16_t index, uint32_t n) {
+  if (index >= BUCKET_COUNT || n == 0) return;
+  buckets[index] += n;
+  total += n;
+  uint32_t upper = bucketUpperBound(index);
+  if (upper > maximum) maximum = upper;
+}
+
+void Histogram::merge(const Histogram& other) {
+  for (uint16_t i = 0; i < BUCKET_COUNT; i++) buckets[i] += other.buckets[i];
+  total += other.total;
+  if (other.maximum > maximum) maximum = other.maximum;
+}
+
+void Histogram::reset() {
+  for (uint16_t i = 0; i < BUCKET_COUNT; i++) buckets[i] = 0;
+  total = 0;
+  maximum = 0;
+}
+
+// Upper bound of the bucket holding the p-th percentile, clamped to the
+// largest value seen so p100 reports the true maximum.
+uint32_t Histogram::percentile(float p) const {
+  if (total == 0) return 0;
+  uint32_t target = (uint32_t)(p / 100.0f * total + 0.5f);
+  if (target < 1) target = 1;
+  if (target > total) target = total;
+  uint32_t seen = 0;
+  for (uint16_t i = 0; i < BUCKET_COUNT; i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      uint32_t upper = bucketUpperBound(i);
+      return upper < maximum ? upper : maximum;
+    }
+  }
+  return maximum;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Log-linear (HDR-style) histogram for latencies and other unsigned values.
+// Every power of two is split into 8 linear sub-buckets, so a reported value
+// is within 12.5% of the true one. Fixed size, no heap, and two histograms
+// merge by adding their buckets, which lets boxes and host tools combine them.
+class Histogram {
+ public:
+  static const uint8_t SUB_BUCKET_BITS = 3;
+  static const uint8_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static const uint16_t BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  void record(uint32_t value);
+  void addToBucket(uint16_t index, uint32_t n);
+  void merge(const Histogram& other);
+  void reset();
+  // After addToBucket() the maximum is only known to bucket precision; a
+  // decoder that also stored the exact maximum puts it back with this.
+  void setMaxValue(uint32_t value) { maximum = value; }
+
+  uint32_t count() const { return total; }
+  uint32_t maxValue() const { return maximum; }
+  uint32_t bucket(uint16_t index) const { return buckets[index]; }
+  uint32_t percentile(float p) const;
+
+  static uint16_t bucketIndex(uint32_t value);
+  static uint32_t bucketLowerBound(uint16_t index);
+  static uint32_t bucketUpperBound(uint16_t index);
+
+ private:
+  uint32_t buckets[BUCKET_COUNT] = {0};
+  uint32_t total = 0;
+  uint32_t maximum = 0;
+};
@@ -0,0 +1,253 @@
+#pragma once
+// ==================== HOST ARDUINO CORE ====================
+// Just enough of the Arduino-ESP32 API to build the firmware modules and
+// their libraries on a PC for `pio test -e native`. Time is virtual: it
+// only moves when delay() or yield() is called, an I2C transfer takes place or a test
+// advances it, so latencies measured against an emulator are exact and the
+// tests do not depend on how fast the PC is. Everything runs on one
+// thread; critical sections are no-ops.
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define IRAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define memcpy_P memcpy
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+#define lowByte(w) ((uint8_t)((w) & 0xFF))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// ==================== TIME ====================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+int64_t esp_timer_get_time();
+// Tests move the clock directly, e.g. to let a tag sit on the reader
+void hostAdvanceMicros(uint64_t us);
+uint64_t hostMicros();
+
+// ==================== PINS ====================
+// Inputs read HIGH (pulled up) unless a test sets them or an emulated
+// device drives them; outputs read back what was last written.
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void hostSetPin(uint8_t pin, uint8_t value);
+typedef int (*HostPinSource)(void* context);
+void hostDrivePin(uint8_t pin, HostPinSource source, void* context);
+
+// ==================== ESP32 ====================
+typedef enum {
+  ESP_RST_UNKNOWN,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO,
+} esp_reset_reason_t;
+esp_reset_reason_t esp_reset_reason();
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+struct portMUX_TYPE {
+  int owner;
+};
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+class EspClass {
+ public:
+  uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getCpuFreqMHz() { return 160; }
+  uint32_t getCycleCount() { return (uint32_t)(hostMicros() * 160); }
+  void restart() { exit(0); }
+};
+extern EspClass ESP;
+
+// ==================== STRING ====================
+class String {
+ public:
+  String() {}
+  String(const char* text) : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  explicit String(char c) : value(1, c) {}
+  String(int number, unsigned char base = DEC) { fromSigned(number, base); }
+  String(long number, unsigned char base = DEC) { fromSigned(number, base); }
+  String(long long number, unsigned char base = DEC) { fromSigned(number, base); }
+  String(unsigned char number, unsigned char base = DEC) { fromUnsigned(number, base); }
+  String(unsigned int number, unsigned char base = DEC) { fromUnsigned(number, base); }
+  String(unsigned long number, unsigned char base = DEC) { fromUnsigned(number, base); }
+  String(unsigned long long number, unsigned char base = DEC) { fromUnsigned(number, base); }
+  String(float number, unsigned int decimals = 2) { fromDouble(number, decimals); }
+  String(double number, unsigned int decimals = 2) { fromDouble(number, decimals); }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  int toInt() const { return atoi(value.c_str()); }
+  float toFloat() const { return atof(value.c_str()); }
+  bool isEmpty() const { return value.empty(); }
+
+  int indexOf(char c, unsigned int from = 0) const { return find(value.find(c, from)); }
+  int indexOf(const char* text, unsigned int from = 0) const { return find(value.find(text, from)); }
+  int indexOf(const String& text, unsigned int from = 0) const { return find(value.find(text.value, from)); }
+  int lastIndexOf(char c) const { return find(value.rfind(c)); }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    return from < value.size() ? String(value.substr(from, to - from)) : String();
+  }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+  }
+  bool equals(const String& other) const { return value == other.value; }
+  bool equalsIgnoreCase(const String& other) const;
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+  void replace(const String& from, const String& to);
+  void remove(unsigned int index, unsigned int count = (unsigned int)-1) {
+    if (index < value.size()) value.erase(index, count);
+  }
+  void toCharArray(char* buffer, unsigned int size) const { snprintf(buffer, size, "%s", value.c_str()); }
+  void getBytes(unsigned char* buffer, unsigned int size) const { toCharArray((char*)buffer, size); }
+  bool reserve(unsigned int size) {
+    value.reserve(size);
+    return true;
+  }
+
+  String& operator+=(const String& other) {
+    value += other.value;
+    return *this;
+  }
+  String& operator+=(const char* other) {
+    value += other;
+    return *this;
+  }
+  String& operator+=(char c) {
+    value += c;
+    return *this;
+  }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator==(const char* other) const { return value == other; }
+  bool operator!=(const String& other) const { return value != other.value; }
+  bool operator!=(const char* other) const { return value != other; }
+  bool operator<(const String& other) const { return value < other.value; }
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+  friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+  friend String operator+(const String& a, char b) { return String(a.value + b); }
+
+ private:
+  static int find(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+  void fromSigned(long long number, unsigned char base);
+  void fromUnsigned(unsigned long long number, unsigned char base);
+  void fromDouble(double number, unsigned int decimals);
+
+  std::string value;
+};
+
+// ==================== PRINT / STREAM ====================
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* data, size_t length);
+  size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+  size_t write(const char* data, size_t length) { return write((const uint8_t*)data, length); }
+  virtual void flush() {}
+
+  size_t print(const String& text) { return write(text.c_str()); }
+  size_t print(const char* text) { return write(text); }
+  size_t print(const __FlashStringHelper* text) { return write((const char*)text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char number, int base = DEC) { return print(String(number, base)); }
+  size_t print(int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(long long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned long long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(double number, int decimals = 2) { return print(String(number, decimals)); }
+  template <typename T>
+  size_t println(const T& value) {
+    return print(value) + println();
+  }
+  template <typename T>
+  size_t println(const T& value, int format) {
+    return print(value, format) + println();
+  }
+  size_t println() { return write("\r\n"); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long ms) { timeout = ms; }
+  size_t readBytes(uint8_t* buffer, size_t length);
+  size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+  String readStringUntil(char terminator);
+
+ protected:
+  int timedRead();
+  unsigned long timeout = 1000;
+};
+
+#include "HardwareSerial.h"
@@ -0,0 +1,57 @@
+#pragma once
+#include "Arduino.h"
+
+#define SERIAL_8N1 0x800001c
+
+// A device on the far end of a UART, e.g. an emulated DFPlayer. Times are
+// in host microseconds; the port paces both directions at its baud rate.
+class HostSerialDevice {
+ public:
+  virtual ~HostSerialDevice() {}
+  // A byte from the host has fully arrived at `at`
+  virtual void serialReceive(uint8_t c, uint32_t at) = 0;
+  // The next byte the device has finished sending by `now`, or -1
+  virtual int serialSend(uint32_t now) = 0;
+};
+
+// UART 0 is the console and goes to stdout. The others lead nowhere and
+// never receive anything unless a test attaches a device. Writes return at
+// once, as with the driver's TX buffer, but the bytes reach the device one
+// character time (10 bits) after another.
+class HardwareSerial : public Stream {
+ public:
+  static const uint16_t RX_BUFFER_SIZE = 256;  // driver default; overflow is dropped
+
+  explicit HardwareSerial(int uart) : uart(uart) {}
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+             bool invert = false, unsigned long timeoutMs = 20000UL) {
+    this->baud = baud;
+  }
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  int availableForWrite() { return 128; }
+  size_t write(uint8_t c) override;
+  using Print::write;
+  // Waits until the last byte has left
+  void flush() override;
+  operator bool() const { return true; }
+
+  void attach(HostSerialDevice* device) { this->device = device; }
+  uint32_t rxOverflows() const { return overflows; }
+
+ private:
+  uint32_t characterMicros() const { return baud ? 10000000UL / baud : 0; }
+
+  int uart;
+  unsigned long baud = 0;
+  HostSerialDevice* device = nullptr;
+  uint32_t txFreeAt = 0;  // when the last queued byte has been sent
+  uint8_t rx[RX_BUFFER_SIZE];
+  uint16_t rxHead = 0;
+  uint16_t rxCount = 0;
+  uint32_t overflows = 0;
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,303 @@
+#include <stdarg.h>
+#include <ctype.h>
+#include <map>
+#include <vector>
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "Preferences.h"
+#include "SPI.h"
+#include "Wire.h"
+
+// ==================== TIME ====================
+static uint64_t hostClock = 0;
+// A task yield on the chip is a context switch and back. Libraries that
+// busy-wait with delay(0) or yield() would never see time pass otherwise.
+const uint64_t HOST_YIELD_MICROS = 10;
+
+uint64_t hostMicros() { return hostClock; }
+void hostAdvanceMicros(uint64_t us) { hostClock += us; }
+unsigned long millis() { return (unsigned long)(hostClock / 1000); }
+unsigned long micros() { return (unsigned long)hostClock; }
+void delay(unsigned long ms) { hostClock += ms ? (uint64_t)ms * 1000 : HOST_YIELD_MICROS; }
+void delayMicroseconds(unsigned int us) { hostClock += us; }
+void yield() { hostClock += HOST_YIELD_MICROS; }
+int64_t esp_timer_get_time() { return (int64_t)hostClock; }
+
+// ==================== PINS ====================
+static uint8_t pinModes[64];
+static uint8_t pinLevels[64];
+static struct {
+  HostPinSource source;
+  void* context;
+} pinSources[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= sizeof(pinModes)) return;
+  pinModes[pin] = mode;
+  if (mode != OUTPUT) pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pinLevels)) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= sizeof(pinLevels)) return LOW;
+  if (pinSources[pin].source) return pinSources[pin].source(pinSources[pin].context) ? HIGH : LOW;
+  return pinModes[pin] == 0 ? HIGH : pinLevels[pin];
+}
+
+void hostSetPin(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pinLevels)) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+void hostDrivePin(uint8_t pin, HostPinSource source, void* context) {
+  if (pin >= sizeof(pinLevels)) return;
+  pinSources[pin].source = source;
+  pinSources[pin].context = context;
+}
+
+// ==================== ESP32 ====================
+EspClass ESP;
+static uint32_t randomState = 1;
+
+esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+uint32_t esp_random() {
+  randomState = randomState * 1664525 + 1013904223;
+  return randomState;
+}
+void randomSeed(unsigned long seed) { randomState = seed ? seed : 1; }
+long random(long howBig) { return howBig > 0 ? esp_random() % howBig : 0; }
+long random(long howSmall, long howBig) { return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall; }
+
+// ==================== STRING ====================
+void String::fromSigned(long long number, unsigned char base) {
+  if (base == DEC) value = std::to_string(number);
+  else fromUnsigned((unsigned long long)number, base);
+}
+
+void String::fromUnsigned(unsigned long long number, unsigned char base) {
+  char digits[66];
+  char* p = digits + sizeof(digits) - 1;
+  *p = 0;
+  do {
+    unsigned digit = number % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    number /= base;
+  } while (number);
+  value = p;
+}
+
+void String::fromDouble(double number, unsigned int decimals) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", decimals, number);
+  value = text;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+  if (value.size() != other.value.size()) return false;
+  for (size_t i = 0; i < value.size(); i++) {
+    if (tolower((unsigned char)value[i]) != tolower((unsigned char)other.value[i])) return false;
+  }
+  return true;
+}
+
+void String::toLowerCase() {
+  for (char& c : value) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (char& c : value) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+  size_t first = value.find_first_not_of(" \t\r\n");
+  size_t last = value.find_last_not_of(" \t\r\n");
+  value = first == std::string::npos ? std::string() : value.substr(first, last - first + 1);
+}
+
+void String::replace(const String& from, const String& to) {
+  if (from.value.empty()) return;
+  for (size_t at = value.find(from.value); at != std::string::npos; at = value.find(from.value, at + to.value.size())) {
+    value.replace(at, from.value.size(), to.value);
+  }
+}
+
+// ==================== PRINT / STREAM ====================
+size_t Print::write(const uint8_t* data, size_t length) {
+  size_t written = 0;
+  while (length--) written += write(*data++);
+  return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return length > 0 ? write((const uint8_t*)text, min((size_t)length, sizeof(text) - 1)) : 0;
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    delay(1);
+  } while (millis() - start < timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) break;
+    buffer[count++] = c;
+  }
+  return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String text;
+  for (int c = timedRead(); c >= 0 && c != terminator; c = timedRead()) text += (char)c;
+  return text;
+}
+
+HardwareSerial Serial(0);
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (uart == 0) fputc(c, stdout);
+  if (!device) return 1;
+  uint32_t now = micros();
+  txFreeAt = ((int32_t)(txFreeAt - now) > 0 ? txFreeAt : now) + characterMicros();
+  device->serialReceive(c, txFreeAt);
+  return 1;
+}
+
+void HardwareSerial::flush() {
+  if (device && (int32_t)(txFreeAt - micros()) > 0) hostClock += (uint32_t)(txFreeAt - micros());
+}
+
+int HardwareSerial::available() {
+  if (!device) return 0;
+  for (int c = device->serialSend(micros()); c >= 0; c = device->serialSend(micros())) {
+    if (rxCount == RX_BUFFER_SIZE) {
+      overflows++;
+      continue;
+    }
+    rx[(rxHead + rxCount++) % RX_BUFFER_SIZE] = c;
+  }
+  return rxCount;
+}
+
+int HardwareSerial::read() {
+  if (!available()) return -1;
+  uint8_t c = rx[rxHead];
+  rxHead = (rxHead + 1) % RX_BUFFER_SIZE;
+  rxCount--;
+  return c;
+}
+
+int HardwareSerial::peek() { return available() ? rx[rxHead] : -1; }
+
+// ==================== FLASH FILESYSTEM ====================
+LittleFSFS LittleFS;
+
+// ==================== I2C ====================
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+void TwoWire::busTime(size_t bytes) { hostClock += ((bytes + 1) * 9 + 2) * 1000000ULL / clock; }
+
+void TwoWire::beginTransmission(uint16_t address) {
+  txAddress = address;
+  txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if (txLength >= sizeof(txBuffer)) return 0;
+  txBuffer[txLength++] = c;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+  size_t written = 0;
+  while (written < length && write(data[written])) written++;
+  return written;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  HostI2cDevice* device = devices[txAddress & 0x7F];
+  busTime(device ? txLength : 0);
+  if (!device) return 2;  // address NACK
+  if (txLength) device->i2cWrite(txBuffer, txLength);
+  txLength = 0;
+  return 0;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool sendStop) {
+  rxIndex = rxLength = 0;
+  HostI2cDevice* device = devices[address & 0x7F];
+  if (!device || size == 0) {
+    busTime(0);
+    return 0;
+  }
+  size = min(size, sizeof(rxBuffer));
+  device->i2cRead(rxBuffer, size);
+  busTime(size);
+  rxLength = size;
+  return size;
+}
+
+SPIClass SPI;
+
+// ==================== PREFERENCES ====================
+static std::map<std::string, std::vector<uint8_t>> nvs;
+
+void hostErasePreferences() { nvs.clear(); }
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+  space = std::string(name) + "/";
+  this->readOnly = readOnly;
+  return true;
+}
+
+bool Preferences::clear() {
+  if (space.empty() || readOnly) return false;
+  for (auto it = nvs.begin(); it != nvs.end();) {
+    it = it->first.compare(0, space.size(), space) == 0 ? nvs.erase(it) : std::next(it);
+  }
+  return true;
+}
+
+bool Preferences::remove(const char* key) { return !space.empty() && !readOnly && nvs.erase(space + key) > 0; }
+
+bool Preferences::isKey(const char* key) { return !space.empty() && nvs.count(space + key) > 0; }
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (space.empty() || readOnly) return 0;
+  const uint8_t* bytes = (const uint8_t*)value;
+  nvs[space + key].assign(bytes, bytes + length);
+  return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = nvs.find(space + key);
+  return space.empty() || it == nvs.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+  size_t length = getBytesLength(key);
+  if (length == 0 || length > maxLength) return 0;
+  memcpy(buffer, nvs[space + key].data(), length);
+  return length;
+}
+
+String Preferences::getString(const char* key, const String& fallback) {
+  size_t length = getBytesLength(key);
+  if (length == 0) return fallback;
+  return String((const char*)nvs[space + key].data());
+}
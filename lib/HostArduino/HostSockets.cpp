@@ -0,0 +1,124 @@
+#include "lwip/sockets.h"
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// Far above the PC's own descriptors, and below FD_SETSIZE
+const int HOST_SOCKET_BASE = 100;
+
+struct HostSocket {
+  bool open = true;
+  bool listening = false;
+  std::string request;  // what the client sent
+  size_t requestRead = 0;
+  std::string received;  // what the server sent
+};
+
+static std::vector<HostSocket> hostSockets;
+static std::deque<int> pendingConnections;
+static size_t sendLimit = 0;
+
+static HostSocket* findSocket(int s) {
+  size_t index = (size_t)(s - HOST_SOCKET_BASE);
+  if (s < HOST_SOCKET_BASE || index >= hostSockets.size() || !hostSockets[index].open) return nullptr;
+  return &hostSockets[index];
+}
+
+static int newSocket() {
+  hostSockets.emplace_back();
+  return HOST_SOCKET_BASE + (int)hostSockets.size() - 1;
+}
+
+static int fail(int error) {
+  errno = error;
+  return -1;
+}
+
+int lwip_socket(int domain, int type, int protocol) { return newSocket(); }
+
+int lwip_setsockopt(int s, int level, int optname, const void* optval, socklen_t optlen) {
+  return findSocket(s) ? 0 : fail(EBADF);
+}
+
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen) { return findSocket(s) ? 0 : fail(EBADF); }
+
+int lwip_listen(int s, int backlog) {
+  HostSocket* socket = findSocket(s);
+  if (!socket) return fail(EBADF);
+  socket->listening = true;
+  return 0;
+}
+
+int lwip_accept(int s, struct sockaddr* addr, socklen_t* addrlen) {
+  HostSocket* socket = findSocket(s);
+  if (!socket || !socket->listening) return fail(EBADF);
+  if (pendingConnections.empty()) return fail(EWOULDBLOCK);
+  int connection = pendingConnections.front();
+  pendingConnections.pop_front();
+  return connection;
+}
+
+static bool readable(const HostSocket& socket) {
+  if (socket.listening) return !pendingConnections.empty();
+  return socket.requestRead < socket.request.size();
+}
+
+int lwip_select(int maxfdp1, fd_set* readset, fd_set* writeset, fd_set* exceptset, struct timeval* timeout) {
+  int ready = 0;
+  for (int s = 0; s < maxfdp1; s++) {
+    HostSocket* socket = findSocket(s);
+    if (readset && FD_ISSET(s, readset)) {
+      if (socket && readable(*socket)) ready++;
+      else FD_CLR(s, readset);
+    }
+    if (writeset && FD_ISSET(s, writeset)) {
+      if (socket && !socket->listening) ready++;
+      else FD_CLR(s, writeset);
+    }
+    if (exceptset) FD_CLR(s, exceptset);
+  }
+  return ready;
+}
+
+ssize_t lwip_recv(int s, void* mem, size_t len, int flags) {
+  HostSocket* socket = findSocket(s);
+  if (!socket) return fail(EBADF);
+  size_t n = std::min(len, socket->request.size() - socket->requestRead);
+  if (n == 0) return fail(EWOULDBLOCK);
+  memcpy(mem, socket->request.data() + socket->requestRead, n);
+  socket->requestRead += n;
+  return n;
+}
+
+ssize_t lwip_send(int s, const void* dataptr, size_t size, int flags) {
+  HostSocket* socket = findSocket(s);
+  if (!socket) return fail(EBADF);
+  if (sendLimit) size = std::min(size, sendLimit);
+  socket->received.append((const char*)dataptr, size);
+  return size;
+}
+
+int lwip_close(int s) {
+  HostSocket* socket = findSocket(s);
+  if (!socket) return fail(EBADF);
+  socket->open = false;
+  return 0;
+}
+
+int lwip_fcntl(int s, int cmd, int val) { return findSocket(s) ? 0 : fail(EBADF); }
+
+int hostSocketConnect(const char* request) {
+  int connection = newSocket();
+  hostSockets.back().request = request;
+  pendingConnections.push_back(connection);
+  return connection;
+}
+
+const std::string& hostSocketReceived(int connection) {
+  return hostSockets[connection - HOST_SOCKET_BASE].received;
+}
+
+bool hostSocketClosed(int connection) { return !hostSockets[connection - HOST_SOCKET_BASE].open; }
+
+void hostSocketSendLimit(size_t bytes) { sendLimit = bytes; }
@@ -0,0 +1,26 @@
+#pragma once
+#include "Arduino.h"
+
+// There is no flash partition on the host: begin() fails and nothing
+// opens, which is how the firmware finds a board without one. Modules that
+// keep data in LittleFS run with it disabled.
+class File {
+ public:
+  operator bool() const { return false; }
+  size_t write(const uint8_t*, size_t) { return 0; }
+  size_t read(uint8_t*, size_t) { return 0; }
+  size_t size() { return 0; }
+  bool seek(uint32_t) { return false; }
+  size_t position() { return 0; }
+  void close() {}
+};
+
+class LittleFSFS {
+ public:
+  bool begin(bool formatOnFail = false) { return false; }
+  File open(const char* path, const char* mode = "r") { return File(); }
+  bool exists(const char* path) { return false; }
+  bool remove(const char* path) { return false; }
+};
+
+extern LittleFSFS LittleFS;
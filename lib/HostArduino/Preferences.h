@@ -0,0 +1,51 @@
+#pragma once
+#include "Arduino.h"
+
+// NVS in memory: one store for the whole process, so values written
+// through one Preferences object are seen by the next, as on the chip.
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false, const char* partition = nullptr);
+  void end() { space.clear(); }
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytes(const char* key, void* buffer, size_t maxLength);
+  size_t getBytesLength(const char* key);
+
+  size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUShort(const char* key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putShort(const char* key, int16_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putULong(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putBool(const char* key, bool value) { return putUChar(key, value); }
+  size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+  size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+
+  uint8_t getUChar(const char* key, uint8_t fallback = 0) { return get(key, fallback); }
+  uint16_t getUShort(const char* key, uint16_t fallback = 0) { return get(key, fallback); }
+  int16_t getShort(const char* key, int16_t fallback = 0) { return get(key, fallback); }
+  uint32_t getUInt(const char* key, uint32_t fallback = 0) { return get(key, fallback); }
+  int32_t getInt(const char* key, int32_t fallback = 0) { return get(key, fallback); }
+  uint32_t getULong(const char* key, uint32_t fallback = 0) { return get(key, fallback); }
+  bool getBool(const char* key, bool fallback = false) { return getUChar(key, fallback) != 0; }
+  float getFloat(const char* key, float fallback = NAN) { return get(key, fallback); }
+  String getString(const char* key, const String& fallback = String());
+
+ private:
+  template <typename T>
+  T get(const char* key, T fallback) {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : fallback;
+  }
+
+  std::string space;
+  bool readOnly = false;
+};
+
+// Wipes every namespace, like erasing the NVS partition
+void hostErasePreferences();
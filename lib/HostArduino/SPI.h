@@ -0,0 +1,39 @@
+#pragma once
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+// Nothing is attached to SPI on the host: transfers shift in 0xFF.
+class SPISettings {
+ public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+  uint32_t clock = 1000000;
+  uint8_t bitOrder = MSBFIRST;
+  uint8_t dataMode = SPI_MODE0;
+};
+
+class SPIClass {
+ public:
+  explicit SPIClass(uint8_t bus = 0) {}
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+  void end() {}
+  void beginTransaction(SPISettings settings) {}
+  void endTransaction() {}
+  void setBitOrder(uint8_t bitOrder) {}
+  void setDataMode(uint8_t dataMode) {}
+  void setFrequency(uint32_t frequency) {}
+  void setClockDivider(uint32_t divider) {}
+  uint8_t transfer(uint8_t data) { return 0xFF; }
+  uint16_t transfer16(uint16_t data) { return 0xFFFF; }
+  void transfer(void* data, uint32_t size) { memset(data, 0xFF, size); }
+  void transferBytes(const uint8_t* data, uint8_t* out, uint32_t size) {
+    if (out) memset(out, 0xFF, size);
+  }
+  void writeBytes(const uint8_t* data, uint32_t size) {}
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,72 @@
+#pragma once
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+// A device on the emulated bus. Each call is one whole transaction:
+// everything the controller wrote between start and stop, or a read of
+// length bytes.
+class HostI2cDevice {
+ public:
+  virtual ~HostI2cDevice() {}
+  virtual void i2cWrite(const uint8_t* data, size_t length) = 0;
+  virtual void i2cRead(uint8_t* data, size_t length) = 0;
+};
+
+// Arduino-ESP32's TwoWire, with the same 128-byte buffers. Transfers take
+// their bus time at the configured clock: 9 bits per byte plus the address.
+// Addresses with no device attached are NACKed.
+class TwoWire : public Stream {
+ public:
+  explicit TwoWire(uint8_t bus) : bus(bus) {}
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    if (frequency) clock = frequency;
+    return true;
+  }
+  bool end() { return true; }
+  bool setClock(uint32_t frequency) {
+    clock = frequency;
+    return true;
+  }
+  uint32_t getClock() { return clock; }
+
+  void beginTransmission(uint16_t address);
+  void beginTransmission(uint8_t address) { beginTransmission((uint16_t)address); }
+  void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+  uint8_t endTransmission(bool sendStop = true);
+  size_t requestFrom(uint16_t address, size_t size, bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t size) { return requestFrom((uint16_t)address, (size_t)size, true); }
+  uint8_t requestFrom(uint8_t address, uint8_t size, uint8_t sendStop) {
+    return requestFrom((uint16_t)address, (size_t)size, sendStop != 0);
+  }
+  uint8_t requestFrom(int address, int size) { return requestFrom((uint16_t)address, (size_t)size, true); }
+  uint8_t requestFrom(int address, int size, int sendStop) {
+    return requestFrom((uint16_t)address, (size_t)size, sendStop != 0);
+  }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  using Print::write;
+  int available() override { return rxLength - rxIndex; }
+  int read() override { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+  int peek() override { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+
+  // Host tests put devices on the bus, e.g. an emulated PN532
+  void attach(uint8_t address, HostI2cDevice* device) { devices[address & 0x7F] = device; }
+
+ private:
+  void busTime(size_t bytes);
+
+  uint8_t bus;
+  uint32_t clock = 100000;
+  HostI2cDevice* devices[128] = {};
+  uint16_t txAddress = 0;
+  uint8_t txBuffer[I2C_BUFFER_LENGTH];
+  size_t txLength = 0;
+  uint8_t rxBuffer[I2C_BUFFER_LENGTH];
+  size_t rxLength = 0;
+  size_t rxIndex = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,48 @@
+#pragma once
+// ==================== HOST SOCKETS ====================
+// lwIP's BSD socket API on an in-memory network, for host tests of the web
+// UI. As lwIP does, the POSIX names are macros for lwip_* functions, so the
+// firmware's calls never reach the PC's own sockets. A test plays the
+// client: it opens a connection with the whole request already sent, runs
+// the server and reads back what was sent before the server closed it.
+// Everything is non-blocking; select() reports a listening socket with a
+// pending connection, a connection with unread request bytes, and every
+// open connection as writable.
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+
+int lwip_socket(int domain, int type, int protocol);
+int lwip_setsockopt(int s, int level, int optname, const void* optval, socklen_t optlen);
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen);
+int lwip_listen(int s, int backlog);
+int lwip_accept(int s, struct sockaddr* addr, socklen_t* addrlen);
+int lwip_select(int maxfdp1, fd_set* readset, fd_set* writeset, fd_set* exceptset, struct timeval* timeout);
+ssize_t lwip_recv(int s, void* mem, size_t len, int flags);
+ssize_t lwip_send(int s, const void* dataptr, size_t size, int flags);
+int lwip_close(int s);
+int lwip_fcntl(int s, int cmd, int val);
+
+#define socket(domain, type, protocol) lwip_socket(domain, type, protocol)
+#define setsockopt(s, level, optname, opval, optlen) lwip_setsockopt(s, level, optname, opval, optlen)
+#define bind(s, name, namelen) lwip_bind(s, name, namelen)
+#define listen(s, backlog) lwip_listen(s, backlog)
+#define accept(s, addr, addrlen) lwip_accept(s, addr, addrlen)
+#define select(maxfdp1, readset, writeset, exceptset, timeout) \
+  lwip_select(maxfdp1, readset, writeset, exceptset, timeout)
+#define recv(s, mem, len, flags) lwip_recv(s, mem, len, flags)
+#define send(s, dataptr, size, flags) lwip_send(s, dataptr, size, flags)
+#define close(s) lwip_close(s)
+#define fcntl(s, cmd, val) lwip_fcntl(s, cmd, val)
+
+// The client side, for tests. A connection is named by the server's fd.
+int hostSocketConnect(const char* request);
+const std::string& hostSocketReceived(int connection);
+bool hostSocketClosed(int connection);
+// At most this many bytes per send(), to exercise partial writes; 0 is no limit
+void hostSocketSendLimit(size_t bytes);
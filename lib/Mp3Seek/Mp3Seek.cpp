@@ -0,0 +1,163 @@
+#include "Mp3Seek.h"
+#include <string.h>
+
+// Layer III bitrates in kbit/s by version: MPEG-1, then MPEG-2 and 2.5
+const uint16_t BITRATES[2][15] = {
+  {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+  {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+};
+const uint16_t SAMPLE_RATES[3] = {44100, 48000, 32000};  // MPEG-1; halved for 2, quartered for 2.5
+
+// Version bits: 0 = MPEG-2.5, 1 = reserved, 2 = MPEG-2, 3 = MPEG-1
+bool parseMp3FrameHeader(const uint8_t* bytes, Mp3FrameHeader& header) {
+  if (bytes[0] != 0xFF || (bytes[1] & 0xE0) != 0xE0) return false;
+  uint8_t version = (bytes[1] >> 3) & 0x03;
+  uint8_t layer = (bytes[1] >> 1) & 0x03;
+  uint8_t bitrateIndex = bytes[2] >> 4;
+  uint8_t sampleRateIndex = (bytes[2] >> 2) & 0x03;
+  if (version == 1 || layer != 1 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3) return false;
+  if ((bytes[3] & 0x03) == 2) return false;  // reserved emphasis
+
+  bool mpeg1 = version == 3;
+  header.bitrate = BITRATES[mpeg1 ? 0 : 1][bitrateIndex] * 1000;
+  header.sampleRate = SAMPLE_RATES[sampleRateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+  header.samplesPerFrame = mpeg1 ? 1152 : 576;
+  uint8_t padding = (bytes[2] >> 1) & 0x01;
+  header.length = header.samplesPerFrame / 8 * header.bitrate / header.sampleRate + padding;
+  return true;
+}
+
+void Mp3SeekIndex::reset(uint32_t fileSize, uint32_t fileStamp) {
+  count = 0;
+  interval = MP3_SEEK_MIN_INTERVAL_MS;
+  sourceSize = fileSize;
+  sourceStamp = fileStamp;
+  samples = 0;
+  sampleRate = 0;
+  frames = 0;
+  position = 0;
+  skip = 0;
+  pendingLength = 0;
+  id3Checked = false;
+}
+
+void Mp3SeekIndex::addFrame(uint32_t offset, const Mp3FrameHeader& header) {
+  if (sampleRate == 0) sampleRate = header.sampleRate;
+  uint32_t timeMs = samples * 1000 / sampleRate;
+  samples += header.samplesPerFrame;
+  frames++;
+  if (count > 0 && timeMs - points[count - 1].timeMs < interval) return;
+  if (count == MP3_SEEK_MAX_POINTS) {
+    for (uint16_t i = 0; i < count / 2; i++) points[i] = points[2 * i];
+    count /= 2;
+    interval *= 2;
+    if (timeMs - points[count - 1].timeMs < interval) return;
+  }
+  points[count++] = {timeMs, offset};
+}
+
+// pending starts at file offset position - pendingLength. Bytes that do
+// not start a frame of this stream are dropped one at a time.
+void Mp3SeekIndex::scanPending() {
+  while (pendingLength >= 4) {
+    Mp3FrameHeader header;
+    if (parseMp3FrameHeader(pending, header) && (sampleRate == 0 || header.sampleRate == sampleRate)) {
+      addFrame(position - pendingLength, header);
+      skip = header.length - pendingLength;
+      pendingLength = 0;
+      return;
+    }
+    memmove(pending, pending + 1, --pendingLength);
+  }
+}
+
+void Mp3SeekIndex::feed(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    if (skip > 0) {
+      uint32_t n = length - i < skip ? length - i : skip;
+      skip -= n;
+      i += n;
+      position += n;
+      continue;
+    }
+    pending[pendingLength++] = data[i++];
+    position++;
+    if (id3Checked) {
+      scanPending();
+      continue;
+    }
+    if (pendingLength < sizeof(pending)) continue;
+    id3Checked = true;
+    if (pending[0] == 'I' && pending[1] == 'D' && pending[2] == '3') {
+      // Syncsafe size: 7 bits per byte, plus a footer if flagged
+      uint32_t tagSize = (uint32_t)(pending[6] & 0x7F) << 21 | (uint32_t)(pending[7] & 0x7F) << 14 |
+                      (pending[8] & 0x7F) << 7 | (pending[9] & 0x7F);
+      skip = tagSize + (pending[5] & 0x10 ? 10 : 0);
+      pendingLength = 0;
+    } else {
+      scanPending();
+    }
+  }
+}
+
+bool Mp3SeekIndex::find(uint32_t positionMs, Mp3SeekPoint& point) const {
+  if (count == 0) return false;
+  uint16_t low = 0, high = count;  // points[low].timeMs <= positionMs, or low == 0
+  while (high - low > 1) {
+    uint16_t mid = (low + high) / 2;
+    if (points[mid].timeMs <= positionMs) low = mid;
+    else high = mid;
+  }
+  point = points[low];
+  return true;
+}
+
+static void put32(uint8_t* out, uint32_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+  out[2] = v >> 16;
+  out[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t* in) {
+  return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+size_t Mp3SeekIndex::encode(uint8_t* out, size_t capacity) const {
+  size_t encoded = encodedSize(count);
+  if (capacity < encoded) return 0;
+  memcpy(out, "AMSI", 4);
+  out[4] = MP3_SEEK_INDEX_FORMAT;
+  put32(out + 5, sourceSize);
+  put32(out + 9, sourceStamp);
+  put32(out + 13, durationMs());
+  put32(out + 17, interval);
+  out[21] = count;
+  out[22] = count >> 8;
+  for (uint16_t i = 0; i < count; i++) {
+    put32(out + MP3_SEEK_HEADER_SIZE + 8 * i, points[i].timeMs);
+    put32(out + MP3_SEEK_HEADER_SIZE + 8 * i + 4, points[i].offset);
+  }
+  return encoded;
+}
+
+// Only what find() needs comes back; the scanner state stays reset, so a
+// decoded index cannot be extended with feed().
+bool Mp3SeekIndex::decode(const uint8_t* in, size_t length, uint32_t fileSize, uint32_t fileStamp) {
+  reset(fileSize, fileStamp);
+  if (length < MP3_SEEK_HEADER_SIZE || memcmp(in, "AMSI", 4) != 0 || in[4] != MP3_SEEK_INDEX_FORMAT) return false;
+  if (get32(in + 5) != fileSize || get32(in + 9) != fileStamp) return false;
+  uint16_t stored = in[21] | in[22] << 8;
+  if (stored > MP3_SEEK_MAX_POINTS || length < encodedSize(stored)) return false;
+  // Duration comes back as milliseconds of a 1 kHz clock
+  sampleRate = 1000;
+  samples = get32(in + 13);
+  interval = get32(in + 17);
+  for (uint16_t i = 0; i < stored; i++) {
+    points[i].timeMs = get32(in + MP3_SEEK_HEADER_SIZE + 8 * i);
+    points[i].offset = get32(in + MP3_SEEK_HEADER_SIZE + 8 * i + 4);
+  }
+  count = stored;
+  return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== MP3 SEEK INDEX ====================
+// MP3 has no random access: the only way to know where second N starts is
+// to walk the frame headers from the beginning. The builder does that
+// walk once, streaming the file through feed() in whatever chunks the SD
+// driver returns, and keeps a sampled frame-offset table. Resuming is then
+// a lookup, one seek to the returned offset and a frame decode.
+//
+// The table holds at most MP3_SEEK_MAX_POINTS points. When it fills up,
+// every other point is dropped and the interval doubles, so short songs
+// get one point a second and a 60-minute chapter about one every 8 s.
+// Playback resumes at the point, at most one interval before the requested
+// position: walking the frame headers from there to the exact frame would
+// cost a read per frame, some 300 for an 8 s interval.
+//
+// This is used instead of a Xing TOC: the TOC only has 1% steps (36 s on a
+// 60-minute file) and CBR files usually have none.
+const uint16_t MP3_SEEK_MAX_POINTS = 512;
+const uint32_t MP3_SEEK_MIN_INTERVAL_MS = 1000;
+const uint8_t MP3_SEEK_INDEX_FORMAT = 1;
+// "AMSI" <format> <file size u32> <file stamp u32> <duration ms u32>
+// <interval ms u32> <count u16>, then <time ms u32> <offset u32> per point
+const size_t MP3_SEEK_HEADER_SIZE = 4 + 1 + 4 * 4 + 2;
+
+struct Mp3FrameHeader {
+  uint32_t bitrate;  // bits per second
+  uint16_t sampleRate;
+  uint16_t samplesPerFrame;
+  uint16_t length;  // bytes, header and padding included
+};
+
+// MPEG-1/2/2.5 Layer III only; free-format and reserved values are rejected.
+bool parseMp3FrameHeader(const uint8_t* bytes, Mp3FrameHeader& header);
+
+struct Mp3SeekPoint {
+  uint32_t timeMs;
+  uint32_t offset;  // first byte of the frame that starts at timeMs
+};
+
+class Mp3SeekIndex {
+ public:
+  // Streaming build: reset, then feed the whole file in order. An ID3v2 tag
+  // at the start is skipped; anything that does not parse as a frame is
+  // scanned past until the next header of the same stream.
+  void reset(uint32_t fileSize, uint32_t fileStamp);
+  void feed(const uint8_t* data, size_t length);
+
+  // The last point at or before positionMs; false if the index is empty
+  bool find(uint32_t positionMs, Mp3SeekPoint& point) const;
+
+  // Returns the encoded size, or 0 if capacity is too small
+  size_t encode(uint8_t* out, size_t capacity) const;
+  // False unless the input is a complete index for this size and stamp
+  bool decode(const uint8_t* in, size_t length, uint32_t fileSize, uint32_t fileStamp);
+  static size_t encodedSize(uint16_t count) { return MP3_SEEK_HEADER_SIZE + count * 8; }
+
+  uint32_t durationMs() const { return (uint32_t)(samples * 1000 / (sampleRate ? sampleRate : 1)); }
+  uint16_t pointCount() const { return count; }
+  uint32_t intervalMs() const { return interval; }
+  uint32_t frameCount() const { return frames; }
+  // Where the next feed() continues in the file
+  uint32_t bytesFed() const { return position; }
+
+ private:
+  void scanPending();
+  void addFrame(uint32_t offset, const Mp3FrameHeader& header);
+
+  Mp3SeekPoint points[MP3_SEEK_MAX_POINTS];
+  uint16_t count = 0;
+  uint32_t interval = MP3_SEEK_MIN_INTERVAL_MS;
+  uint32_t sourceSize = 0;
+  uint32_t sourceStamp = 0;
+  uint64_t samples = 0;  // decoded so far, at sampleRate
+  uint16_t sampleRate = 0;
+  uint32_t frames = 0;
+  // Scanner state between feed() calls
+  uint32_t position = 0;  // file offset of the next byte fed
+  uint32_t skip = 0;      // bytes left of the current frame or ID3 tag
+  uint8_t pending[10];    // header bytes collected so far
+  uint8_t pendingLength = 0;
+  bool id3Checked = false;
+};
@@ -0,0 +1,219 @@
+#include "Pn532Emulator.h"
+#include <string.h>
+
+const uint8_t HOST_TO_PN532 = 0xD4;
+const uint8_t PN532_TO_HOST = 0xD5;
+const uint8_t ACK_FRAME[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+const uint8_t SYNTAX_ERROR_FRAME[] = {0x00, 0x00, 0xFF, 0x01, 0xFF, 0x7F, 0x81, 0x00};
+
+const uint8_t CMD_GET_FIRMWARE_VERSION = 0x02;
+const uint8_t CMD_SAM_CONFIGURATION = 0x14;
+const uint8_t CMD_RF_CONFIGURATION = 0x32;
+const uint8_t CMD_IN_DATA_EXCHANGE = 0x40;
+const uint8_t CMD_IN_LIST_PASSIVE_TARGET = 0x4A;
+const uint8_t RF_ITEM_MAX_RETRIES = 0x05;
+
+const uint8_t NTAG_READ = 0x30;
+const uint8_t NTAG_FAST_READ = 0x3A;
+const uint8_t NTAG_WRITE = 0xA2;
+const uint8_t NTAG_FIRST_WRITABLE_PAGE = 2;  // pages 0 and 1 hold the UID
+
+// InDataExchange status bytes
+const uint8_t STATUS_OK = 0x00;
+const uint8_t STATUS_TIMEOUT = 0x01;  // no answer, or the tag's 4-bit NAK
+const uint8_t STATUS_BAD_CONTEXT = 0x27;
+
+// A response frame adds 8 bytes around the data (TFI and command included)
+const uint8_t MAX_RESPONSE_DATA = PN532_EMULATOR_MAX_FRAME - 8;
+
+static bool reached(uint32_t now, uint32_t when) { return (int32_t)(now - when) >= 0; }
+
+void Pn532Emulator::reset() {
+  Pn532Latencies keep = latencies;
+  *this = Pn532Emulator();
+  latencies = keep;
+}
+
+void Pn532Emulator::placeTag(const uint8_t* id, uint8_t length) {
+  placeCard(id, length, 0x0044, 0x00);
+  isNtag = true;
+  memset(pages, 0, sizeof(pages));
+  memcpy(pages[0], id, length < 3 ? length : 3);
+  if (length > 3) memcpy(pages[1], id + 3, length - 3 < 4 ? length - 3 : 4);
+  const uint8_t capabilityContainer[4] = {0xE1, 0x10, 0x3E, 0x00};
+  memcpy(pages[3], capabilityContainer, 4);
+}
+
+void Pn532Emulator::placeCard(const uint8_t* id, uint8_t length, uint16_t cardAtqa, uint8_t cardSak) {
+  uidLength = length > sizeof(uid) ? sizeof(uid) : length;
+  memcpy(uid, id, uidLength);
+  atqa = cardAtqa;
+  sak = cardSak;
+  isNtag = false;
+  present = true;
+  selected = false;
+}
+
+void Pn532Emulator::write(const uint8_t* data, size_t length, uint32_t now) {
+  size_t i = 0;
+  while (i < length && data[i] == 0x00) i++;  // preamble
+  if (i == 0 || i + 1 >= length || data[i] != 0xFF) {
+    stats.badFrames++;
+    return;
+  }
+  i++;
+  if (length - i >= 2 && data[i] == 0x00 && data[i + 1] == 0xFF) {
+    // ACK from the host: abort the current command
+    if (pending != PENDING_NONE) stats.aborted++;
+    pending = PENDING_NONE;
+    return;
+  }
+
+  uint8_t len = data[i];
+  if (length - i < (size_t)len + 3 || (uint8_t)(len + data[i + 1]) != 0 || len == 0 || data[i + 2] != HOST_TO_PN532) {
+    stats.badFrames++;
+    return;
+  }
+  uint8_t checksum = 0;
+  for (size_t j = i + 2; j < i + 2 + len + 1; j++) checksum += data[j];
+  if (checksum != 0 || len < 2) {
+    stats.badFrames++;
+    return;
+  }
+
+  if (pending != PENDING_NONE) stats.aborted++;
+  stats.commands++;
+  pending = PENDING_ACK;
+  ackAt = now + latencies.ackMicros;
+  hasResponse = false;
+  execute(data[i + 3], data + i + 4, len - 2);
+}
+
+bool Pn532Emulator::frameReady(uint32_t now) const {
+  if (pending == PENDING_ACK) return reached(now, ackAt);
+  return pending == PENDING_RESPONSE && hasResponse && reached(now, responseAt);
+}
+
+void Pn532Emulator::read(uint8_t* data, size_t length, uint32_t now) {
+  if (length == 0) return;
+  memset(data, 0, length);
+  if (!frameReady(now)) {
+    stats.notReadyReads++;
+    return;
+  }
+  data[0] = 0x01;
+  if (length == 1) return;  // status only: the frame stays
+
+  const uint8_t* out = pending == PENDING_ACK ? ACK_FRAME : response;
+  size_t outLength = pending == PENDING_ACK ? sizeof(ACK_FRAME) : responseLength;
+  memcpy(data + 1, out, length - 1 < outLength ? length - 1 : outLength);
+  pending = pending == PENDING_ACK ? PENDING_RESPONSE : PENDING_NONE;
+}
+
+void Pn532Emulator::respond(uint8_t command, const uint8_t* data, uint8_t length, uint32_t readyAt) {
+  uint8_t len = length + 2;
+  uint8_t* f = response;
+  f[0] = 0x00;
+  f[1] = 0x00;
+  f[2] = 0xFF;
+  f[3] = len;
+  f[4] = (uint8_t)(0x100 - len);
+  f[5] = PN532_TO_HOST;
+  f[6] = command + 1;
+  if (length) memcpy(f + 7, data, length);
+  uint8_t checksum = PN532_TO_HOST + command + 1;
+  for (uint8_t i = 0; i < length; i++) checksum += data[i];
+  f[7 + length] = (uint8_t)(0x100 - checksum);
+  f[8 + length] = 0x00;
+  responseLength = 9 + length;
+  responseAt = readyAt;
+  hasResponse = true;
+}
+
+void Pn532Emulator::execute(uint8_t command, const uint8_t* data, uint8_t length) {
+  uint32_t start = ackAt;
+  switch (command) {
+    case CMD_GET_FIRMWARE_VERSION: {
+      const uint8_t version[4] = {PN532_EMULATOR_FIRMWARE >> 24, (PN532_EMULATOR_FIRMWARE >> 16) & 0xFF,
+                                  (PN532_EMULATOR_FIRMWARE >> 8) & 0xFF, PN532_EMULATOR_FIRMWARE & 0xFF};
+      respond(command, version, sizeof(version), start + latencies.firmwareVersionMicros);
+      return;
+    }
+    case CMD_SAM_CONFIGURATION:
+      samDone = true;
+      respond(command, nullptr, 0, start + latencies.samConfigMicros);
+      return;
+    case CMD_RF_CONFIGURATION:
+      if (length >= 4 && data[0] == RF_ITEM_MAX_RETRIES) activationRetries = data[3];
+      respond(command, nullptr, 0, start + latencies.rfConfigMicros);
+      return;
+    case CMD_IN_LIST_PASSIVE_TARGET: {
+      selected = false;
+      if (length >= 2 && data[1] == 0x00 && present) {
+        uint8_t target[6 + sizeof(uid)] = {1, 1, (uint8_t)(atqa >> 8), (uint8_t)atqa, sak, uidLength};
+        memcpy(target + 6, uid, uidLength);
+        selected = true;
+        respond(command, target, 6 + uidLength, start + latencies.activationMicros);
+      } else if (activationRetries != 0xFF) {
+        const uint8_t none[1] = {0};
+        respond(command, none, 1, start + (activationRetries + 1u) * latencies.activationAttemptMicros);
+      }
+      // else the chip keeps looking until the host aborts
+      return;
+    }
+    case CMD_IN_DATA_EXCHANGE:
+      exchange(data, length);
+      return;
+    default:
+      memcpy(response, SYNTAX_ERROR_FRAME, sizeof(SYNTAX_ERROR_FRAME));
+      responseLength = sizeof(SYNTAX_ERROR_FRAME);
+      responseAt = start;
+      hasResponse = true;
+      return;
+  }
+}
+
+void Pn532Emulator::exchange(const uint8_t* data, uint8_t length) {
+  stats.exchanges++;
+  uint8_t out[1 + MAX_RESPONSE_DATA];
+  uint32_t start = ackAt;
+  if (length < 2 || data[0] != 1 || !selected) {
+    out[0] = STATUS_BAD_CONTEXT;
+    respond(CMD_IN_DATA_EXCHANGE, out, 1, start + latencies.exchangeMicros);
+    return;
+  }
+  const uint8_t* tagCommand = data + 1;
+  uint8_t tagLength = length - 1;
+  uint32_t timeout = start + latencies.exchangeMicros + latencies.exchangeTimeoutMicros;
+  out[0] = STATUS_TIMEOUT;
+  if (!present || !isNtag || dropCount) {
+    if (dropCount) dropCount--;
+    respond(CMD_IN_DATA_EXCHANGE, out, 1, timeout);
+    return;
+  }
+
+  uint16_t outLength = 0;
+  uint32_t extra = 0;
+  if (tagCommand[0] == NTAG_READ && tagLength >= 2 && tagCommand[1] < PN532_EMULATOR_PAGES) {
+    for (uint8_t i = 0; i < 4; i++) memcpy(out + 1 + i * 4, pages[(tagCommand[1] + i) % PN532_EMULATOR_PAGES], 4);
+    outLength = 16;
+    stats.pageReads++;
+  } else if (tagCommand[0] == NTAG_FAST_READ && tagLength >= 3 && tagCommand[1] <= tagCommand[2] &&
+             tagCommand[2] < PN532_EMULATOR_PAGES && (tagCommand[2] - tagCommand[1] + 1) * 4 <= MAX_RESPONSE_DATA - 1) {
+    outLength = (tagCommand[2] - tagCommand[1] + 1) * 4;
+    memcpy(out + 1, pages[tagCommand[1]], outLength);
+    stats.pageReads++;
+  } else if (tagCommand[0] == NTAG_WRITE && tagLength >= 6 && tagCommand[1] >= NTAG_FIRST_WRITABLE_PAGE &&
+             tagCommand[1] < PN532_EMULATOR_PAGES) {
+    memcpy(pages[tagCommand[1]], tagCommand + 2, 4);
+    extra = latencies.pageWriteMicros;
+    stats.pageWrites++;
+  } else {
+    respond(CMD_IN_DATA_EXCHANGE, out, 1, timeout);
+    return;
+  }
+  out[0] = STATUS_OK;
+  uint32_t airBytes = tagLength + 2 + (outLength ? outLength + 2 : 0);  // CRC both ways
+  respond(CMD_IN_DATA_EXCHANGE, out, 1 + outLength,
+          start + latencies.exchangeMicros + airBytes * latencies.exchangeByteMicros + extra);
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== PN532 I2C EMULATOR ====================
+// The PN532 as the host sees it on I2C, at frame level, for host tests of
+// the real Adafruit driver. Every write transaction carries one frame
+// (00 00 FF LEN LCS D4 <command> <data> DCS 00); every read transaction
+// starts with the status byte, 01 once a frame is ready. A command is
+// acknowledged first (00 00 FF 00 FF 00) and answered later with
+// 00 00 FF LEN LCS D5 <command + 1> <data> DCS 00. A read that goes past
+// the status byte takes the frame, however many bytes the host asked for;
+// bytes beyond the frame read as 00. A new command, or an ACK frame from
+// the host, aborts whatever was pending, as on the chip. The IRQ line
+// follows the status byte.
+//
+// Supported: GetFirmwareVersion, SAMConfiguration, RFConfiguration (the
+// passive activation retries), InListPassiveTarget for one ISO14443A
+// target and InDataExchange carrying NTAG READ, FAST_READ and WRITE.
+// Anything else gets the syntax error frame. Foreign cards are activated
+// but never answer an exchange.
+//
+// Nothing here knows about Arduino: every call takes the current time in
+// microseconds, so tests run it against a virtual clock and the latencies
+// below are exactly what the driver ends up waiting for.
+const uint8_t PN532_EMULATOR_ADDRESS = 0x24;
+const uint32_t PN532_EMULATOR_FIRMWARE = 0x32010607;  // PN532, v1.6, all protocols
+const uint8_t PN532_EMULATOR_PAGES = 135;              // NTAG215
+const uint8_t PN532_EMULATOR_MAX_FRAME = 200;
+
+struct Pn532Latencies {
+  uint32_t ackMicros = 0;                  // command frame in, ACK ready (the chip stretches SCL)
+  uint32_t firmwareVersionMicros = 300;   // these three are read right after the ACK,
+  uint32_t samConfigMicros = 300;         // without polling, by the Adafruit driver
+  uint32_t rfConfigMicros = 300;
+  uint32_t activationMicros = 4500;        // InListPassiveTarget with a target in the field
+  uint32_t activationAttemptMicros = 9000; // each attempt with an empty field
+  uint32_t exchangeMicros = 1500;          // InDataExchange, plus per tag byte:
+  uint32_t exchangeByteMicros = 85;        // 106 kbit/s with parity
+  uint32_t exchangeTimeoutMicros = 5000;   // target gone or not an NTAG
+  uint32_t pageWriteMicros = 4100;         // NTAG EEPROM programming
+};
+
+struct Pn532EmulatorStats {
+  uint32_t commands = 0;
+  uint32_t exchanges = 0;  // InDataExchange, answered or not
+  uint32_t pageReads = 0;  // READ and FAST_READ commands sent to the tag
+  uint32_t pageWrites = 0;
+  uint32_t notReadyReads = 0;  // reads that found status 00
+  uint32_t aborted = 0;        // commands replaced before their response was read
+  uint32_t badFrames = 0;
+};
+
+class Pn532Emulator {
+ public:
+  Pn532Latencies latencies;
+  Pn532EmulatorStats stats;
+
+  // Power-on state: empty field, infinite activation retries
+  void reset();
+
+  // An NTAG215 with blank user memory (capability container in page 3)
+  void placeTag(const uint8_t* uid, uint8_t uidLength);
+  // Any other ISO14443A target: activates, never answers NTAG commands
+  void placeCard(const uint8_t* uid, uint8_t uidLength, uint16_t atqa, uint8_t sak);
+  void removeTarget() { present = false; }
+  bool targetPresent() const { return present; }
+  // The next count exchanges time out, like a tag at the edge of the field
+  void dropExchanges(uint8_t count) { dropCount = count; }
+
+  uint8_t* page(uint8_t index) { return pages[index]; }
+  bool samConfigured() const { return samDone; }
+
+  // One I2C transaction each
+  void write(const uint8_t* data, size_t length, uint32_t now);
+  void read(uint8_t* data, size_t length, uint32_t now);
+  // P70_IRQ is driven low while a frame waits to be read
+  bool frameReady(uint32_t now) const;
+
+ private:
+  enum Pending : uint8_t { PENDING_NONE, PENDING_ACK, PENDING_RESPONSE };
+
+  void execute(uint8_t command, const uint8_t* data, uint8_t length);
+  void exchange(const uint8_t* data, uint8_t length);
+  void respond(uint8_t command, const uint8_t* data, uint8_t length, uint32_t readyAt);
+
+  // Target in the field
+  bool present = false;
+  bool isNtag = false;
+  bool selected = false;  // activated by the last InListPassiveTarget
+  uint8_t uid[7] = {0};
+  uint8_t uidLength = 0;
+  uint16_t atqa = 0;
+  uint8_t sak = 0;
+  uint8_t pages[PN532_EMULATOR_PAGES][4];
+  uint8_t dropCount = 0;
+
+  // Chip state
+  bool samDone = false;
+  uint8_t activationRetries = 0xFF;
+  Pending pending = PENDING_NONE;
+  uint32_t ackAt = 0;
+  uint32_t responseAt = 0;
+  bool hasResponse = false;  // false: the command never completes
+  uint8_t response[PN532_EMULATOR_MAX_FRAME];
+  uint8_t responseLength = 0;
+};
@@ -0,0 +1,37 @@
+#include "PwmRender.h"
+
+const int32_t OUTPUT_LSB = 256;  // one duty step in 16-bit units
+// Clipping makes the error grow without bound; limiting it keeps the loop stable
+const int32_t ERROR_LIMIT = 2 * OUTPUT_LSB;
+
+void PwmRenderer::reset() {
+  error1 = 0;
+  error2 = 0;
+  seed = 1;
+}
+
+void PwmRenderer::render(const int16_t* pcm, size_t frames, uint8_t channels, uint8_t* duty) {
+  for (size_t i = 0; i < frames; i++) {
+    int32_t mono = pcm[i * channels];
+    if (channels == 2) mono = (mono + pcm[i * channels + 1]) / 2;
+    int32_t x = (int32_t)(((int64_t)mono * gain) >> 16);
+
+    // Triangular dither of ±1 output step: the sum of two uniform values
+    seed = seed * 1664525u + 1013904223u;
+    int32_t dither = (int32_t)(seed >> 24) - (int32_t)((seed >> 16) & 0xFF);
+
+    // y = x + e − 2e₁ + e₂: the error, dither included, reaches the output
+    // through (1 − z⁻¹)²
+    int32_t wanted = x;
+    if (shaping) wanted += -2 * error1 + error2;
+    int32_t q = (wanted + dither + OUTPUT_LSB / 2 + 32768) / OUTPUT_LSB - 128;  // rounded, no negative division
+    if (q > 127) q = 127;
+    if (q < -128) q = -128;
+    int32_t error = q * OUTPUT_LSB - wanted;
+    if (error > ERROR_LIMIT) error = ERROR_LIMIT;
+    if (error < -ERROR_LIMIT) error = -ERROR_LIMIT;
+    error2 = error1;
+    error1 = error;
+    duty[i] = (uint8_t)(q + 128);
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== PWM AUDIO RENDER ====================
+// Turns decoded 16-bit PCM into the 8-bit duty values a sigma-delta or PWM
+// pin plays, one per frame, 128 for silence. Plain rounding to 8 bits would
+// leave the noise floor near -48 dB, right where it is heard; second-order
+// error feedback shapes that noise with (1 − z⁻¹)², moving it up towards
+// half the sample rate where the speaker and the RC filter on the pin drop
+// it. A little TPDF dither from a fixed-seed generator keeps quiet passages
+// from turning into idle tones while the output stays bit-exact for a
+// given input, so tools/pwm_render.cpp can compare it against a reference.
+class PwmRenderer {
+ public:
+  void reset();
+  // Q16: 65536 = unity. Volume and track gain are folded into this one
+  // factor before a track starts; the samples see a single multiply.
+  void setGain(uint32_t scale) { gain = scale; }
+  uint32_t gainScale() const { return gain; }
+  // Off gives the plain rounding quantiser, for comparison
+  void setNoiseShaping(bool on) { shaping = on; }
+  // Mixes to mono; duty holds one value per frame
+  void render(const int16_t* pcm, size_t frames, uint8_t channels, uint8_t* duty);
+
+ private:
+  uint32_t gain = 65536;
+  bool shaping = true;
+  int32_t error1 = 0;  // last two quantisation errors, in 16-bit LSB
+  int32_t error2 = 0;
+  uint32_t seed = 1;
+};
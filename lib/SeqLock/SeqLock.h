@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Single-writer sequence lock. publish() never waits: it bumps the sequence
+// to odd, stores the value and bumps it to even again. Readers copy the
+// value and retry if the sequence was odd or changed meanwhile, so they
+// never block the writer and never see a torn value. The value lives in
+// relaxed atomic words, which keeps the concurrent copy well-defined.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+  static const size_t WORDS = (sizeof(T) + 3) / 4;
+
+ public:
+  void publish(const T& value) {
+    uint32_t words[WORDS] = {0};
+    memcpy(words, &value, sizeof(T));
+    uint32_t s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) data[i].store(words[i], std::memory_order_relaxed);
+    sequence.store(s + 2, std::memory_order_release);
+  }
+
+  // One attempt; false if a publish was in progress
+  bool tryRead(T& value) const {
+    uint32_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1) return false;
+    uint32_t words[WORDS];
+    for (size_t i = 0; i < WORDS; i++) words[i] = data[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) != before) return false;
+    memcpy(&value, words, sizeof(T));
+    return true;
+  }
+
+  // Retries until it gets a consistent copy; a publish takes microseconds
+  void read(T& value) const {
+    while (!tryRead(value)) {}
+  }
+
+  uint32_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+ private:
+  std::atomic<uint32_t> sequence{0};
+  std::atomic<uint32_t> data[WORDS] = {};
+};
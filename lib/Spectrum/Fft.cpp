@@ -0,0 +1,79 @@
+#include "Fft.h"
+
+// round(32767 × sin(2πk / 256))
+const int16_t FFT_SINE[FFT_SIZE] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+  30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+  23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279,
+  12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179, 6393, 5602, 4808, 4011, 3212, 2410, 1608, 804,
+  0, -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+  -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+  -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+  -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+  -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+  -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+  -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+  -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011, -3212, -2410, -1608, -804,
+};
+
+static int16_t saturate(int32_t v) { return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v; }
+
+// (re + j·im) × e^(-2πjk/N), Q15 with rounding
+static void rotate(int32_t re, int32_t im, uint16_t k, FftComplex& out) {
+  int32_t c = FFT_SINE[(k + FFT_SIZE / 4) & (FFT_SIZE - 1)];
+  int32_t s = FFT_SINE[k & (FFT_SIZE - 1)];
+  out.re = saturate((re * c + im * s + (1 << 14)) >> 15);
+  out.im = saturate((im * c - re * s + (1 << 14)) >> 15);
+}
+
+// Radix-4 decimation-in-frequency butterflies over spans of 256, 64, 16
+// and 4 points. Inputs are divided by 4 (rounded) first, which keeps every
+// sum in range.
+void fftStage(FftComplex* data, uint8_t stage) {
+  uint16_t span = FFT_SIZE >> (2 * stage);
+  uint16_t quarter = span / 4;
+  uint16_t stride = 1 << (2 * stage);
+  for (uint16_t group = 0; group < FFT_SIZE; group += span) {
+    for (uint16_t n = 0; n < quarter; n++) {
+      FftComplex* x = data + group + n;
+      int32_t ar = (x[0].re + 2) >> 2, ai = (x[0].im + 2) >> 2;
+      int32_t br = (x[quarter].re + 2) >> 2, bi = (x[quarter].im + 2) >> 2;
+      int32_t cr = (x[2 * quarter].re + 2) >> 2, ci = (x[2 * quarter].im + 2) >> 2;
+      int32_t dr = (x[3 * quarter].re + 2) >> 2, di = (x[3 * quarter].im + 2) >> 2;
+      int32_t sumAcR = ar + cr, sumAcI = ai + ci;
+      int32_t difAcR = ar - cr, difAcI = ai - ci;
+      int32_t sumBdR = br + dr, sumBdI = bi + di;
+      int32_t difBdR = br - dr, difBdI = bi - di;
+      uint16_t k = n * stride;
+      x[0].re = saturate(sumAcR + sumBdR);
+      x[0].im = saturate(sumAcI + sumBdI);
+      rotate(difAcR + difBdI, difAcI - difBdR, k, x[quarter]);       // (a − c) − j(b − d)
+      rotate(sumAcR - sumBdR, sumAcI - sumBdI, 2 * k, x[2 * quarter]);  // (a + c) − (b + d)
+      rotate(difAcR - difBdI, difAcI + difBdR, 3 * k, x[3 * quarter]);  // (a − c) + j(b − d)
+    }
+  }
+}
+
+uint8_t fftBinIndex(uint8_t bin) {
+  return (bin & 0x03) << 6 | (bin & 0x0C) << 2 | (bin & 0x30) >> 2 | (bin & 0xC0) >> 6;
+}
+
+void fftReorder(FftComplex* data) {
+  for (uint16_t i = 0; i < FFT_SIZE; i++) {
+    uint8_t j = fftBinIndex(i);
+    if (j > i) {
+      FftComplex t = data[i];
+      data[i] = data[j];
+      data[j] = t;
+    }
+  }
+}
+
+void fft256(FftComplex* data) {
+  for (uint8_t stage = 0; stage < FFT_STAGES; stage++) fftStage(data, stage);
+  fftReorder(data);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+// ==================== FIXED-POINT FFT ====================
+// 256-point complex FFT on Q15 samples: radix-4, decimation in frequency,
+// in place, integer only (the ESP32-C3 has no FPU). Every stage divides by
+// 4, so the result is the DFT / 256 and nothing can overflow. Stages are
+// separate calls, so a caller on a time budget can spread one transform
+// over several slots.
+const uint8_t FFT_STAGES = 4;
+const uint16_t FFT_SIZE = 256;  // 4^FFT_STAGES
+
+struct FftComplex {
+  int16_t re;
+  int16_t im;
+};
+
+// Q15 sine over one period, FFT_SIZE steps; cosine is a quarter further on
+extern const int16_t FFT_SINE[FFT_SIZE];
+
+void fftStage(FftComplex* data, uint8_t stage);  // stage 0..FFT_STAGES-1
+// After the stages, bin k is at data[fftBinIndex(k)] (base-4 digit
+// reversal); fftReorder puts every bin in place.
+uint8_t fftBinIndex(uint8_t bin);
+void fftReorder(FftComplex* data);
+void fft256(FftComplex* data);  // all stages, then the reorder
@@ -0,0 +1,78 @@
+#include "Spectrum.h"
+#include <string.h>
+
+// First bin of each band and the end of the last; at 11 kHz a bin is
+// 43 Hz, so the bands start at 43, 86, 172, 301, 516, 861, 1507 and 2670 Hz.
+const uint8_t BAND_EDGES[SPECTRUM_BANDS + 1] = {1, 2, 4, 7, 12, 20, 35, 62, 128};
+// A full-scale tone after the window and the 1/256 scaling of the FFT
+// puts about 2^26.6 into its band, 425 in 1/16 octaves.
+const uint16_t LEVEL_FLOOR = 425 - 255;
+
+void Spectrum::begin(uint32_t sampleRate) {
+  uint32_t factor = (sampleRate + SPECTRUM_TARGET_RATE / 2) / SPECTRUM_TARGET_RATE;
+  decimation = factor < 1 ? 1 : factor > 8 ? 8 : factor;
+  fill = 0;
+  accumulated = 0;
+  accumulator = 0;
+  nextStep = SPECTRUM_STEPS;
+  memset(bandLevels, 0, sizeof(bandLevels));
+}
+
+void Spectrum::feed(const int16_t* pcm, size_t frames, uint8_t channels) {
+  int32_t divisor = decimation * channels;
+  for (size_t i = 0; i < frames; i++) {
+    for (uint8_t c = 0; c < channels; c++) accumulator += pcm[i * channels + c];
+    if (++accumulated < decimation) continue;
+    input[fill++] = accumulator / divisor;
+    accumulator = 0;
+    accumulated = 0;
+    if (fill < FFT_SIZE) continue;
+    fill = 0;
+    if (busy()) {
+      skipped++;
+      continue;
+    }
+    // Hann window, sin²(πn/N) = (1 − cos(2πn/N)) / 2
+    for (uint16_t n = 0; n < FFT_SIZE; n++) {
+      int32_t hann = (32767 - FFT_SINE[(n + FFT_SIZE / 4) & (FFT_SIZE - 1)]) >> 1;
+      work[n].re = (input[n] * hann) >> 15;
+      work[n].im = 0;
+    }
+    nextStep = 0;
+  }
+}
+
+bool Spectrum::step() {
+  if (!busy()) return false;
+  if (nextStep < FFT_STAGES) {
+    fftStage(work, nextStep++);
+    return false;
+  }
+  computeLevels();
+  nextStep = SPECTRUM_STEPS;
+  analysed++;
+  return true;
+}
+
+// log2(x) in 1/16 steps: the position of the top bit and the four bits below it
+static uint16_t log2Sixteenths(uint64_t x) {
+  if (x == 0) return 0;
+  uint8_t bits = 63 - __builtin_clzll(x);
+  uint64_t normalized = x << (63 - bits);
+  return bits * 16 + ((normalized >> 59) & 0x0F);
+}
+
+void Spectrum::computeLevels() {
+  for (uint8_t band = 0; band < SPECTRUM_BANDS; band++) {
+    uint64_t energy = 0;
+    for (uint8_t bin = BAND_EDGES[band]; bin < BAND_EDGES[band + 1]; bin++) {
+      int32_t re = work[fftBinIndex(bin)].re;
+      int32_t im = work[fftBinIndex(bin)].im;
+      energy += (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+    uint16_t log = log2Sixteenths(energy);
+    uint8_t level = log <= LEVEL_FLOOR ? 0 : log - LEVEL_FLOOR > 255 ? 255 : log - LEVEL_FLOOR;
+    uint8_t decayed = bandLevels[band] > SPECTRUM_DECAY ? bandLevels[band] - SPECTRUM_DECAY : 0;
+    bandLevels[band] = level > decayed ? level : decayed;
+  }
+}
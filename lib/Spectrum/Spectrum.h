@@ -0,0 +1,47 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "Fft.h"
+
+// ==================== SPECTRUM ====================
+// Band levels for the LED visualiser, from the audio as it is decoded.
+// Blocks are mixed to mono and decimated to about 11 kHz on the way in (a
+// plain average, enough for lights); every FFT_SIZE decimated samples,
+// about 23 ms, make one Hann-windowed window. Analysing a window takes
+// SPECTRUM_STEPS calls to step(), one FFT stage each plus the band levels,
+// so the caller decides after every step whether its budget allows
+// another. A window that completes while the previous one is still being
+// analysed is dropped.
+const uint8_t SPECTRUM_BANDS = 8;
+const uint32_t SPECTRUM_TARGET_RATE = 11025;
+const uint8_t SPECTRUM_STEPS = FFT_STAGES + 1;
+// Levels are 1/16 octave of band energy above the floor, so 0..255 covers
+// 48 dB below a full-scale tone; they rise at once and fall by
+// SPECTRUM_DECAY per window.
+const uint8_t SPECTRUM_DECAY = 8;
+
+class Spectrum {
+ public:
+  void begin(uint32_t sampleRate);
+  void feed(const int16_t* pcm, size_t frames, uint8_t channels);
+  bool busy() const { return nextStep < SPECTRUM_STEPS; }
+  // Runs the next step of the pending window; true when it produced new levels
+  bool step();
+  const uint8_t* levels() const { return bandLevels; }
+  uint32_t windows() const { return analysed; }
+  uint32_t dropped() const { return skipped; }
+
+ private:
+  void computeLevels();
+
+  FftComplex work[FFT_SIZE];
+  uint8_t nextStep = SPECTRUM_STEPS;
+  int16_t input[FFT_SIZE];
+  uint16_t fill = 0;
+  uint8_t decimation = 1;
+  uint8_t accumulated = 0;
+  int32_t accumulator = 0;
+  uint8_t bandLevels[SPECTRUM_BANDS] = {};
+  uint32_t analysed = 0;
+  uint32_t skipped = 0;
+};
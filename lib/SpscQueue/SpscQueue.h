@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// Single-producer/single-consumer ring buffer. push() and pop() never block
+// and never take a lock, so a task on one core can feed a task on the other
+// without either of them ever waiting. Capacity must be a power of two.
+template <typename T, uint16_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+ public:
+  bool push(const T& item) {
+    uint16_t h = head.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - tail.load(std::memory_order_acquire)) == Capacity) return false;
+    items[h & (Capacity - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // A snapshot: the other side may have pushed or popped since
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+  bool pop(T& item) {
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    item = items[t & (Capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  T items[Capacity];
+  std::atomic<uint16_t> head{0};
+  std::atomic<uint16_t> tail{0};
+};
@@ -0,0 +1,127 @@
+#include "StatsDump.h"
+#include <string.h>
+
+namespace {
+
+struct Writer {
+  uint8_t* out;
+  size_t capacity;
+  size_t length = 0;
+  bool ok = true;
+
+  void bytes(const void* data, size_t n) {
+    if (length + n > capacity) {
+      ok = false;
+      return;
+    }
+    memcpy(out + length, data, n);
+    length += n;
+  }
+  void u8(uint8_t v) { bytes(&v, 1); }
+  void u16(uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    bytes(b, 2);
+  }
+  void u32(uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    bytes(b, 4);
+  }
+  void string(const char* s) {
+    size_t n = strnlen(s, STATS_DUMP_MAX_STRING);
+    u8(n);
+    bytes(s, n);
+  }
+};
+
+struct Reader {
+  const uint8_t* in;
+  size_t length;
+  size_t pos = 0;
+  bool ok = true;
+
+  const uint8_t* take(size_t n) {
+    if (!ok || pos + n > length) {
+      ok = false;
+      return nullptr;
+    }
+    const uint8_t* p = in + pos;
+    pos += n;
+    return p;
+  }
+  uint8_t u8() {
+    const uint8_t* p = take(1);
+    return p ? p[0] : 0;
+  }
+  uint16_t u16() {
+    const uint8_t* p = take(2);
+    return p ? p[0] | (p[1] << 8) : 0;
+  }
+  uint32_t u32() {
+    const uint8_t* p = take(4);
+    return p ? p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24) : 0;
+  }
+  void string(char* s) {
+    uint8_t n = u8();
+    if (n > STATS_DUMP_MAX_STRING) ok = false;
+    const uint8_t* p = take(n);
+    if (!p) return;
+    memcpy(s, p, n);
+    s[n] = '\0';
+  }
+};
+
+}  // namespace
+
+size_t encodeStatsDump(const StatsDump& dump, uint8_t* out, size_t capacity) {
+  Writer w{out, capacity};
+  w.bytes("AMBS", 4);
+  w.u8(STATS_DUMP_FORMAT);
+  w.string(dump.firmware);
+  w.string(dump.deviceId);
+  w.u32(dump.bootId);
+  w.u32(dump.uptimeSeconds);
+  w.u32(dump.detections);
+  w.u32(dump.plays);
+  w.u32(dump.readFailures);
+  w.u32(dump.graceStops);
+
+  const Histogram& h = dump.tagToPlayMicros;
+  uint16_t used = 0;
+  for (uint16_t i = 0; i < Histogram::BUCKET_COUNT; i++) used += h.bucket(i) != 0;
+  w.u32(h.maxValue());
+  w.u16(used);
+  for (uint16_t i = 0; i < Histogram::BUCKET_COUNT; i++) {
+    if (h.bucket(i) == 0) continue;
+    w.u16(i);
+    w.u32(h.bucket(i));
+  }
+  return w.ok ? w.length : 0;
+}
+
+size_t decodeStatsDump(const uint8_t* in, size_t length, StatsDump& dump) {
+  dump = StatsDump();
+  Reader r{in, length};
+  const uint8_t* magic = r.take(4);
+  if (!magic || memcmp(magic, "AMBS", 4) != 0 || r.u8() != STATS_DUMP_FORMAT) return 0;
+  r.string(dump.firmware);
+  r.string(dump.deviceId);
+  dump.bootId = r.u32();
+  dump.uptimeSeconds = r.u32();
+  dump.detections = r.u32();
+  dump.plays = r.u32();
+  dump.readFailures = r.u32();
+  dump.graceStops = r.u32();
+
+  uint32_t maximum = r.u32();
+  uint16_t used = r.u16();
+  if (used > Histogram::BUCKET_COUNT) return 0;
+  for (uint16_t i = 0; i < used && r.ok; i++) {
+    uint16_t index = r.u16();
+    uint32_t count = r.u32();
+    if (index >= Histogram::BUCKET_COUNT) return 0;
+    dump.tagToPlayMicros.addToBucket(index, count);
+  }
+  if (!r.ok) return 0;
+  dump.tagToPlayMicros.setMaxValue(maximum);
+  return r.pos;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <Histogram.h>
+
+// ==================== STATS DUMP FORMAT ====================
+// Binary snapshot of one box's counters for fleet tools. Little-endian:
+//   "AMBS" <format = 1>
+//   <len> <firmware version>  <len> <device id>
+//   <boot id u32> <uptime s u32> <detections u32> <plays u32>
+//   <read failures u32> <grace stops u32>
+//   <tag-to-play max u32> <bucket count u16>, then per non-empty bucket
+//   <index u16> <count u32>
+// Counters are totals since boot. The boot id is random per boot, so a
+// tool can keep the newest snapshot of each boot and never count twice.
+// Dumps can be concatenated; decoding reports how many bytes it used.
+const uint8_t STATS_DUMP_FORMAT = 1;
+const uint8_t STATS_DUMP_MAX_STRING = 23;
+const size_t STATS_DUMP_MAX_SIZE =
+    5 + 2 * (1 + STATS_DUMP_MAX_STRING) + 6 * 4 + 4 + 2 + Histogram::BUCKET_COUNT * 6;
+
+struct StatsDump {
+  char firmware[STATS_DUMP_MAX_STRING + 1] = "";
+  char deviceId[STATS_DUMP_MAX_STRING + 1] = "";
+  uint32_t bootId = 0;
+  uint32_t uptimeSeconds = 0;
+  uint32_t detections = 0;
+  uint32_t plays = 0;
+  uint32_t readFailures = 0;
+  uint32_t graceStops = 0;
+  Histogram tagToPlayMicros;
+};
+
+// Returns the encoded size, or 0 if capacity is too small
+size_t encodeStatsDump(const StatsDump& dump, uint8_t* out, size_t capacity);
+// Returns the bytes consumed, or 0 if the input is not a complete dump
+size_t decodeStatsDump(const uint8_t* in, size_t length, StatsDump& dump);
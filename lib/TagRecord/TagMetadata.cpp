@@ -0,0 +1,87 @@
+#include "TagMetadata.h"
+#include <string.h>
+
+static uint8_t payloadChecksum(const uint8_t* payload, uint8_t length) {
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < length; i++) sum += payload[i];
+  return sum;
+}
+
+bool parseTagMetadataHeader(const uint8_t* page, TagMetadataHeader& header) {
+  header = TagMetadataHeader();
+  if (page[0] != 'M' || page[1] != 'D' || page[2] == 0 || page[2] > TAG_METADATA_MAX_PAYLOAD) return false;
+  header.length = page[2];
+  header.checksum = page[3];
+  return true;
+}
+
+bool parseTagMetadata(const uint8_t* payload, const TagMetadataHeader& header, TagMetadata& metadata) {
+  metadata = TagMetadata();
+  if (payloadChecksum(payload, header.length) != header.checksum) return false;
+
+  uint8_t pos = 0;
+  while (pos + 2 <= header.length) {
+    uint8_t type = payload[pos];
+    uint8_t length = payload[pos + 1];
+    const uint8_t* value = payload + pos + 2;
+    if (pos + 2 + length > header.length) return false;
+    pos += 2 + length;
+
+    // Unknown fields are skipped, so newer tags still play on older boxes
+    if (type == TAG_META_TITLE) {
+      uint8_t n = length < TAG_TITLE_MAX ? length : TAG_TITLE_MAX;
+      memcpy(metadata.title, value, n);
+      metadata.title[n] = '\0';
+    } else if (type == TAG_META_ARTWORK && length == 1) {
+      metadata.artwork = value[0];
+    } else if (type == TAG_META_TRACK_COUNT && length == 1) {
+      metadata.trackCount = value[0];
+    } else if (type == TAG_META_CHAPTERS) {
+      metadata.chapterCount = 0;
+      for (uint8_t i = 0; i + 1 < length && metadata.chapterCount < TAG_MAX_CHAPTERS; i += 2) {
+        metadata.chapters[metadata.chapterCount++] = (value[i] << 8) | value[i + 1];
+      }
+    }
+  }
+  return true;
+}
+
+uint8_t encodeTagMetadata(const TagMetadata& metadata, uint8_t* pages) {
+  uint8_t* payload = pages + 4;
+  uint16_t length = 0;
+  uint8_t titleLength = strnlen(metadata.title, TAG_TITLE_MAX);
+  if (titleLength > 0) {
+    payload[length++] = TAG_META_TITLE;
+    payload[length++] = titleLength;
+    memcpy(payload + length, metadata.title, titleLength);
+    length += titleLength;
+  }
+  if (metadata.artwork != TAG_ARTWORK_NONE) {
+    payload[length++] = TAG_META_ARTWORK;
+    payload[length++] = 1;
+    payload[length++] = metadata.artwork;
+  }
+  if (metadata.trackCount > 0) {
+    payload[length++] = TAG_META_TRACK_COUNT;
+    payload[length++] = 1;
+    payload[length++] = metadata.trackCount;
+  }
+  if (metadata.chapterCount > 0) {
+    uint8_t count = metadata.chapterCount < TAG_MAX_CHAPTERS ? metadata.chapterCount : TAG_MAX_CHAPTERS;
+    payload[length++] = TAG_META_CHAPTERS;
+    payload[length++] = 2 * count;
+    for (uint8_t i = 0; i < count; i++) {
+      payload[length++] = metadata.chapters[i] >> 8;
+      payload[length++] = metadata.chapters[i] & 0xFF;
+    }
+  }
+  if (length == 0 || length > TAG_METADATA_MAX_PAYLOAD) return 0;
+
+  uint8_t pageCount = 1 + (length + 3) / 4;
+  memset(payload + length, 0, (pageCount - 1) * 4 - length);
+  pages[0] = 'M';
+  pages[1] = 'D';
+  pages[2] = length;
+  pages[3] = payloadChecksum(payload, length);
+  return pageCount;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+// ==================== EXTENDED TAG METADATA ====================
+// Optional metadata follows the record slots, starting in page 8:
+//   'M' 'D' <length> <checksum>   length = payload bytes, checksum = their sum
+// and the payload from page 9 on is a list of <type> <length> <value...>:
+//   0x01 title, UTF-8, up to 32 bytes
+//   0x02 artwork index
+//   0x03 track count of the playlist folder
+//   0x04 chapter starts, big-endian seconds, up to 16
+// Pages 8 and 9 come back with the record read; everything after that is
+// fetched in the background once playback has started.
+const uint8_t TAG_METADATA_PAGE = 8;
+const uint8_t TAG_METADATA_PAYLOAD_PAGE = 9;
+const uint8_t TAG_METADATA_MAX_PAYLOAD = 124;  // NTAG213 ends at page 39
+const uint8_t TAG_TITLE_MAX = 32;
+const uint8_t TAG_MAX_CHAPTERS = 16;
+const uint8_t TAG_ARTWORK_NONE = 0xFF;
+
+enum TagMetadataField : uint8_t {
+  TAG_META_TITLE = 1,
+  TAG_META_ARTWORK,
+  TAG_META_TRACK_COUNT,
+  TAG_META_CHAPTERS,
+};
+
+struct TagMetadataHeader {
+  uint8_t length = 0;  // 0 = tag has no metadata
+  uint8_t checksum = 0;
+};
+
+struct TagMetadata {
+  char title[TAG_TITLE_MAX + 1] = "";
+  uint8_t artwork = TAG_ARTWORK_NONE;
+  uint8_t trackCount = 0;  // 0 if unknown
+  uint8_t chapterCount = 0;
+  uint16_t chapters[TAG_MAX_CHAPTERS] = {0};
+};
+
+// page: the 4 bytes of page 8
+bool parseTagMetadataHeader(const uint8_t* page, TagMetadataHeader& header);
+// payload: header.length bytes from page 9 on; false on checksum mismatch
+bool parseTagMetadata(const uint8_t* payload, const TagMetadataHeader& header, TagMetadata& metadata);
+// Fills pages 8.. (header page included, zero padded) and returns the page
+// count, or 0 if the metadata does not fit.
+uint8_t encodeTagMetadata(const TagMetadata& metadata, uint8_t* pages);
@@ -0,0 +1,127 @@
+#include "TagRecord.h"
+
+const uint8_t SLOT_FORMAT = 'R';
+const uint8_t SLOT_CRC = TAG_SLOT_SIZE - 2;
+
+static uint16_t crc16Update(uint16_t crc, uint8_t byte) {
+  crc ^= (uint16_t)byte << 8;
+  for (uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  return crc;
+}
+
+// CRC-16/CCITT-FALSE over the format byte, then the slot up to its CRC
+static uint16_t slotCrc(const uint8_t* slot) {
+  uint16_t crc = crc16Update(0xFFFF, SLOT_FORMAT);
+  for (uint8_t i = 0; i < SLOT_CRC; i++) crc = crc16Update(crc, slot[i]);
+  return crc;
+}
+
+static bool validRecord(const TagRecord& record) {
+  if (record.type == TAG_RECORD_SONG) return record.track >= 1 && record.track <= 99;
+  if (record.type == TAG_RECORD_CONTROL) return record.command != 0 && record.command < CONTROL_COMMAND_COUNT;
+  return false;
+}
+
+static bool parseSlot(const uint8_t* slot, TagRecord& record) {
+  record = TagRecord();
+  if (slotCrc(slot) != (slot[SLOT_CRC] << 8 | slot[SLOT_CRC + 1])) return false;
+  record.sequence = slot[0];
+  if (slot[1] == 'S') {
+    record.type = TAG_RECORD_SONG;
+    record.track = slot[2];
+    record.volume = slot[4];
+    record.eq = slot[5];
+  } else if (slot[1] == 'C') {
+    record.type = TAG_RECORD_CONTROL;
+    record.command = slot[2];
+    record.argument = slot[3];
+  }
+  return validRecord(record);
+}
+
+static bool parseSingleRecord(const uint8_t* pages, TagRecord& record) {
+  record = TagRecord();
+  const uint8_t* page = pages;
+  if (page[0] == 'S' && page[1] == 'O' && page[2] == 'N') {
+    record.type = TAG_RECORD_SONG;
+    record.track = page[3];
+    const uint8_t* preset = pages + TAG_PAGE_SIZE;
+    if (preset[0] == 'P' && preset[1] == 'R') {
+      record.volume = preset[2];
+      record.eq = preset[3];
+    }
+  } else if (page[0] == 'C' && page[1] == 'T') {
+    record.type = TAG_RECORD_CONTROL;
+    record.command = page[2];
+    record.argument = page[3];
+  }
+  return validRecord(record);
+}
+
+// -1 if neither slot is valid. Sequence numbers wrap, so "newer" is
+// decided by the signed difference.
+static int newestSlot(const uint8_t* pages, TagRecord& record) {
+  TagRecord a, b;
+  bool validA = parseSlot(pages, a);
+  bool validB = parseSlot(pages + TAG_SLOT_SIZE, b);
+  if (validA && (!validB || (int8_t)(a.sequence - b.sequence) > 0)) {
+    record = a;
+    return 0;
+  }
+  if (validB) {
+    record = b;
+    return 1;
+  }
+  return -1;
+}
+
+bool parseTagRecord(const uint8_t* pages, TagRecord& record) {
+  if (newestSlot(pages, record) >= 0) return true;
+  return parseSingleRecord(pages, record);
+}
+
+// A tag with no valid slot gets slot B first: an old single record in
+// page 4 then survives a torn write.
+uint8_t encodeTagRecord(const TagRecord& record, uint8_t* pages) {
+  TagRecord newest;
+  int current = newestSlot(pages, newest);
+  uint8_t target = current == 1 ? 0 : 1;
+  uint8_t* slot = pages + target * TAG_SLOT_SIZE;
+  slot[0] = current >= 0 ? newest.sequence + 1 : 1;
+  slot[1] = record.type == TAG_RECORD_CONTROL ? 'C' : 'S';
+  slot[2] = record.type == TAG_RECORD_CONTROL ? record.command : record.track;
+  slot[3] = record.argument;
+  slot[4] = record.volume;
+  slot[5] = record.eq;
+  uint16_t crc = slotCrc(slot);
+  slot[SLOT_CRC] = crc >> 8;
+  slot[SLOT_CRC + 1] = crc;
+  return target;
+}
+
+TagRecord songRecord(uint8_t track, uint8_t volume, uint8_t eq) {
+  TagRecord record;
+  record.type = TAG_RECORD_SONG;
+  record.track = track;
+  record.volume = volume;
+  record.eq = eq;
+  return record;
+}
+
+TagRecord controlRecord(uint8_t command, uint8_t argument) {
+  TagRecord record;
+  record.type = TAG_RECORD_CONTROL;
+  record.command = command;
+  record.argument = argument;
+  return record;
+}
+
+const char* controlCommandName(uint8_t command) {
+  switch (command) {
+    case CONTROL_SET_VOLUME: return "volume";
+    case CONTROL_TOGGLE_SHUFFLE: return "shuffle";
+    case CONTROL_SLEEP_TIMER: return "sleep";
+    case CONTROL_LOCK_BUTTONS: return "lock";
+    default: return "unknown";
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+// ==================== TAG RECORD FORMAT ====================
+// Pages 4..7 hold two 8-byte record slots, A in pages 4-5 and B in 6-7:
+//   <seq> <type> <track|command> <arg> <volume> <eq> <crc16>
+// Type 'S' plays track 1..99, type 'C' is a control tag handled on the box
+// itself; volume or eq 0xFF leaves that setting alone. The CRC is
+// CRC-16/CCITT-FALSE, big-endian, over a format byte 'R' and the six bytes
+// before it: a write torn between the slot's two pages leaves the first
+// page new and the second old, and 16 bits let only one such tear in
+// 65536 through. A write always goes into the slot that
+// does not hold the newest valid record, with the next sequence number, so
+// a tag pulled away mid-write still reads as its previous record. Both
+// slots come back from a single NTAG READ.
+//
+// Tags written by older firmware have one record in page 4 and are still
+// read:
+//   'S' 'O' 'N' <track>, optionally page 5 'P' 'R' <volume> <eq>
+//   'C' 'T' <command> <arg>
+const uint8_t TAG_RECORD_PAGE = 4;
+const uint8_t TAG_RECORD_PAGES = 4;
+const uint8_t TAG_PAGE_SIZE = 4;
+const uint8_t TAG_SLOT_SIZE = 8;
+const uint8_t TAG_PRESET_NONE = 0xFF;
+
+enum TagRecordType : uint8_t {
+  TAG_RECORD_INVALID,
+  TAG_RECORD_SONG,
+  TAG_RECORD_CONTROL,
+};
+
+enum ControlCommand : uint8_t {
+  CONTROL_SET_VOLUME = 1,  // arg: volume 0..30
+  CONTROL_TOGGLE_SHUFFLE,  // arg: unused
+  CONTROL_SLEEP_TIMER,     // arg: minutes, 0 cancels
+  CONTROL_LOCK_BUTTONS,    // arg: unused, toggles
+  CONTROL_COMMAND_COUNT,
+};
+
+struct TagRecord {
+  TagRecordType type = TAG_RECORD_INVALID;
+  uint8_t track = 0;
+  uint8_t command = 0;
+  uint8_t argument = 0;
+  uint8_t volume = TAG_PRESET_NONE;
+  uint8_t eq = TAG_PRESET_NONE;
+  uint8_t sequence = 0;  // of the slot it came from, 0 for old single records
+};
+
+// pages: the 16 bytes of pages 4..7
+bool parseTagRecord(const uint8_t* pages, TagRecord& record);
+// pages: the current 16 bytes of pages 4..7, updated in place. Only the
+// target slot changes; the returned slot index (0 = A, 1 = B) tells which.
+uint8_t encodeTagRecord(const TagRecord& record, uint8_t* pages);
+TagRecord songRecord(uint8_t track, uint8_t volume = TAG_PRESET_NONE, uint8_t eq = TAG_PRESET_NONE);
+TagRecord controlRecord(uint8_t command, uint8_t argument);
+const char* controlCommandName(uint8_t command);
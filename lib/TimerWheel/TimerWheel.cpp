@@ -0,0 +1,134 @@
+#include "TimerWheel.h"
+
+static inline uint8_t levelShift(uint8_t level) { return level * TimerWheel::SLOT_BITS; }
+
+TimerWheel::TimerWheel() {
+  for (uint8_t level = 0; level < LEVELS; level++) {
+    for (uint8_t slot = 0; slot < SLOTS; slot++) {
+      WheelTimer& head = slots[level][slot].head;
+      head.next = head.prev = &head;
+    }
+  }
+}
+
+void TimerWheel::begin(uint32_t now) { current = now; }
+
+void TimerWheel::arm(WheelTimer& timer, uint32_t expiry) {
+  if (timer.armed()) cancel(timer);
+  timer.expiry = expiry;
+  insert(timer);
+  count++;
+}
+
+void TimerWheel::cancel(WheelTimer& timer) {
+  if (!timer.armed()) return;
+  timer.prev->next = timer.next;
+  timer.next->prev = timer.prev;
+  WheelTimer& head = slots[timer.level][timer.slot].head;
+  if (head.next == &head) occupied[timer.level] &= ~(1ULL << timer.slot);
+  timer.next = timer.prev = nullptr;
+  count--;
+}
+
+void TimerWheel::insert(WheelTimer& timer) {
+  int32_t delta = (int32_t)(timer.expiry - current);
+  uint32_t when = delta < 0 ? current : timer.expiry;
+  uint32_t distance = when - current;
+
+  uint8_t level = 0;
+  while (level < LEVELS - 1 && distance >= (1UL << levelShift(level + 1))) level++;
+  if (level == LEVELS - 1) {
+    uint32_t limit = (1UL << levelShift(LEVELS)) - 1;
+    if (distance > limit) when = current + limit;
+  }
+  uint8_t slot = (when >> levelShift(level)) & (SLOTS - 1);
+
+  WheelTimer& head = slots[level][slot].head;
+  timer.level = level;
+  timer.slot = slot;
+  timer.next = &head;
+  timer.prev = head.prev;
+  head.prev->next = &timer;
+  head.prev = &timer;
+  occupied[level] |= 1ULL << slot;
+}
+
+// Re-files every timer of a higher-level slot relative to the current tick.
+void TimerWheel::cascade(uint8_t level, uint8_t slot) {
+  WheelTimer& head = slots[level][slot].head;
+  WheelTimer* timer = head.next;
+  head.next = head.prev = &head;
+  occupied[level] &= ~(1ULL << slot);
+  while (timer != &head) {
+    WheelTimer* following = timer->next;
+    insert(*timer);
+    timer = following;
+  }
+}
+
+void TimerWheel::fireSlot(uint8_t slot) {
+  // Detach the whole list first so callbacks can re-arm freely
+  WheelTimer& head = slots[0][slot].head;
+  if (head.next == &head) return;
+  WheelTimer* timer = head.next;
+  head.prev->next = nullptr;
+  head.next = head.prev = &head;
+  occupied[0] &= ~(1ULL << slot);
+
+  while (timer) {
+    WheelTimer* following = timer->next;
+    timer->next = timer->prev = nullptr;
+    count--;
+    if (timer->callback) timer->callback(timer->context);
+    timer = following;
+  }
+}
+
+void TimerWheel::advance(uint32_t now) {
+  while ((int32_t)(now - current) >= 0) {
+    uint32_t tick;
+    if (!nextExpiry(tick) || (int32_t)(tick - now) > 0) {
+      current = now + 1;
+      return;
+    }
+    current = tick;
+    for (uint8_t level = LEVELS - 1; level > 0; level--) {
+      uint32_t mask = (1UL << levelShift(level)) - 1;
+      if ((tick & mask) == 0) cascade(level, (tick >> levelShift(level)) & (SLOTS - 1));
+    }
+    current = tick + 1;
+    fireSlot(tick & (SLOTS - 1));
+  }
+}
+
+bool TimerWheel::firstSetFrom(uint64_t bits, uint8_t from, uint8_t& distance) {
+  if (!bits) return false;
+  uint64_t rotated = (bits >> from) | (from ? bits << (SLOTS - from) : 0);
+  distance = __builtin_ctzll(rotated);
+  return true;
+}
+
+bool TimerWheel::nextExpiry(uint32_t& tick) const {
+  if (count == 0) return false;
+  bool found = false;
+  int32_t best = 0;
+
+  uint8_t distance;
+  if (firstSetFrom(occupied[0], current & (SLOTS - 1), distance)) {
+    best = distance;
+    found = true;
+  }
+  // A higher level has work at the start of its next occupied block
+  for (uint8_t level = 1; level < LEVELS; level++) {
+    uint8_t shift = levelShift(level);
+    uint32_t block = (current + (1UL << shift) - 1) >> shift;
+    if (!firstSetFrom(occupied[level], block & (SLOTS - 1), distance)) continue;
+    int32_t candidate = (int32_t)(((block + distance) << shift) - current);
+    if (!found || candidate < best) {
+      best = candidate;
+      found = true;
+    }
+  }
+  tick = current + best;
+  return found;
+}
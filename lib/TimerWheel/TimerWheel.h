@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+// Hierarchical timer wheel with 1 ms ticks: four levels of 64 slots cover
+// 64 ms, 4 s, 4.4 min and 4.6 h. Timers are intrusive list nodes, so arm()
+// and cancel() are O(1) and need no allocation. A bitmap per level makes
+// nextExpiry() O(1) as well, so the caller can sleep until exactly the next
+// tick with work instead of scanning deadlines on every pass. Timers further
+// out than the top level are parked there and re-filed when it cascades.
+typedef void (*TimerCallback)(void* context);
+
+struct WheelTimer {
+  TimerCallback callback = nullptr;
+  void* context = nullptr;
+  uint32_t expiry = 0;
+  WheelTimer* next = nullptr;
+  WheelTimer* prev = nullptr;  // non-null while armed
+  uint8_t level = 0;
+  uint8_t slot = 0;
+
+  bool armed() const { return prev != nullptr; }
+};
+
+class TimerWheel {
+ public:
+  static const uint8_t LEVELS = 4;
+  static const uint8_t SLOT_BITS = 6;
+  static const uint8_t SLOTS = 1 << SLOT_BITS;
+
+  TimerWheel();
+
+  // All times are millis()-style tick counts; wrap-around is handled.
+  void begin(uint32_t now);
+  void arm(WheelTimer& timer, uint32_t expiry);
+  void cancel(WheelTimer& timer);
+  // Fires every timer due at or before `now`. Callbacks may arm and
+  // cancel timers, including themselves.
+  void advance(uint32_t now);
+  // Earliest tick at which advance() has work (a timer or a cascade).
+  // Returns false when no timer is armed.
+  bool nextExpiry(uint32_t& tick) const;
+  uint16_t armedCount() const { return count; }
+
+ private:
+  struct Slot {
+    WheelTimer head;  // sentinel of a circular list
+  };
+
+  void insert(WheelTimer& timer);
+  void cascade(uint8_t level, uint8_t slot);
+  void fireSlot(uint8_t slot);
+  static bool firstSetFrom(uint64_t bits, uint8_t from, uint8_t& distance);
+
+  Slot slots[LEVELS][SLOTS];
+  uint64_t occupied[LEVELS] = {0};
+  uint32_t current = 0;  // next tick to process
+  uint16_t count = 0;
+};
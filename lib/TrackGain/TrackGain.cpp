@@ -0,0 +1,91 @@
+#include "TrackGain.h"
+#include <math.h>
+#include <string.h>
+
+static uint16_t key(uint8_t folder, uint8_t track) { return folder << 8 | track; }
+
+// Index of the entry, or -(insertion point) - 1
+int32_t TrackGainTable::search(uint8_t folder, uint8_t track) const {
+  uint16_t wanted = key(folder, track);
+  int32_t low = 0;
+  int32_t high = (int32_t)count - 1;
+  while (low <= high) {
+    int32_t middle = (low + high) / 2;
+    uint16_t k = key(entries[middle].folder, entries[middle].track);
+    if (k == wanted) return middle;
+    if (k < wanted) low = middle + 1;
+    else high = middle - 1;
+  }
+  return -low - 1;
+}
+
+bool TrackGainTable::set(uint8_t folder, uint8_t track, int8_t gain) {
+  int32_t index = search(folder, track);
+  if (index >= 0) {
+    if (gain != 0) {
+      entries[index].gain = gain;
+    } else {
+      memmove(entries + index, entries + index + 1, (count - index - 1) * sizeof(TrackGainEntry));
+      count--;
+    }
+    return true;
+  }
+  if (gain == 0) return true;
+  if (count == TRACK_GAIN_MAX_ENTRIES) return false;
+  index = -index - 1;
+  memmove(entries + index + 1, entries + index, (count - index) * sizeof(TrackGainEntry));
+  entries[index] = {folder, track, gain};
+  count++;
+  return true;
+}
+
+int8_t TrackGainTable::find(uint8_t folder, uint8_t track) const {
+  int32_t index = search(folder, track);
+  return index >= 0 ? entries[index].gain : 0;
+}
+
+size_t TrackGainTable::encode(uint8_t* out, size_t capacity) const {
+  size_t encoded = encodedSize(count);
+  if (capacity < encoded) return 0;
+  memcpy(out, "AMTG", 4);
+  out[4] = TRACK_GAIN_FORMAT;
+  out[5] = count;
+  out[6] = count >> 8;
+  uint8_t* p = out + TRACK_GAIN_HEADER_SIZE;
+  for (uint16_t i = 0; i < count; i++, p += TRACK_GAIN_ENTRY_SIZE) {
+    p[0] = entries[i].folder;
+    p[1] = entries[i].track;
+    p[2] = (uint8_t)entries[i].gain;
+  }
+  return encoded;
+}
+
+bool TrackGainTable::decode(const uint8_t* in, size_t length) {
+  count = 0;
+  if (length < TRACK_GAIN_HEADER_SIZE || memcmp(in, "AMTG", 4) != 0 || in[4] != TRACK_GAIN_FORMAT) return false;
+  uint16_t stored = in[5] | in[6] << 8;
+  if (stored > TRACK_GAIN_MAX_ENTRIES || length < encodedSize(stored)) return false;
+  const uint8_t* p = in + TRACK_GAIN_HEADER_SIZE;
+  for (uint16_t i = 0; i < stored; i++, p += TRACK_GAIN_ENTRY_SIZE) {
+    entries[i] = {p[0], p[1], (int8_t)p[2]};
+    if (i > 0 && key(p[0], p[1]) <= key(entries[i - 1].folder, entries[i - 1].track)) return false;
+  }
+  count = stored;
+  return true;
+}
+
+int8_t trackGainFromDb(float db) {
+  float steps = roundf(db * TRACK_GAIN_STEPS_PER_DB);
+  if (steps > INT8_MAX) return INT8_MAX;
+  if (steps < INT8_MIN) return INT8_MIN;
+  return (int8_t)steps;
+}
+
+int8_t dfPlayerVolumeOffset(int8_t gain) {
+  int16_t half = DFPLAYER_GAIN_PER_STEP / 2;
+  return (gain + (gain < 0 ? -half : half)) / DFPLAYER_GAIN_PER_STEP;
+}
+
+uint32_t trackGainScale(int8_t gain) {
+  return (uint32_t)lroundf(65536.0f * powf(10.0f, trackGainDb(gain) / 20.0f));
+}
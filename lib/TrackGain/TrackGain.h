@@ -0,0 +1,67 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ==================== TRACK GAIN ====================
+// Per-track loudness correction. Measuring loudness takes a filtered pass
+// over every sample, far too much for the box, so tools/loudness_scan.cpp
+// does it once on a PC (ITU-R BS.1770 integrated loudness, the measure
+// ReplayGain 2.0 uses) and the box only looks the gain up when a track
+// starts. A quiet audiobook and a loud pop song then play at about the
+// same level without anyone touching the buttons.
+//
+// Gains are in quarter dB, signed 8-bit: ±31.75 dB. Folder 0 holds the
+// single tracks played by number, folders 1..99 the playlists.
+const float TRACK_GAIN_REFERENCE_LUFS = -18.0f;
+const uint8_t TRACK_GAIN_STEPS_PER_DB = 4;
+const uint16_t TRACK_GAIN_MAX_ENTRIES = 1024;
+const uint8_t TRACK_GAIN_FORMAT = 1;
+// "AMTG" <format> <count u16>, then <folder> <track> <gain> per entry,
+// ordered by folder and track
+const size_t TRACK_GAIN_HEADER_SIZE = 4 + 1 + 2;
+const uint8_t TRACK_GAIN_ENTRY_SIZE = 3;
+
+struct TrackGainEntry {
+  uint8_t folder;
+  uint8_t track;
+  int8_t gain;  // quarter dB
+};
+
+class TrackGainTable {
+ public:
+  void clear() { count = 0; }
+  // A gain of 0 removes the entry. False if the table is full.
+  bool set(uint8_t folder, uint8_t track, int8_t gain);
+  // Binary search; 0 for tracks that were never measured
+  int8_t find(uint8_t folder, uint8_t track) const;
+  uint16_t size() const { return count; }
+  const TrackGainEntry& entry(uint16_t index) const { return entries[index]; }
+
+  // Returns the encoded size, or 0 if capacity is too small
+  size_t encode(uint8_t* out, size_t capacity) const;
+  // Leaves the table empty unless the input is a complete, ordered table
+  bool decode(const uint8_t* in, size_t length);
+  static size_t encodedSize(uint16_t count) { return TRACK_GAIN_HEADER_SIZE + count * TRACK_GAIN_ENTRY_SIZE; }
+
+ private:
+  int32_t search(uint8_t folder, uint8_t track) const;
+
+  TrackGainEntry entries[TRACK_GAIN_MAX_ENTRIES];
+  uint16_t count = 0;
+};
+
+// Rounded to the nearest quarter dB and clamped to the int8 range
+int8_t trackGainFromDb(float db);
+inline float trackGainDb(int8_t gain) { return (float)gain / TRACK_GAIN_STEPS_PER_DB; }
+
+// The DFPlayer only has 31 volume steps. Its curve is not documented;
+// DFPLAYER_GAIN_PER_STEP takes it as 2 dB a step, which is about what the
+// module does over the range a small speaker is used at.
+const uint8_t DFPLAYER_GAIN_PER_STEP = 2 * TRACK_GAIN_STEPS_PER_DB;
+// Volume steps to add at track start, rounded to the nearest step
+int8_t dfPlayerVolumeOffset(int8_t gain);
+
+// Linear factor, 65536 = 0 dB, for paths that scale samples themselves.
+// It is folded into the volume factor once per track, so the samples still
+// see a single multiply.
+uint32_t trackGainScale(int8_t gain);
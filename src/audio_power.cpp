@@ -0,0 +1,111 @@
+#include "audio_power.h"
+#include <DFPlayerFrame.h>
+#include <Preferences.h>
+#include "board_config.h"
+#include "energy.h"
+#include "timers.h"
+
+const uint8_t DFPLAYER_CMD_OUTPUT_DEVICE = 0x09;
+const uint8_t DFPLAYER_CMD_SLEEP = 0x0A;
+const uint16_t DFPLAYER_OUTPUT_SD = 0x02;
+
+AudioPowerStats audioPowerStats;
+
+static struct {
+  Print* dfPlayer = nullptr;
+  uint16_t idleTimeout = DEFAULT_AUDIO_IDLE_TIMEOUT;
+  bool asleep = false;
+  bool idle = false;    // awake with no audio
+  bool waking = false;  // waiting for BUSY to report the first sample
+  unsigned long wakeAt = 0;
+  WheelTimer idleTimer;  // armed while the chain is awake and silent
+} power;
+
+static Preferences prefs;
+
+// The amplifier goes quiet first, so the DFPlayer's output stage switching
+// off does not pop
+static void sleepAudio(void*) {
+  digitalWrite(AMP_SHUTDOWN_PIN, LOW);
+  if (power.dfPlayer) {
+    uint8_t frame[DFPLAYER_FRAME_SIZE];
+    encodeDFPlayerFrame(DFPLAYER_CMD_SLEEP, 0, false, frame);
+    power.dfPlayer->write(frame, sizeof(frame));
+  }
+  power.asleep = true;
+  power.idle = false;
+  power.waking = false;
+  audioPowerStats.sleeps++;
+  energyEnter(POWER_AUDIO_SLEEP);
+  Serial.println("💤 Audio asleep");
+}
+
+void audioPowerBegin(Print* dfPlayerSerial) {
+  power.dfPlayer = dfPlayerSerial;
+  prefs.begin("audiopower", false);
+  power.idleTimeout = prefs.getUShort("idle", DEFAULT_AUDIO_IDLE_TIMEOUT);
+  pinMode(DFPLAYER_BUSY_PIN, INPUT_PULLUP);
+  pinMode(AMP_SHUTDOWN_PIN, OUTPUT);
+  digitalWrite(AMP_SHUTDOWN_PIN, HIGH);
+  power.idleTimer.callback = sleepAudio;
+  audioPowerIdle();
+}
+
+void audioPowerIdle() {
+  if (power.asleep) return;
+  power.idle = true;
+  energyEnter(POWER_AUDIO_IDLE);
+  if (power.idleTimeout) armTimer(power.idleTimer, power.idleTimeout * 1000UL);
+}
+
+size_t audioPowerWake(uint8_t* frame) {
+  timers.cancel(power.idleTimer);
+  power.idle = false;
+  if (!power.asleep) return 0;
+  digitalWrite(AMP_SHUTDOWN_PIN, HIGH);
+  power.asleep = false;
+  audioPowerStats.wakes++;
+  if (!power.dfPlayer) return 0;
+  power.waking = true;
+  power.wakeAt = micros();
+  encodeDFPlayerFrame(DFPLAYER_CMD_OUTPUT_DEVICE, DFPLAYER_OUTPUT_SD, false, frame);
+  return DFPLAYER_FRAME_SIZE;
+}
+
+bool audioPowerAsleep() { return power.asleep; }
+
+void audioPowerService() {
+  if (!power.waking) return;
+  unsigned long elapsed = micros() - power.wakeAt;
+  if (digitalRead(DFPLAYER_BUSY_PIN) == LOW) {
+    audioPowerStats.wakeToAudioMicros.record(elapsed);
+    power.waking = false;
+  } else if (elapsed > AUDIO_WAKE_TIMEOUT * 1000UL) {
+    audioPowerStats.unmeasuredWakes++;
+    power.waking = false;
+  }
+}
+
+void audioPowerSetIdleTimeout(uint16_t seconds) {
+  power.idleTimeout = seconds;
+  prefs.putUShort("idle", seconds);
+  if (!seconds) timers.cancel(power.idleTimer);
+  else if (power.idle) armTimer(power.idleTimer, seconds * 1000UL);
+}
+
+void printAudioPower() {
+  Serial.println("💤 Audio power:");
+  Serial.println("  Idle timeout: " + (power.idleTimeout ? String(power.idleTimeout) + " s" : String("off")) +
+                 (power.asleep ? ", asleep" : ", awake"));
+  Serial.println("  Sleeps: " + String(audioPowerStats.sleeps) + ", wakes: " + String(audioPowerStats.wakes));
+  const Histogram& h = audioPowerStats.wakeToAudioMicros;
+  if (h.count() > 0) {
+    Serial.println("  Wake-to-audio µs: n=" + String(h.count()) + " p50=" + String(h.percentile(50)) +
+                   " p90=" + String(h.percentile(90)) + " max=" + String(h.maxValue()));
+  }
+  if (audioPowerStats.unmeasuredWakes) {
+    Serial.println("  Wakes without BUSY: " + String(audioPowerStats.unmeasuredWakes));
+  }
+  Serial.println("  Saved: " + String(energySavedMilliampHours(POWER_AUDIO_SLEEP, POWER_AUDIO_IDLE), 3) +
+                 " mAh since `energy reset`");
+}
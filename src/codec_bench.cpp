@@ -0,0 +1,66 @@
+#ifdef ENABLE_ESP32_AUDIO
+#include "codec_bench.h"
+#include <AudioCodec.h>
+#include <ImaAdpcm.h>
+#include <WavDecoder.h>
+
+const uint32_t BENCH_RATE = 22050;
+const uint16_t BENCH_BLOCK_ALIGN = 512;
+
+// The hardware counter wraps every ~27 s at 160 MHz
+static uint64_t cycleCount() {
+  static uint32_t last = 0;
+  static uint64_t total = 0;
+  uint32_t now = ESP.getCycleCount();
+  total += (uint32_t)(now - last);
+  last = now;
+  return total;
+}
+
+static void printResult(const DecodeBenchmark& result) {
+  uint64_t cpuHz = (uint64_t)ESP.getCpuFreqMHz() * 1000000;
+  uint64_t perSecond = result.cyclesPerAudioSecond();
+  char line[96];
+  snprintf(line, sizeof(line), "CODEC %s rate=%lu cycles_per_audio_s=%llu cpu_pct=%.2f", audioCodecName(result.codec),
+           (unsigned long)result.sampleRate, (unsigned long long)perSecond, 100.0 * perSecond / cpuHz);
+  Serial.println(line);
+}
+
+// Two tones and a little noise, so ADPCM has to adapt its step size
+void printCodecBenchmark() {
+  const uint32_t frames = BENCH_RATE;
+  uint16_t samplesPerBlock = imaSamplesPerBlock(BENCH_BLOCK_ALIGN, 1);
+  uint32_t blocks = (frames + samplesPerBlock - 1) / samplesPerBlock;
+  size_t pcmSize = WAV_PCM_HEADER_SIZE + frames * 2;
+  size_t imaSize = WAV_IMA_HEADER_SIZE + blocks * BENCH_BLOCK_ALIGN;
+  uint8_t* pcmWav = (uint8_t*)malloc(pcmSize + (blocks * samplesPerBlock - frames) * 2);
+  uint8_t* imaWav = (uint8_t*)malloc(imaSize);
+  if (!pcmWav || !imaWav) {
+    Serial.println("❌ Not enough RAM for the codec benchmark");
+    free(pcmWav);
+    free(imaWav);
+    return;
+  }
+
+  int16_t* samples = (int16_t*)(pcmWav + WAV_PCM_HEADER_SIZE);
+  for (uint32_t i = 0; i < blocks * samplesPerBlock; i++) {
+    float t = (float)i / BENCH_RATE;
+    samples[i] = 9000 * sinf(2 * PI * 440 * t) + 4000 * sinf(2 * PI * 1250 * t) + random(-500, 500);
+  }
+  writeWavPcmHeader(pcmWav, BENCH_RATE, 1, frames * 2);
+  ImaState state;
+  uint8_t* block = imaWav + WAV_IMA_HEADER_SIZE;
+  for (uint32_t b = 0; b < blocks; b++, block += BENCH_BLOCK_ALIGN) {
+    imaEncodeBlock(samples + b * samplesPerBlock, 1, BENCH_BLOCK_ALIGN, &state, block);
+  }
+  writeWavImaHeader(imaWav, BENCH_RATE, 1, BENCH_BLOCK_ALIGN, frames, blocks * BENCH_BLOCK_ALIGN);
+
+  DecodeBenchmark result;
+  MemorySource pcm(pcmWav, pcmSize);
+  if (benchmarkDecode(pcm, cycleCount, result)) printResult(result);
+  MemorySource ima(imaWav, imaSize);
+  if (benchmarkDecode(ima, cycleCount, result)) printResult(result);
+  free(pcmWav);
+  free(imaWav);
+}
+#endif
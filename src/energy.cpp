@@ -0,0 +1,132 @@
+#include "energy.h"
+#include <Preferences.h>
+
+enum Subsystem : uint8_t { SUBSYSTEM_NFC, SUBSYSTEM_AUDIO, SUBSYSTEM_CPU, SUBSYSTEM_LED, SUBSYSTEM_COUNT };
+
+struct PowerStateInfo {
+  const char* name;
+  Subsystem subsystem;
+  uint32_t defaultMicroamps;
+};
+
+// Bare modules at 3.3 V: PN532 with the RF field on / idle, DFPlayer Mini
+// into a small speaker / idle / sleep, ESP32-C3 at 160 MHz with Wi-Fi off,
+// one indicator LED.
+const PowerStateInfo POWER_STATES[POWER_STATE_COUNT] = {
+  {"nfc.off", SUBSYSTEM_NFC, 10000},
+  {"nfc.on", SUBSYSTEM_NFC, 100000},
+  {"audio.sleep", SUBSYSTEM_AUDIO, 10000},
+  {"audio.idle", SUBSYSTEM_AUDIO, 20000},
+  {"audio.play", SUBSYSTEM_AUDIO, 60000},
+  {"cpu.sleep", SUBSYSTEM_CPU, 15000},
+  {"cpu.active", SUBSYSTEM_CPU, 25000},
+  {"led.off", SUBSYSTEM_LED, 0},
+  {"led.on", SUBSYSTEM_LED, 5000},
+};
+
+const char* const SUBSYSTEM_NAMES[SUBSYSTEM_COUNT] = {"NFC", "Audio", "CPU", "LED"};
+
+static struct {
+  uint64_t residencyMicros[POWER_STATE_COUNT] = {};
+  PowerState current[SUBSYSTEM_COUNT] = {POWER_NFC_FIELD_OFF, POWER_AUDIO_IDLE, POWER_CPU_ACTIVE, POWER_LED_OFF};
+  int64_t enteredAt[SUBSYSTEM_COUNT] = {};
+  int64_t resetAt = 0;
+  uint32_t microamps[POWER_STATE_COUNT];
+  uint16_t batteryCapacity = DEFAULT_BATTERY_CAPACITY;
+} energy;
+
+// The NFC task reports field transitions from the other core
+static portMUX_TYPE energyLock = portMUX_INITIALIZER_UNLOCKED;
+static Preferences prefs;
+
+void energyBegin() {
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++) energy.microamps[i] = POWER_STATES[i].defaultMicroamps;
+  prefs.begin("energy", false);
+  prefs.getBytes("ua", energy.microamps, sizeof(energy.microamps));
+  energy.batteryCapacity = prefs.getUShort("battery", DEFAULT_BATTERY_CAPACITY);
+  energyReset();
+}
+
+void energyEnter(PowerState state) {
+  Subsystem subsystem = POWER_STATES[state].subsystem;
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&energyLock);
+  PowerState previous = energy.current[subsystem];
+  if (previous != state) {
+    energy.residencyMicros[previous] += now - energy.enteredAt[subsystem];
+    energy.current[subsystem] = state;
+    energy.enteredAt[subsystem] = now;
+  }
+  portEXIT_CRITICAL(&energyLock);
+}
+
+void energyReset() {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&energyLock);
+  memset(energy.residencyMicros, 0, sizeof(energy.residencyMicros));
+  for (uint8_t i = 0; i < SUBSYSTEM_COUNT; i++) energy.enteredAt[i] = now;
+  energy.resetAt = now;
+  portEXIT_CRITICAL(&energyLock);
+}
+
+bool energySetCurrent(const char* stateName, float milliamps) {
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++) {
+    if (strcmp(stateName, POWER_STATES[i].name) != 0) continue;
+    energy.microamps[i] = milliamps * 1000;
+    prefs.putBytes("ua", energy.microamps, sizeof(energy.microamps));
+    return true;
+  }
+  return false;
+}
+
+void energySetBattery(uint16_t milliampHours) {
+  energy.batteryCapacity = milliampHours;
+  prefs.putUShort("battery", milliampHours);
+}
+
+const float MICROS_PER_HOUR = 3.6e9f;
+
+// The open interval of every subsystem's current state counts up to now.
+// Returns the time since the last reset.
+static int64_t residencyUntilNow(uint64_t* residency) {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&energyLock);
+  memcpy(residency, energy.residencyMicros, sizeof(energy.residencyMicros));
+  for (uint8_t i = 0; i < SUBSYSTEM_COUNT; i++) residency[energy.current[i]] += now - energy.enteredAt[i];
+  int64_t elapsed = now - energy.resetAt;
+  portEXIT_CRITICAL(&energyLock);
+  return elapsed;
+}
+
+float energySavedMilliampHours(PowerState state, PowerState baseline) {
+  uint64_t residency[POWER_STATE_COUNT];
+  residencyUntilNow(residency);
+  return residency[state] / MICROS_PER_HOUR * ((float)energy.microamps[baseline] - energy.microamps[state]) / 1000;
+}
+
+// Charge per state is residency × current
+void printEnergy() {
+  uint64_t residency[POWER_STATE_COUNT];
+  int64_t elapsed = residencyUntilNow(residency);
+  if (elapsed <= 0) return;
+
+  Serial.println("⚡ Energy over the last " + String((unsigned long)(elapsed / 1000000)) + " s:");
+  float total = 0;
+  for (uint8_t s = 0; s < SUBSYSTEM_COUNT; s++) {
+    float subsystemTotal = 0;
+    String line;
+    for (uint8_t i = 0; i < POWER_STATE_COUNT; i++) {
+      if (POWER_STATES[i].subsystem != s) continue;
+      float mAh = residency[i] / MICROS_PER_HOUR * energy.microamps[i] / 1000;
+      subsystemTotal += mAh;
+      line += "  " + String(POWER_STATES[i].name) + " " + String(100.0f * residency[i] / elapsed, 1) + "% @ " +
+              String(energy.microamps[i] / 1000.0f, 1) + " mA";
+    }
+    total += subsystemTotal;
+    Serial.println("  " + String(SUBSYSTEM_NAMES[s]) + ": " + String(subsystemTotal, 3) + " mAh " + line);
+  }
+  float averageMilliamps = total * MICROS_PER_HOUR / elapsed;
+  Serial.println("  Total: " + String(total, 3) + " mAh, average " + String(averageMilliamps, 1) + " mA");
+  Serial.println("  Battery: " + String(energy.batteryCapacity) + " mAh → " +
+                 String(energy.batteryCapacity / averageMilliamps, 1) + " h at this rate");
+}
@@ -0,0 +1,165 @@
+#include "event_log.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+#include "timers.h"
+
+struct LogEntry {
+  uint32_t time;  // millis() since boot
+  uint16_t boot;
+  uint8_t type;
+  uint8_t a;
+  uint32_t b;
+  uint32_t c;
+};
+static_assert(sizeof(LogEntry) == 16, "log entries must tile a flash page");
+
+const uint8_t ENTRIES_PER_PAGE = LOG_PAGE_SIZE / sizeof(LogEntry);
+const uint16_t BUFFER_ENTRIES = LOG_BUFFER_PAGES * ENTRIES_PER_PAGE;
+const unsigned long WRITE_TOKEN_INTERVAL = 3600000UL / LOG_MAX_WRITES_PER_HOUR;
+const char* const LOG_FILES[2] = {"/events0.bin", "/events1.bin"};
+
+static struct {
+  bool mounted = false;
+  uint16_t boot = 0;
+  uint8_t current = 0;  // file being appended to
+  LogEntry buffer[BUFFER_ENTRIES];
+  uint16_t buffered = 0;
+  uint32_t dropped = 0;
+  uint8_t writeTokens = LOG_MAX_WRITES_PER_HOUR;
+  unsigned long lastTokenTime = 0;
+  WheelTimer idleFlush;
+  WheelTimer budgetRetry;  // armed while entries wait for write budget
+} eventLog;
+
+static void refillTokens() {
+  unsigned long now = millis();
+  while (now - eventLog.lastTokenTime >= WRITE_TOKEN_INTERVAL) {
+    eventLog.lastTokenTime += WRITE_TOKEN_INTERVAL;
+    if (eventLog.writeTokens < LOG_MAX_WRITES_PER_HOUR) eventLog.writeTokens++;
+  }
+}
+
+// The older file is truncated when the current one is full, so the log
+// always holds between one and two files of history.
+static File openForAppend() {
+  File f = LittleFS.open(LOG_FILES[eventLog.current], "a");
+  if (f && f.size() + LOG_PAGE_SIZE > LOG_FILE_SIZE) {
+    f.close();
+    eventLog.current ^= 1;
+    f = LittleFS.open(LOG_FILES[eventLog.current], "w");
+    Preferences prefs;
+    prefs.begin("evlog", false);
+    prefs.putUChar("file", eventLog.current);
+    prefs.end();
+  }
+  return f;
+}
+
+// Writes whole pages while there is budget; a trailing partial page only
+// goes out when `partial` is set (idle or sleep).
+static void flushPages(bool partial) {
+  if (!eventLog.mounted) return;
+  refillTokens();
+  uint16_t written = 0;
+  while (eventLog.buffered - written > 0 && eventLog.writeTokens > 0) {
+    uint16_t n = min((uint16_t)(eventLog.buffered - written), (uint16_t)ENTRIES_PER_PAGE);
+    if (n < ENTRIES_PER_PAGE && !partial) break;
+    File f = openForAppend();
+    if (!f) break;
+    f.write((const uint8_t*)&eventLog.buffer[written], n * sizeof(LogEntry));
+    f.close();
+    eventLog.writeTokens--;
+    written += n;
+  }
+  if (written > 0) {
+    memmove(eventLog.buffer, eventLog.buffer + written, (eventLog.buffered - written) * sizeof(LogEntry));
+    eventLog.buffered -= written;
+  }
+  if (eventLog.buffered > 0 && eventLog.writeTokens == 0) {
+    armTimer(eventLog.budgetRetry, WRITE_TOKEN_INTERVAL - (millis() - eventLog.lastTokenTime));
+  }
+}
+
+static void onFlushTimer(void*) { flushPages(true); }
+
+void eventLogBegin() {
+  eventLog.idleFlush.callback = onFlushTimer;
+  eventLog.budgetRetry.callback = onFlushTimer;
+  eventLog.lastTokenTime = millis();
+  if (!LittleFS.begin(true)) {
+    Serial.println("⚠️  Event log disabled: LittleFS mount failed");
+    return;
+  }
+  eventLog.mounted = true;
+
+  Preferences prefs;
+  prefs.begin("evlog", false);
+  eventLog.boot = prefs.getUShort("boot", 0) + 1;
+  prefs.putUShort("boot", eventLog.boot);
+  eventLog.current = prefs.getUChar("file", 0) & 1;
+  prefs.end();
+
+  logEvent(LOG_BOOT, esp_reset_reason());
+  Serial.println("✅ Event log: boot #" + String(eventLog.boot));
+}
+
+void logEvent(LogEventType type, uint8_t a, uint32_t b, uint32_t c) {
+  if (eventLog.buffered == BUFFER_ENTRIES) {
+    eventLog.dropped++;
+    return;
+  }
+  if (eventLog.dropped > 0 && eventLog.buffered < BUFFER_ENTRIES - 1) {
+    eventLog.buffer[eventLog.buffered++] = {(uint32_t)millis(), eventLog.boot, LOG_DROPPED, 0, eventLog.dropped, 0};
+    eventLog.dropped = 0;
+  }
+  eventLog.buffer[eventLog.buffered++] = {(uint32_t)millis(), eventLog.boot, type, a, b, c};
+  if (eventLog.buffered % ENTRIES_PER_PAGE == 0) flushPages(false);
+  armTimer(eventLog.idleFlush, LOG_IDLE_FLUSH_DELAY);
+}
+
+void eventLogFlush() { flushPages(true); }
+
+static const char* eventName(uint8_t type) {
+  switch (type) {
+    case LOG_BOOT: return "BOOT";
+    case LOG_PLAY: return "PLAY";
+    case LOG_STOP: return "STOP";
+    case LOG_READ_FAILURE: return "READ_FAIL";
+    case LOG_GRACE_STOP: return "GRACE_STOP";
+    case LOG_CONTROL: return "CONTROL";
+    case LOG_TAG_WRITE: return "TAG_WRITE";
+    case LOG_TAG_BOUND: return "TAG_BOUND";
+    case LOG_DROPPED: return "DROPPED";
+    default: return "?";
+  }
+}
+
+static void printEntry(const LogEntry& e) {
+  char line[80];
+  snprintf(line, sizeof(line), "%u %lu.%03lu %s %u %lu %lu", e.boot, (unsigned long)(e.time / 1000),
+           (unsigned long)(e.time % 1000), eventName(e.type), e.a, (unsigned long)e.b, (unsigned long)e.c);
+  Serial.println(line);
+}
+
+static void dumpFile(const char* path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return;
+  LogEntry page[ENTRIES_PER_PAGE];
+  size_t n;
+  while ((n = f.read((uint8_t*)page, sizeof(page))) >= sizeof(LogEntry)) {
+    for (size_t i = 0; i < n / sizeof(LogEntry); i++) printEntry(page[i]);
+  }
+  f.close();
+}
+
+// Oldest first: the other file, the current one, then what is still in RAM.
+// Columns: boot, seconds since boot, event, a, b, c.
+void eventLogDump() {
+  Serial.println("LOG BEGIN");
+  if (eventLog.mounted) {
+    dumpFile(LOG_FILES[eventLog.current ^ 1]);
+    dumpFile(LOG_FILES[eventLog.current]);
+  }
+  for (uint16_t i = 0; i < eventLog.buffered; i++) printEntry(eventLog.buffer[i]);
+  Serial.println("LOG END (" + String(eventLog.writeTokens) + " flash writes left this hour)");
+}
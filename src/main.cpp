@@ -2,54 +2,81 @@
 #include <Adafruit_PN532.h>
 #include <DFRobotDFPlayerMini.h>
 #include <HardwareSerial.h>
-
-// ==================== PIN DEFINITIONS ====================
-#define SDA_PIN 9
-#define SCL_PIN 8
-#define DFPLAYER_TX_PIN 0
-#define DFPLAYER_RX_PIN 1
-#define VOLUME_UP_PIN 5
-#define VOLUME_DOWN_PIN 6
-#define LED_PIN 4
+#include <DFPlayerFrame.h>
+#include <TagRecord.h>
+#include "audio_power.h"
+#include "board_config.h"
+#include "codec_bench.h"
+#include "energy.h"
+#include "event_log.h"
+#include "metadata_cache.h"
+#include "nfc_reader.h"
+#include "player_state.h"
+#include "pwm_audio.h"
+#include "resume_position.h"
+#include "stats.h"
+#include "tag_library.h"
+#include "tag_writer.h"
+#include "telemetry.h"
+#include "timers.h"
+#include "track_gain.h"
+#include "version.h"
+#include "visualizer.h"
+#include "web_ui.h"
+#include "wifi_link.h"
 
 // ==================== CONSTANTS ====================
 const int DEFAULT_VOLUME = 20;
 const int MAX_VOLUME = 30;
 const int MIN_VOLUME = 0;
-const unsigned long NFC_CHECK_INTERVAL = 200;
+const int MAX_PRESET_VOLUME = 25;  // cap for per-tag presets
+const uint8_t EQ_PRESET_COUNT = 6;   // DFPLAYER_EQ_NORMAL..DFPLAYER_EQ_BASS
 const unsigned long TAG_GRACE_PERIOD = 2000;
 const unsigned long BUTTON_DEBOUNCE_DELAY = 200;
+const unsigned long TRACK_FINISH_GUARD = 1000;
+const unsigned long SERVICE_INTERVAL = 10;  // console, buttons, player, web
 
 // ==================== HARDWARE INSTANCES ====================
-Adafruit_PN532 nfc(SDA_PIN, SCL_PIN);
 HardwareSerial dfPlayerSerial(1);
 DFRobotDFPlayerMini dfPlayer;
 
 // ==================== STATE VARIABLES ====================
 struct SystemState {
-  uint8_t lastUID[7] = {0};
-  uint8_t lastUIDLength = 0;
-  unsigned long lastTagDetectionTime = 0;
-  unsigned long lastNFCCheckTime = 0;
   bool isTagPresent = false;
+  bool isOtherTagPresent = false;  // foreign card (see nfc_reader.h) or control tag on the reader
   bool isSongPlaying = false;
   int currentTrack = 0;
+  uint8_t currentFolder = 0;  // playlist folder, 0 for a single track
+  uint8_t folderTrackCount = 0;  // learned when a playlist wraps, 0 if unknown
+  bool shuffle = false;
   int currentVolume = DEFAULT_VOLUME;
+  int baseVolume = DEFAULT_VOLUME;  // volume for tags without a preset
+  int8_t gainOffset = 0;  // volume steps the current track's gain adds
+  bool presetActive = false;
+  uint8_t currentEq = DFPLAYER_EQ_NORMAL;
+  bool volumeUnsent = false;  // changed while the DFPlayer slept
+  WheelTimer graceTimer;   // armed while the tag is away and music plays
+  WheelTimer sleepTimer;   // control-tag sleep timer
+  WheelTimer finishGuard;  // armed right after a track starts
 } state;
 
 struct ButtonState {
   bool lastUpState = HIGH;
   bool lastDownState = HIGH;
-  unsigned long lastUpPress = 0;
-  unsigned long lastDownPress = 0;
+  WheelTimer upDebounce;    // armed while further presses are ignored
+  WheelTimer downDebounce;
+  bool locked = false;
 } buttons;
 
+WheelTimer serviceTimer;
+WheelTimer nfcTimer;
+
 // Operation mode
-enum Mode { PLAY_MODE, WRITE_MODE, READ_MODE };
+enum Mode { PLAY_MODE, WRITE_MODE, READ_MODE, LEARN_MODE };
 Mode currentMode = PLAY_MODE;
 
 // ==================== UTILITY FUNCTIONS ====================
-String uidToString(uint8_t* uid, uint8_t length) {
+String uidToString(const uint8_t* uid, uint8_t length) {
   String result = "";
   for (uint8_t i = 0; i < length; i++) {
     if (i > 0) result += ":";
@@ -60,13 +87,6 @@ String uidToString(uint8_t* uid, uint8_t length) {
   return result;
 }
 
-bool uidsMatch(uint8_t* uid1, uint8_t* uid2, uint8_t length) {
-  for (uint8_t i = 0; i < length; i++) {
-    if (uid1[i] != uid2[i]) return false;
-  }
-  return true;
-}
-
 // ==================== HARDWARE INITIALIZATION ====================
 void initializeButtons() {
   pinMode(VOLUME_UP_PIN, INPUT_PULLUP);
@@ -83,22 +103,12 @@ void initializeI2C() {
   Wire.begin(SDA_PIN, SCL_PIN);
 }
 
-void initializeNFC() {
-  Serial.println("Initializing PN532 NFC Reader...");
-  nfc.begin();
-
-  uint32_t version = nfc.getFirmwareVersion();
-  if (!version) {
-    Serial.println("❌ ERROR: PN532 not found!");
-    while (1);
-  }
-
-  Serial.print("✅ Found PN5");
-  Serial.println((version >> 24) & 0xFF, HEX);
-  nfc.SAMConfig();
-}
-
 void initializeDFPlayer() {
+#ifdef ENABLE_PWM_AUDIO
+  if (!pwmAudioBegin()) while (1);
+  audioPowerBegin(nullptr);
+  return;
+#endif
   Serial.println("Initializing DFPlayer Mini...");
   dfPlayerSerial.begin(9600, SERIAL_8N1, DFPLAYER_RX_PIN, DFPLAYER_TX_PIN);
   if (!dfPlayer.begin(dfPlayerSerial)) {
@@ -109,27 +119,152 @@ void initializeDFPlayer() {
   dfPlayer.volume(DEFAULT_VOLUME);
   dfPlayer.EQ(DFPLAYER_EQ_NORMAL);
   dfPlayer.outputDevice(DFPLAYER_DEVICE_SD);
+  audioPowerBegin(&dfPlayerSerial);
   Serial.println("✅ DFPlayer Mini online");
 }
 
 // ==================== PLAYBACK CONTROL ====================
-void setLED(bool on) { digitalWrite(LED_PIN, on ? HIGH : LOW); }
+void setLED(bool on) {
+  if (!visualizerSetLed(on)) digitalWrite(LED_PIN, on ? HIGH : LOW);
+  energyEnter(on ? POWER_LED_ON : POWER_LED_OFF);
+}
 
-void playSong(int trackNumber) {
+// ==================== DFPLAYER COMMAND BURST ====================
+#ifdef ENABLE_PWM_AUDIO
+// Boards without a DFPlayer take the same request: the volume becomes a
+// gain factor, and the track gain is applied exactly instead of in steps.
+// There is no EQ to preset. An MP3 that was stopped part-way carries on
+// where it left off.
+void sendPlayBurst(uint8_t presetVolume, uint8_t, int8_t trackGain, uint8_t playCommand, uint16_t playArgument) {
+  int volume = state.baseVolume;
+  if (presetVolume != TAG_PRESET_NONE) volume = min((int)presetVolume, MAX_PRESET_VOLUME);
+  state.presetActive = presetVolume != TAG_PRESET_NONE;
+  state.gainOffset = 0;
+  state.currentVolume = volume;
+  audioPowerWake(nullptr);
+  bool folderTrack = playCommand == DFPLAYER_CMD_PLAY_FOLDER;
+  uint8_t folder = folderTrack ? playArgument >> 8 : PWM_SINGLE_TRACK_FOLDER;
+  uint8_t track = playArgument & 0xFF;
+  pwmPlayerPlay(folder, track, volume, trackGain, resumePositionFor(folder, track));
+}
+#else
+// Volume, EQ and play go out as back-to-back frames in one UART write and
+// without ACK requests, so nothing waits between them and the first sample
+// already plays at the right loudness. Settings that are already in place
+// are skipped, so a tag without a preset still costs a single frame.
+// The track's loudness gain rides along as a volume offset; it never turns
+// a muted box up or a playing one off. A sleeping DFPlayer gets its wake
+// frame first, in the same write.
+void sendPlayBurst(uint8_t presetVolume, uint8_t presetEq, int8_t trackGain, uint8_t playCommand,
+                   uint16_t playArgument) {
+  int volume = state.baseVolume;
+  int maxVolume = MAX_VOLUME;
+  if (presetVolume != TAG_PRESET_NONE) {
+    volume = min((int)presetVolume, MAX_PRESET_VOLUME);
+    maxVolume = MAX_PRESET_VOLUME;
+  }
+  int listenerVolume = volume;
+  if (volume > MIN_VOLUME) volume = constrain(volume + dfPlayerVolumeOffset(trackGain), MIN_VOLUME + 1, maxVolume);
+  state.gainOffset = volume - listenerVolume;
+  uint8_t eq = DFPLAYER_EQ_NORMAL;
+  if (presetEq < EQ_PRESET_COUNT) eq = presetEq;
+  state.presetActive = presetVolume != TAG_PRESET_NONE;
+
+  uint8_t burst[4 * DFPLAYER_FRAME_SIZE];
+  size_t length = audioPowerWake(burst);
+  if (volume != state.currentVolume || state.volumeUnsent) {
+    encodeDFPlayerFrame(DFPLAYER_CMD_VOLUME, volume, false, burst + length);
+    length += DFPLAYER_FRAME_SIZE;
+    state.currentVolume = volume;
+    state.volumeUnsent = false;
+    Serial.println("🔊 Volume: " + String(volume));
+  }
+  if (eq != state.currentEq) {
+    encodeDFPlayerFrame(DFPLAYER_CMD_EQ, eq, false, burst + length);
+    length += DFPLAYER_FRAME_SIZE;
+    state.currentEq = eq;
+  }
+  encodeDFPlayerFrame(playCommand, playArgument, false, burst + length);
+  length += DFPLAYER_FRAME_SIZE;
+  dfPlayerSerial.write(burst, length);
+}
+#endif
+
+void playSong(int trackNumber, uint8_t presetVolume = TAG_PRESET_NONE, uint8_t presetEq = TAG_PRESET_NONE) {
   Serial.println("🎵 PLAYING: Track " + String(trackNumber));
-  dfPlayer.play(trackNumber);
+  sendPlayBurst(presetVolume, presetEq, trackGainFor(0, trackNumber), DFPLAYER_CMD_PLAY, trackNumber);
+  energyEnter(POWER_AUDIO_PLAYING);
   setLED(true);
   state.currentTrack = trackNumber;
   state.isSongPlaying = true;
 }
 
+void playFolderTrack(uint8_t folder, int trackNumber) {
+  if (state.currentFolder != folder) state.folderTrackCount = 0;
+  Serial.println("🎵 PLAYING: Folder " + String(folder) + " track " + String(trackNumber));
+  sendPlayBurst(TAG_PRESET_NONE, TAG_PRESET_NONE, trackGainFor(folder, trackNumber), DFPLAYER_CMD_PLAY_FOLDER,
+                (folder << 8) | trackNumber);
+  energyEnter(POWER_AUDIO_PLAYING);
+  setLED(true);
+  state.currentFolder = folder;
+  state.currentTrack = trackNumber;
+  state.isSongPlaying = true;
+  armTimer(state.finishGuard, TRACK_FINISH_GUARD);
+}
+
 void stopSong() {
   if (!state.isSongPlaying) return;
   Serial.println("⏹️  STOPPING: Track " + String(state.currentTrack));
-  dfPlayer.stop();
+#ifdef ENABLE_PWM_AUDIO
+  pwmPlayerStop();
+#else
+  if (!audioPowerAsleep()) dfPlayer.stop();
+#endif
+  audioPowerIdle();
   setLED(false);
   state.isSongPlaying = false;
   state.currentTrack = 0;
+  state.currentFolder = 0;
+  logEvent(LOG_STOP);
+}
+
+// Shuffle needs the folder size, which is only known once the playlist has
+// wrapped; until then tracks play in order.
+int nextPlaylistTrack() {
+  uint8_t count = state.folderTrackCount;
+  if (!state.shuffle || count < 2) return state.currentTrack + 1;
+  int next = random(1, count);  // 1..count-1, skip the current track
+  return next >= state.currentTrack ? next + 1 : next;
+}
+
+// Playlists advance on the DFPlayer's "play finished" frame and wrap to the
+// first track when the next file does not exist. The player tends to repeat
+// the finished frame, so frames while finishGuard is armed are ignored.
+void checkPlayerEvents() {
+#ifdef ENABLE_PWM_AUDIO
+  uint8_t type;
+  uint16_t value;
+  if (!pwmPlayerNextEvent(type, value)) return;
+#else
+  if (!dfPlayer.available()) return;
+  uint8_t type = dfPlayer.readType();
+  uint16_t value = dfPlayer.read();
+#endif
+  // A single track that ran out still counts as playing, but the DFPlayer is idle
+  if (type == DFPlayerPlayFinished && state.currentFolder == 0) audioPowerIdle();
+  if (!state.isSongPlaying || state.currentFolder == 0) return;
+
+  if (type == DFPlayerPlayFinished) {
+    if (state.finishGuard.armed()) return;
+    playFolderTrack(state.currentFolder, nextPlaylistTrack());
+  } else if (type == DFPlayerError && value == FileMismatch) {
+    if (state.currentTrack > 1) {
+      state.folderTrackCount = state.currentTrack - 1;
+      playFolderTrack(state.currentFolder, state.shuffle ? nextPlaylistTrack() : 1);
+    } else {
+      stopSong();
+    }
+  }
 }
 
 // ==================== VOLUME CONTROL ====================
@@ -138,183 +273,749 @@ void adjustVolume(int delta) {
   if (newVolume < MIN_VOLUME) newVolume = MIN_VOLUME;
   if (newVolume > MAX_VOLUME) newVolume = MAX_VOLUME;
   state.currentVolume = newVolume;
-  dfPlayer.volume(state.currentVolume);
+  if (!state.presetActive) state.baseVolume = constrain(newVolume - state.gainOffset, MIN_VOLUME, MAX_VOLUME);
+#ifdef ENABLE_PWM_AUDIO
+  pwmPlayerSetVolume(state.currentVolume);
+#else
+  if (audioPowerAsleep()) state.volumeUnsent = true;  // goes out with the wake burst
+  else dfPlayer.volume(state.currentVolume);
+#endif
   Serial.println("🔊 Volume: " + String(state.currentVolume));
 }
 
-void checkVolumeButtons() {
-  unsigned long now = millis();
+// Reports fresh, debounced presses of each button
+void readButtonPresses(bool& up, bool& down) {
   bool upPressed = (digitalRead(VOLUME_UP_PIN) == LOW);
   bool downPressed = (digitalRead(VOLUME_DOWN_PIN) == LOW);
 
-  if (upPressed && !buttons.lastUpState &&
-      (now - buttons.lastUpPress > BUTTON_DEBOUNCE_DELAY)) {
-    adjustVolume(1);
-    buttons.lastUpPress = now;
-  }
+  up = upPressed && !buttons.lastUpState && !buttons.upDebounce.armed();
+  if (up) armTimer(buttons.upDebounce, BUTTON_DEBOUNCE_DELAY);
   buttons.lastUpState = upPressed;
 
-  if (downPressed && !buttons.lastDownState &&
-      (now - buttons.lastDownPress > BUTTON_DEBOUNCE_DELAY)) {
-    adjustVolume(-1);
-    buttons.lastDownPress = now;
-  }
+  down = downPressed && !buttons.lastDownState && !buttons.downDebounce.armed();
+  if (down) armTimer(buttons.downDebounce, BUTTON_DEBOUNCE_DELAY);
   buttons.lastDownState = downPressed;
 }
 
-// ==================== NFC TAG READING / WRITING ====================
-int readSongNumberFromTag() {
-  uint8_t data[4];
-  bool success = nfc.ntag2xx_ReadPage(4, data);
-  if (!success) {
-    Serial.println("❌ Failed to read tag data");
-    return -1;
-  }
+void checkVolumeButtons() {
+  bool up, down;
+  readButtonPresses(up, down);
+  if (buttons.locked) return;
+  if (up) adjustVolume(1);
+  if (down) adjustVolume(-1);
+}
 
-  if (data[0] == 'S' && data[1] == 'O' && data[2] == 'N') {
-    int songNum = data[3];
-    if (songNum >= 1 && songNum <= 99) return songNum;
+// ==================== CONTROL TAGS ====================
+// Control tags act on the box itself: no DFPlayer query, no console, and
+// the current track keeps playing. Handlers are indexed by command byte.
+void controlSetVolume(uint8_t volume) {
+  state.presetActive = false;
+  adjustVolume((int)volume - state.currentVolume);
+}
+
+void controlToggleShuffle(uint8_t) {
+  state.shuffle = !state.shuffle;
+  Serial.println(state.shuffle ? "🔀 Shuffle on" : "➡️  Shuffle off");
+}
+
+void controlSleepTimer(uint8_t minutes) {
+  if (minutes) {
+    armTimer(state.sleepTimer, minutes * 60000UL);
+    Serial.println("😴 Sleep timer: " + String(minutes) + " min");
+  } else {
+    timers.cancel(state.sleepTimer);
+    Serial.println("😴 Sleep timer cancelled");
   }
-  Serial.println("❌ Tag not programmed correctly");
-  return -1;
 }
 
-void writeSongNumber(uint8_t songNum) {
-  Serial.print("\nPlace NFC tag to write song #");
-  Serial.println(songNum);
-  uint8_t uid[7]; uint8_t uidLength;
-  bool success = false;
+void controlLockButtons(uint8_t) {
+  buttons.locked = !buttons.locked;
+  Serial.println(buttons.locked ? "🔒 Buttons locked" : "🔓 Buttons unlocked");
+}
+
+typedef void (*ControlHandler)(uint8_t argument);
+
+const ControlHandler CONTROL_HANDLERS[CONTROL_COMMAND_COUNT] = {
+  nullptr,
+  controlSetVolume,       // CONTROL_SET_VOLUME
+  controlToggleShuffle,   // CONTROL_TOGGLE_SHUFFLE
+  controlSleepTimer,      // CONTROL_SLEEP_TIMER
+  controlLockButtons,     // CONTROL_LOCK_BUTTONS
+};
+
+void runControlTag(const TagRecord& record) {
+  Serial.println("🎛️  Control tag: " + String(controlCommandName(record.command)));
+  logEvent(LOG_CONTROL, record.command, record.argument);
+  CONTROL_HANDLERS[record.command](record.argument);
+}
+
+void onSleepTimer(void*) {
+  Serial.println("😴 Sleep timer expired");
+  stopSong();
+  eventLogFlush();
+}
+
+// ==================== NFC TAG READING / WRITING ====================
+void printReadError(TagReadStatus status) {
+  if (status == TAG_READ_FAILED) Serial.println("❌ Failed to read tag data");
+  else if (status == TAG_READ_UNPROGRAMMED) Serial.println("❌ Tag not programmed correctly");
+  else if (status == TAG_READ_SKIPPED) Serial.println("❌ Tag binding changed, place the tag again");
+}
+
+bool waitForTag(uint8_t* uid, uint8_t* uidLength) {
   for (int i = 0; i < 50; i++) {
-    success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 200);
-    if (success) break;
-  }
-  if (!success) {
-    Serial.println("Timeout - no tag detected");
-    return;
+    if (nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, 200)) return true;
   }
+  Serial.println("Timeout - no tag detected");
+  return false;
+}
 
-  uint8_t data[4] = {'S', 'O', 'N', songNum};
-  success = nfc.ntag2xx_WritePage(4, data);
-  delay(100);
-  if (success) {
-    Serial.println("✓ Tag written successfully!");
+void printWriteResult(const uint8_t* uid, uint8_t uidLength, const TagWriteResult& result) {
+  logEvent(LOG_TAG_WRITE, result.ok, result.pagesWritten);
+  if (result.ok) {
+    metadataCacheForget(uid, uidLength);
+    Serial.println("✓ Tag written successfully! (" + String(result.pagesWritten) + "/" +
+                   String(result.pageCount) + " pages changed)");
   } else {
     Serial.println("✗ Write failed");
   }
 }
 
+void writeTagRecord(const TagRecord& record) {
+  uint8_t uid[7]; uint8_t uidLength;
+  if (!waitForTag(uid, &uidLength)) return;
+  printWriteResult(uid, uidLength, writeRecordSlot(record));
+}
+
+void writeSongNumber(uint8_t songNum, uint8_t volume, uint8_t eq) {
+  Serial.print("\nPlace NFC tag to write song #");
+  Serial.println(songNum);
+  writeTagRecord(songRecord(songNum, volume, eq));
+}
+
+void writeControlTag(uint8_t command, uint8_t argument) {
+  Serial.println("\nPlace NFC tag to write control tag \"" +
+                 String(controlCommandName(command)) + " " + String(argument) + "\"");
+  writeTagRecord(controlRecord(command, argument));
+}
+
+void writeMetadata(const TagMetadata& metadata) {
+  uint8_t data[TAG_PAGE_SIZE + TAG_METADATA_MAX_PAYLOAD];
+  uint8_t pageCount = encodeTagMetadata(metadata, data);
+  if (pageCount == 0) {
+    Serial.println("Error: metadata is empty or too long");
+    return;
+  }
+  Serial.println("\nPlace NFC tag to write metadata (" + String(pageCount) + " pages)");
+  uint8_t uid[7]; uint8_t uidLength;
+  if (!waitForTag(uid, &uidLength)) return;
+  printWriteResult(uid, uidLength, writeTagPages(TAG_METADATA_PAGE, data, pageCount));
+}
+
 void readSongTag() {
   uint8_t uid[7]; uint8_t uidLength;
   Serial.println("Place NFC tag to read...");
-  bool success = false;
-  for (int i = 0; i < 50; i++) {
-    success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 200);
-    if (success) break;
+  if (!waitForTag(uid, &uidLength)) return;
+
+  TagRecord record;
+  TagReadStatus status = readTagRecord(record);
+  if (status != TAG_READ_OK) {
+    printReadError(status);
+    return;
+  }
+  if (record.type == TAG_RECORD_CONTROL) {
+    Serial.println("✓ Control tag: " + String(controlCommandName(record.command)) +
+                   " " + String(record.argument));
+  } else {
+    Serial.println("✓ Song number: " + String(record.track));
+    if (record.volume != TAG_PRESET_NONE) Serial.println("  Volume preset: " + String(record.volume));
+    if (record.eq != TAG_PRESET_NONE) Serial.println("  EQ preset: " + String(record.eq));
+  }
+}
+
+// ==================== PROVISIONING STATION ====================
+// "station [fast] <first> [last]" programs song tags first..last, one per
+// tag placed on the reader, and prints one line per tag with the write time
+// and what skipping unchanged pages saved. "fast" skips the verify readback:
+// the record goes into the spare slot, so a bad write leaves the previous
+// record readable. Any console input or 10 s without a new tag ends the run.
+const unsigned long STATION_TAG_TIMEOUT = 10000;
+
+bool waitForNewTag(uint8_t* uid, uint8_t* uidLength, const uint8_t* previousUid, uint8_t previousLength) {
+  unsigned long start = millis();
+  while (millis() - start < STATION_TAG_TIMEOUT && !Serial.available()) {
+    if (!nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, 200)) continue;
+    if (*uidLength != previousLength || memcmp(uid, previousUid, previousLength) != 0) return true;
+  }
+  return false;
+}
+
+void runStation(int first, int last, bool fast) {
+  Serial.println("\n🏭 Station: tags for tracks " + String(first) + "–" + String(last) +
+                 (fast ? " (fast, no verify)" : "") + ", place them one after another");
+  uint8_t previousUid[7] = {0};
+  uint8_t previousLength = 0;
+  unsigned long totalSaved = 0;
+  int written = 0;
+  for (int track = first; track <= last; track++) {
+    Serial.println("Place tag for track " + String(track) + "...");
+    uint8_t uid[7]; uint8_t uidLength;
+    if (!waitForNewTag(uid, &uidLength, previousUid, previousLength)) break;
+
+    TagWriteResult result = writeRecordSlot(songRecord(track), !fast);
+    Serial.println("STATION uid=" + uidToString(uid, uidLength) + " track=" + String(track) +
+                   " pages=" + String(result.pagesWritten) + "/" + String(result.pageCount) +
+                   " write_us=" + String(result.elapsedMicros) + " saved_us=" + String(result.savedMicros) +
+                   (!result.ok ? " FAILED" : result.verified ? " ok" : " unverified"));
+    if (!result.ok) {
+      track--;  // same track again on the next tag
+      continue;
+    }
+    metadataCacheForget(uid, uidLength);
+    memcpy(previousUid, uid, uidLength);
+    previousLength = uidLength;
+    totalSaved += result.savedMicros;
+    written++;
   }
-  if (!success) {
-    Serial.println("Timeout - no tag detected");
+  Serial.println("🏭 Station done: " + String(written) + " tags, " + String(totalSaved / 1000) +
+                 " ms saved by skipping unchanged pages");
+}
+
+// ==================== LEARN MODE ====================
+// "learn <track>" or "learn folder <n>" binds tags to tracks without any
+// RF write: each tag placed previews the next track (or playlist folder),
+// VOLUME UP binds it by UID and moves on, VOLUME DOWN skips the tag. The
+// binding lives in the tag library, so at play time the tag is recognised
+// from its UID alone and none of its pages are read.
+struct LearnState {
+  bool folders = false;
+  uint8_t next = 0;
+  uint8_t uid[7];
+  uint8_t uidLength = 0;  // tag waiting for confirmation, 0 if none
+} learn;
+
+void startLearnMode(bool folders, int first) {
+  stopSong();
+  learn.folders = folders;
+  learn.next = first;
+  learn.uidLength = 0;
+  currentMode = LEARN_MODE;
+  Serial.println("🎓 Learn mode: place tags one by one, VOLUME UP binds, VOLUME DOWN skips, "
+                 "'playmode' ends");
+}
+
+String learnTarget() {
+  return (learn.folders ? "playlist folder " : "track ") + String(learn.next);
+}
+
+void handleLearnEvent(const TagEvent& event) {
+  if (event.type == TAG_EVENT_METADATA) return;
+  stopSong();
+  if (event.type == TAG_EVENT_REMOVED) {
+    learn.uidLength = 0;
     return;
   }
+  memcpy(learn.uid, event.uid, event.uidLength);
+  learn.uidLength = event.uidLength;
+  Serial.println("🎓 " + uidToString(event.uid, event.uidLength) + " → " + learnTarget() + "?");
+  if (learn.folders) playFolderTrack(learn.next, 1);
+  else playSong(learn.next);
+}
 
-  int songNum = readSongNumberFromTag();
-  if (songNum != -1) Serial.println("✓ Song number: " + String(songNum));
+void checkLearnButtons() {
+  bool up, down;
+  readButtonPresses(up, down);
+  if (learn.uidLength == 0 || (!up && !down)) return;
+  if (up) {
+    if (!tagLibraryAssign(learn.uid, learn.uidLength, learn.folders ? 0 : learn.next,
+                          learn.folders ? learn.next : 0)) {
+      Serial.println("❌ Tag library full");
+      return;
+    }
+    Serial.println("✓ Bound " + uidToString(learn.uid, learn.uidLength) + " to " + learnTarget());
+    logEvent(LOG_TAG_BOUND, learn.folders, learn.next);
+    learn.next++;
+  } else {
+    Serial.println("↷ Skipped");
+  }
+  learn.uidLength = 0;
+  stopSong();
+  if (learn.next > 99) {
+    Serial.println("🎓 Learn mode done");
+    currentMode = PLAY_MODE;
+  }
 }
 
 // ==================== TAG HANDLING FOR PLAY MODE ====================
-void handleNewTag(const String& uid, uint8_t* rawUID, uint8_t length) {
+void handleNewTag(const TagEvent& event) {
   Serial.println("\n=== NFC TAG DETECTED ===");
-  Serial.println("  UID: " + uid);
-  int songNumber = readSongNumberFromTag();
-  if (songNumber == -1) {
-    stopSong();
+  Serial.println("  UID: " + uidToString(event.uid, event.uidLength));
+  statsRecordDetection();
+
+  // On-device assignments win over what is written on the tag
+  const TagEntry* entry = tagLibraryFind(event.uid, event.uidLength);
+  if (entry && entry->folder) {
+    if (state.isSongPlaying && state.currentFolder != entry->folder) stopSong();
+    if (!state.isSongPlaying) {
+      playFolderTrack(entry->folder, 1);
+      unsigned long latency = micros() - event.detectedAt;
+      statsRecordTagToPlay(latency);
+      logEvent(LOG_PLAY, entry->folder, 1, latency);
+      statsRecordPlay(event.uid, event.uidLength, entry->folder);
+    }
     return;
   }
-  if (state.isSongPlaying && state.currentTrack != songNumber) stopSong();
-  if (!state.isSongPlaying) playSong(songNumber);
-}
 
-void checkNFCTag() {
-  uint8_t uid[7];
-  uint8_t uidLength;
-  bool tagDetected = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100);
-  if (tagDetected) {
-    state.lastTagDetectionTime = millis();
-    bool isNewTag = !state.isTagPresent || !uidsMatch(uid, state.lastUID, uidLength);
-    if (isNewTag) {
-      String uidString = uidToString(uid, uidLength);
-      handleNewTag(uidString, uid, uidLength);
-      memcpy(state.lastUID, uid, uidLength);
-      state.lastUIDLength = uidLength;
-    }
-    state.isTagPresent = true;
+  TagRecord record = event.record;
+  if (entry && entry->track) {
+    record = TagRecord();
+    record.type = TAG_RECORD_SONG;
+    record.track = entry->track;
   } else {
-    if (state.isTagPresent) {
-      state.isTagPresent = false;
+    bool valid = event.readStatus == TAG_READ_OK;
+    if (record.type != TAG_RECORD_CONTROL) {
+      tagLibraryNoteSeen(event.uid, event.uidLength, valid ? record.track : -1);
     }
+    if (!valid) {
+      printReadError(event.readStatus);
+      if (event.readStatus == TAG_READ_FAILED) {
+        logEvent(LOG_READ_FAILURE, 0, 0,
+                 (uint32_t)event.uid[0] << 24 | event.uid[1] << 16 | event.uid[2] << 8 | event.uid[3]);
+      }
+      stopSong();
+      return;
+    }
+  }
+  if (record.type == TAG_RECORD_CONTROL) {
+    runControlTag(record);
+    return;
+  }
+  int songNumber = record.track;
+  if (state.isSongPlaying && (state.currentFolder != 0 || state.currentTrack != songNumber)) stopSong();
+  if (!state.isSongPlaying) {
+    playSong(songNumber, record.volume, record.eq);
+    unsigned long latency = micros() - event.detectedAt;
+    statsRecordTagToPlay(latency);
+    logEvent(LOG_PLAY, 0, songNumber, latency);
+    statsRecordPlay(event.uid, event.uidLength, songNumber);
   }
 }
 
-void handleGracePeriod() {
+// Metadata only ever arrives for the tag that is still on the box, so a
+// track count belongs to the playlist it started.
+void applyTagMetadata(const TagMetadata& metadata) {
+  if (state.currentFolder != 0 && metadata.trackCount > 0) state.folderTrackCount = metadata.trackCount;
+}
+
+void handleTagMetadata(const TagEvent& event) {
+  metadataCacheStore(event.uid, event.uidLength, event.metadataHeader.checksum, event.metadata);
+  Serial.println("📖 Tag metadata:");
+  printTagMetadata(event.metadata);
+  applyTagMetadata(event.metadata);
+}
+
+// Tag library assignments turn any tag into a song tag
+bool isControlTag(const TagEvent& event) {
+  const TagEntry* entry = tagLibraryFind(event.uid, event.uidLength);
+  if (entry && (entry->folder || entry->track)) return false;
+  return event.readStatus == TAG_READ_OK && event.record.type == TAG_RECORD_CONTROL;
+}
+
+// The song tag is gone; music plays on for the grace period. The grace
+// period runs from the last time the tag was seen, not from when its
+// absence was noticed.
+void releaseSongTag(unsigned long lastSeen) {
+  state.isTagPresent = false;
+  if (state.isSongPlaying) armTimerAt(state.graceTimer, lastSeen + TAG_GRACE_PERIOD);
+}
+
+void handleTagEvent(const TagEvent& event) {
+  if (currentMode == LEARN_MODE) {
+    handleLearnEvent(event);
+    return;
+  }
+  if (event.type == TAG_EVENT_METADATA) {
+    handleTagMetadata(event);
+    return;
+  }
+  // Foreign cards neither start nor stop anything, and control tags only
+  // act on the box. Either one taking the song tag's place counts as that
+  // tag's removal, so the grace period runs and ends the music even if it
+  // stays on the reader.
+  bool controlTag = event.type == TAG_EVENT_ARRIVED && isControlTag(event);
+  if (event.type == TAG_EVENT_ARRIVED && (event.readStatus == TAG_READ_IGNORED || controlTag)) {
+    if (state.isTagPresent) releaseSongTag(event.lastSeen);
+    state.isOtherTagPresent = true;
+    if (controlTag) handleNewTag(event);
+    return;
+  }
+  if (event.type == TAG_EVENT_REMOVED) {
+    if (state.isOtherTagPresent) {
+      state.isOtherTagPresent = false;
+      return;
+    }
+    releaseSongTag(event.lastSeen);
+    return;
+  }
+  state.isTagPresent = true;
+  state.isOtherTagPresent = false;
+  timers.cancel(state.graceTimer);
+  handleNewTag(event);
+
+  if (event.metadataHeader.length == 0) return;
+  const TagMetadata* cached = metadataCacheFind(event.uid, event.uidLength, event.metadataHeader.checksum);
+  if (!cached) return;
+  nfcSkipMetadata();
+  applyTagMetadata(*cached);
+}
+
+void onGracePeriodExpired(void*) {
   if (state.isTagPresent || !state.isSongPlaying) return;
-  unsigned long timeSinceRemoval = millis() - state.lastTagDetectionTime;
-  if (timeSinceRemoval > TAG_GRACE_PERIOD) stopSong();
+  statsRecordGraceStop();
+  logEvent(LOG_GRACE_STOP);
+  stopSong();
+}
+
+// ==================== JITTER BENCHMARK ====================
+// "bench <seconds> [load_ms]" clears the poll-lateness histogram and burns
+// load_ms of CPU on every service tick, standing in for audio decoding and
+// web work, then reports how late NFC polls started. Run it with the same
+// load on the single-core and dual-core envs to compare detection jitter.
+struct Benchmark {
+  WheelTimer end;  // armed while the benchmark runs
+  unsigned long loadMicros = 0;
+} benchmark;
+
+void startBenchmark(unsigned long seconds, unsigned long loadMillis) {
+  stats.pollLatenessMicros.reset();
+  benchmark.loadMicros = loadMillis * 1000;
+  armTimer(benchmark.end, seconds * 1000);
+  Serial.println("⏱️  Benchmark: " + String(seconds) + " s with " + String(loadMillis) +
+                 " ms load per service tick");
+}
+
+void runBenchmarkLoad() {
+  if (!benchmark.end.armed()) return;
+  unsigned long busyStart = micros();
+  while (micros() - busyStart < benchmark.loadMicros) {}
+}
+
+void onBenchmarkEnd(void*) {
+  const Histogram& h = stats.pollLatenessMicros;
+#ifdef DUAL_CORE_NFC
+  Serial.print("BENCH dual-core");
+#else
+  Serial.print("BENCH single-core");
+#endif
+  Serial.println(" load_us=" + String(benchmark.loadMicros) + " polls=" + String(h.count()) +
+                 " late_p50_us=" + String(h.percentile(50)) +
+                 " late_p99_us=" + String(h.percentile(99)) +
+                 " late_max_us=" + String(h.maxValue()));
 }
 
 // ==================== COMMAND HANDLER ====================
+void handleControlWriteCommand(const String& args) {
+  int space = args.indexOf(' ');
+  String name = space < 0 ? args : args.substring(0, space);
+  int argument = space < 0 ? 0 : args.substring(space + 1).toInt();
+
+  uint8_t command = 0;
+  for (uint8_t c = 1; c < CONTROL_COMMAND_COUNT; c++) {
+    if (name == controlCommandName(c)) command = c;
+  }
+  if (command == 0 || argument < 0 || argument > 255 ||
+      (command == CONTROL_SET_VOLUME && argument > MAX_VOLUME)) {
+    Serial.println("Error: use volume 0–30, shuffle, sleep <minutes> or lock");
+    return;
+  }
+  currentMode = WRITE_MODE;
+  nfcAcquire();
+  writeControlTag(command, argument);
+  nfcRelease();
+  currentMode = PLAY_MODE;
+}
+
+// writemeta <title>[;tracks[;artwork[;chapter starts in seconds, comma separated]]]
+void handleMetadataWriteCommand(const String& args) {
+  TagMetadata metadata;
+  String fields[4];
+  int start = 0;
+  for (uint8_t i = 0; i < 4 && start <= (int)args.length(); i++) {
+    int end = args.indexOf(';', start);
+    if (end < 0) end = args.length();
+    fields[i] = args.substring(start, end);
+    fields[i].trim();
+    start = end + 1;
+  }
+  fields[0].toCharArray(metadata.title, sizeof(metadata.title));
+  if (fields[1].length() > 0) metadata.trackCount = constrain(fields[1].toInt(), 0, 255);
+  if (fields[2].length() > 0) metadata.artwork = constrain(fields[2].toInt(), 0, TAG_ARTWORK_NONE - 1);
+  for (int pos = 0; pos < (int)fields[3].length() && metadata.chapterCount < TAG_MAX_CHAPTERS;) {
+    int comma = fields[3].indexOf(',', pos);
+    if (comma < 0) comma = fields[3].length();
+    metadata.chapters[metadata.chapterCount++] = fields[3].substring(pos, comma).toInt();
+    pos = comma + 1;
+  }
+  currentMode = WRITE_MODE;
+  nfcAcquire();
+  writeMetadata(metadata);
+  nfcRelease();
+  currentMode = PLAY_MODE;
+}
+
 void handleSerialCommands() {
   if (!Serial.available()) return;
   String cmd = Serial.readStringUntil('\n');
   cmd.trim();
 
   if (cmd.startsWith("write ")) {
-    int songNum = cmd.substring(6).toInt();
-    if (songNum >= 1 && songNum <= 99) {
+    // write <num> [volume] [eq]
+    int values[3] = {0, TAG_PRESET_NONE, TAG_PRESET_NONE};
+    String args = cmd.substring(6);
+    for (uint8_t i = 0; i < 3 && args.length() > 0; i++) {
+      args.trim();
+      int space = args.indexOf(' ');
+      values[i] = (space < 0 ? args : args.substring(0, space)).toInt();
+      args = space < 0 ? "" : args.substring(space + 1);
+    }
+    int songNum = values[0];
+    if (songNum < 1 || songNum > 99) {
+      Serial.println("Error: number must be 1–99");
+    } else if (values[1] != TAG_PRESET_NONE && (values[1] < MIN_VOLUME || values[1] > MAX_PRESET_VOLUME)) {
+      Serial.println("Error: volume preset must be 0–" + String(MAX_PRESET_VOLUME));
+    } else if (values[2] != TAG_PRESET_NONE && (values[2] < 0 || values[2] >= EQ_PRESET_COUNT)) {
+      Serial.println("Error: EQ preset must be 0–5 (normal, pop, rock, jazz, classic, bass)");
+    } else {
       currentMode = WRITE_MODE;
-      writeSongNumber(songNum);
+      nfcAcquire();
+      writeSongNumber(songNum, values[1], values[2]);
+      nfcRelease();
       currentMode = PLAY_MODE;
+    }
+  } else if (cmd.startsWith("control ")) {
+    handleControlWriteCommand(cmd.substring(8));
+  } else if (cmd.startsWith("station ")) {
+    String args = cmd.substring(8);
+    bool fast = args.startsWith("fast ");
+    if (fast) args = args.substring(5);
+    int space = args.indexOf(' ');
+    int first = (space < 0 ? args : args.substring(0, space)).toInt();
+    int last = space < 0 ? first : args.substring(space + 1).toInt();
+    if (first < 1 || last < first || last > 99) {
+      Serial.println("Error: station [fast] <first> [last], tracks 1–99");
     } else {
-      Serial.println("Error: number must be 1–99");
+      currentMode = WRITE_MODE;
+      nfcAcquire();
+      runStation(first, last, fast);
+      nfcRelease();
+      currentMode = PLAY_MODE;
     }
   } else if (cmd == "read") {
     currentMode = READ_MODE;
+    nfcAcquire();
     readSongTag();
+    nfcRelease();
     currentMode = PLAY_MODE;
+  } else if (cmd == "stats") {
+    printStats();
+  } else if (cmd == "state") {
+    printPlayerState();
+  } else if (cmd == "dump") {
+    printStatsDump();
+  } else if (cmd == "log dump") {
+    eventLogDump();
+  } else if (cmd == "codecs") {
+    printCodecBenchmark();
+  } else if (cmd == "pwm") {
+    printPwmAudio();
+  } else if (cmd.startsWith("seek ")) {
+    long seconds = cmd.substring(5).toInt();
+    if (seconds >= 0) pwmPlayerSeek(seconds * 1000UL);
+    else Serial.println("Error: seek <seconds>");
+  } else if (cmd == "visualizer") {
+    printVisualizer();
+  } else if (cmd == "energy") {
+    printEnergy();
+  } else if (cmd == "energy reset") {
+    energyReset();
+    Serial.println("⚡ Energy counters reset");
+  } else if (cmd.startsWith("energy battery ")) {
+    int capacity = cmd.substring(15).toInt();
+    if (capacity > 0 && capacity <= 65535) energySetBattery(capacity);
+    else Serial.println("Error: energy battery <mAh>");
+  } else if (cmd.startsWith("energy ")) {
+    String args = cmd.substring(7);
+    int space = args.indexOf(' ');
+    float milliamps = space < 0 ? -1 : args.substring(space + 1).toFloat();
+    if (milliamps < 0 || !energySetCurrent(args.substring(0, space).c_str(), milliamps)) {
+      Serial.println("Error: energy <state> <mA>, state as listed by `energy`");
+    }
+  } else if (cmd == "power") {
+    printAudioPower();
+  } else if (cmd.startsWith("power idle ")) {
+    String value = cmd.substring(11);
+    long seconds = value.toInt();
+    if ((seconds > 0 && seconds <= 65535) || value == "0") audioPowerSetIdleTimeout(seconds);
+    else Serial.println("Error: power idle <seconds>, 0 never sleeps");
+  } else if (cmd == "gains") {
+    printTrackGains();
+  } else if (cmd == "gains clear") {
+    trackGainClear();
+    Serial.println("🎚️ Track gains cleared");
+  } else if (cmd.startsWith("gains ")) {
+    if (trackGainLoad(cmd.substring(6))) printTrackGains();
+    else Serial.println("Error: gains <hex>, as printed by tools/loudness_scan");
+  } else if (cmd.startsWith("gain ")) {
+    // gain <folder> <track> <dB>, folder 0 for single tracks
+    String args = cmd.substring(5);
+    int first = args.indexOf(' ');
+    int second = first < 0 ? -1 : args.indexOf(' ', first + 1);
+    int folder = args.substring(0, first).toInt();
+    int track = second < 0 ? 0 : args.substring(first + 1, second).toInt();
+    float db = second < 0 ? 0 : args.substring(second + 1).toFloat();
+    if (track < 1 || track > 255 || folder < 0 || folder > 99 || !trackGainSet(folder, track, db)) {
+      Serial.println("Error: gain <folder> <track> <dB>, folder 0 for single tracks");
+    }
+  } else if (cmd.startsWith("bench ")) {
+    String args = cmd.substring(6);
+    int space = args.indexOf(' ');
+    int seconds = (space < 0 ? args : args.substring(0, space)).toInt();
+    int load = space < 0 ? 0 : args.substring(space + 1).toInt();
+    if (seconds > 0 && load >= 0) startBenchmark(seconds, load);
+    else Serial.println("Error: bench <seconds> [load_ms]");
+  } else if (cmd.startsWith("writemeta ")) {
+    handleMetadataWriteCommand(cmd.substring(10));
+  } else if (cmd == "meta") {
+    printMetadataCache();
+  } else if (cmd == "tags") {
+    printTagLibrary();
+  } else if (cmd.startsWith("learn ")) {
+    String args = cmd.substring(6);
+    bool folders = args.startsWith("folder ");
+    int first = (folders ? args.substring(7) : args).toInt();
+    if (first < 1 || first > 99) Serial.println("Error: learn [folder] <first>, 1–99");
+    else startLearnMode(folders, first);
   } else if (cmd == "playmode") {
+    if (currentMode == LEARN_MODE) stopSong();
     currentMode = PLAY_MODE;
     Serial.println("Switched to PLAY MODE");
   } else if (cmd.length() > 0) {
     Serial.println("Commands:");
-    Serial.println("  write <num> - program tag");
+    Serial.println("  write <num> [vol] [eq] - program tag, optional presets");
+    Serial.println("  control <volume N|shuffle|sleep MIN|lock> - program control tag");
+    Serial.println("  writemeta <title>[;tracks[;artwork[;sec,sec,...]]] - write tag metadata");
+    Serial.println("  station [fast] <first> [last] - program a batch of song tags");
     Serial.println("  read        - read tag");
+    Serial.println("  state       - what the player is doing");
+    Serial.println("  stats       - usage and latency counters");
+    Serial.println("  dump        - counters as a STATSDUMP line for tools/fleet_stats");
+    Serial.println("  log dump    - persistent event log, oldest first");
+    Serial.println("  energy [reset] - estimated charge per subsystem and battery life");
+    Serial.println("  energy <state> <mA> | energy battery <mAh> - calibrate the estimate");
+    Serial.println("  power [idle <s>] - audio sleep after idle time, wake latency, savings");
+    Serial.println("  gains [clear] | gain <folder> <track> <dB> - per-track loudness gains");
+    Serial.println("  learn [folder] <first> - bind tags by UID, confirm with VOLUME UP");
+    Serial.println("  tags        - list known tags");
+    Serial.println("  meta        - cached tag metadata");
+    Serial.println("  bench <s> [load_ms] - measure NFC poll jitter");
+    Serial.println("  codecs      - decode cost per audio codec");
+    Serial.println("  visualizer  - LED visualiser windows and timing");
+    Serial.println("  pwm         - PWM audio output underruns and interrupt load");
+    Serial.println("  seek <s>    - jump within the playing MP3 (PWM audio)");
     Serial.println("  playmode    - normal playback");
   }
 }
 
+// ==================== STATE SNAPSHOT ====================
+void publishState() {
+  PlayerSnapshot s;
+  s.tagPresent = state.isTagPresent;
+  s.playing = state.isSongPlaying;
+  s.track = state.currentTrack;
+  s.folder = state.currentFolder;
+  s.volume = state.currentVolume;
+  s.eq = state.currentEq;
+  s.shuffle = state.shuffle;
+  s.buttonsLocked = buttons.locked;
+  s.sleepTimerArmed = state.sleepTimer.armed();
+  s.learning = currentMode == LEARN_MODE;
+  publishPlayerState(s);
+}
+
+// ==================== TIMER CALLBACKS ====================
+// Inputs without an interrupt (console, buttons, DFPlayer frames, web
+// sockets) are sampled on one periodic service tick.
+void onServiceTick(void*) {
+  handleSerialCommands();
+  pwmPlayerService();
+  audioPowerService();
+  if (currentMode == PLAY_MODE) {
+    checkVolumeButtons();
+    checkPlayerEvents();
+  } else if (currentMode == LEARN_MODE) {
+    checkLearnButtons();
+  }
+  runBenchmarkLoad();
+  webUiLoop();
+  armPeriodic(serviceTimer, SERVICE_INTERVAL);
+}
+
+void onNfcTick(void*) {
+  TagEvent event;
+  nfcMergeStats();
+  if (currentMode != PLAY_MODE && currentMode != LEARN_MODE) {
+    armPeriodic(nfcTimer, NFC_EVENT_INTERVAL);
+    return;
+  }
+#ifdef DUAL_CORE_NFC
+  while (nfcNextEvent(event)) handleTagEvent(event);
+#else
+  // One blocking poll per tick, late by however long loop() kept the tick
+  // waiting. millis() is micros() / 1000 of the same clock, so the expiry
+  // scaled back up keeps microsecond resolution.
+  statsRecordPollLateness(micros() - nfcTimer.expiry * 1000UL);
+  if (nfcNextEvent(event)) handleTagEvent(event);
+#endif
+  armPeriodic(nfcTimer, NFC_EVENT_INTERVAL);
+}
+
+void initializeTimers() {
+  serviceTimer.callback = onServiceTick;
+  nfcTimer.callback = onNfcTick;
+  state.graceTimer.callback = onGracePeriodExpired;
+  state.sleepTimer.callback = onSleepTimer;
+  benchmark.end.callback = onBenchmarkEnd;
+  armTimer(serviceTimer, SERVICE_INTERVAL);
+  armTimer(nfcTimer, NFC_EVENT_INTERVAL);
+}
+
 // ==================== MAIN PROGRAM ====================
 void setup() {
   Serial.begin(115200);
   delay(1000);
-  Serial.println("\n🎵 ESP32 NFC Music Player + Tag Writer v1.0\n");
+  timersBegin();
+  energyBegin();
+  Serial.println("\n🎵 ESP32 NFC Music Player + Tag Writer v" FIRMWARE_VERSION "\n");
+  eventLogBegin();
   initializeButtons();
   initializeLED();
+  visualizerBegin();
   initializeI2C();
   initializeDFPlayer();
   initializeNFC();
+  tagLibraryBegin();  // the NFC task looks up bindings from its first poll
+  nfcBegin();
+  trackGainBegin();
+  wifiLinkBegin();
+  telemetryBegin();
+  webUiBegin();
+  initializeTimers();
+  publishState();
   Serial.println("Type 'read' or 'write <number>' to access tag mode.\n");
 }
 
 void loop() {
-  handleSerialCommands();
-
-  if (currentMode == PLAY_MODE) {
-    unsigned long now = millis();
-    checkVolumeButtons();
-    if (now - state.lastNFCCheckTime >= NFC_CHECK_INTERVAL) {
-      checkNFCTag();
-      state.lastNFCCheckTime = now;
-    }
-    handleGracePeriod();
-  }
-
-  delay(10);
+  runTimers();
+  publishState();
+  sleepUntilNextTimer();
 }
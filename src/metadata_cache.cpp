@@ -0,0 +1,78 @@
+#include "metadata_cache.h"
+
+struct MetadataCacheEntry {
+  uint8_t uid[7];
+  uint8_t uidLength;  // 0 = free
+  uint8_t checksum;
+  unsigned long lastUsed;
+  TagMetadata metadata;
+};
+
+static MetadataCacheEntry cache[METADATA_CACHE_SIZE];
+
+static MetadataCacheEntry* findEntry(const uint8_t* uid, uint8_t uidLength) {
+  for (MetadataCacheEntry& e : cache) {
+    if (e.uidLength == uidLength && memcmp(e.uid, uid, uidLength) == 0) return &e;
+  }
+  return nullptr;
+}
+
+const TagMetadata* metadataCacheFind(const uint8_t* uid, uint8_t uidLength, uint8_t checksum) {
+  MetadataCacheEntry* e = findEntry(uid, uidLength);
+  if (!e || e->checksum != checksum) return nullptr;
+  e->lastUsed = millis();
+  return &e->metadata;
+}
+
+// Replaces the entry for this UID, or else the least recently used one
+void metadataCacheStore(const uint8_t* uid, uint8_t uidLength, uint8_t checksum, const TagMetadata& metadata) {
+  MetadataCacheEntry* e = findEntry(uid, uidLength);
+  if (!e) {
+    e = &cache[0];
+    for (MetadataCacheEntry& candidate : cache) {
+      if (candidate.uidLength == 0) { e = &candidate; break; }
+      if ((long)(candidate.lastUsed - e->lastUsed) < 0) e = &candidate;
+    }
+  }
+  memcpy(e->uid, uid, uidLength);
+  e->uidLength = uidLength;
+  e->checksum = checksum;
+  e->lastUsed = millis();
+  e->metadata = metadata;
+}
+
+void metadataCacheForget(const uint8_t* uid, uint8_t uidLength) {
+  MetadataCacheEntry* e = findEntry(uid, uidLength);
+  if (e) e->uidLength = 0;
+}
+
+void printTagMetadata(const TagMetadata& metadata) {
+  if (metadata.title[0]) Serial.println("    Title: " + String(metadata.title));
+  if (metadata.artwork != TAG_ARTWORK_NONE) Serial.println("    Artwork: #" + String(metadata.artwork));
+  if (metadata.trackCount) Serial.println("    Tracks: " + String(metadata.trackCount));
+  if (metadata.chapterCount == 0) return;
+  String chapters = "    Chapters:";
+  for (uint8_t i = 0; i < metadata.chapterCount; i++) {
+    uint16_t s = metadata.chapters[i];
+    chapters += " " + String(s / 60) + (s % 60 < 10 ? ":0" : ":") + String(s % 60);
+  }
+  Serial.println(chapters);
+}
+
+void printMetadataCache() {
+  Serial.println("Cached tag metadata:");
+  bool any = false;
+  for (const MetadataCacheEntry& e : cache) {
+    if (e.uidLength == 0) continue;
+    String uid = "";
+    for (uint8_t j = 0; j < e.uidLength; j++) {
+      if (e.uid[j] < 0x10) uid += "0";
+      uid += String(e.uid[j], HEX);
+    }
+    uid.toUpperCase();
+    Serial.println("  " + uid);
+    printTagMetadata(e.metadata);
+    any = true;
+  }
+  if (!any) Serial.println("  (none yet)");
+}
@@ -0,0 +1,341 @@
+#include "nfc_reader.h"
+#include "board_config.h"
+#include "energy.h"
+#include "pn532_ext.h"
+#include "stats.h"
+#include "tag_library.h"
+
+#ifdef DUAL_CORE_NFC
+#include <SeqLock.h>
+#include <SpscQueue.h>
+#endif
+
+Adafruit_PN532 nfc(SDA_PIN, SCL_PIN);
+
+const uint8_t ARRIVAL_READ_PAGES = TAG_METADATA_PAYLOAD_PAGE - TAG_RECORD_PAGE + 1;
+
+// Owned by whichever side polls: loop() on single-core boards, the NFC task
+// otherwise. The playback side only ever sees TagEvents.
+struct ReaderState {
+  uint8_t uid[7] = {0};
+  uint8_t uidLength = 0;
+  bool present = false;
+  unsigned long lastSeen = 0;
+  unsigned long nextPollDue = 0;  // micros(), NFC task schedule
+  // Background metadata read for the current tag
+  TagMetadataHeader metadataHeader;
+  uint8_t metadata[TAG_METADATA_MAX_PAYLOAD + NTAG_READ_SIZE];
+  uint8_t metadataFetched = 0;  // payload bytes read so far
+  bool metadataPending = false;
+} reader;
+
+// ==================== NEGATIVE CACHE ====================
+// Targets that are never worth a page read. removedAt is 0 while the
+// target is in the field.
+struct IgnoredTarget {
+  uint8_t uid[7];
+  uint8_t uidLength;  // 0 for a free slot
+  uint16_t atqa;
+  uint8_t sak;
+  unsigned long removedAt;
+};
+
+static IgnoredTarget ignoredTargets[NFC_NEGATIVE_CACHE_SIZE];
+
+static IgnoredTarget* findIgnored(const uint8_t* uid, uint8_t uidLength) {
+  for (IgnoredTarget& t : ignoredTargets) {
+    if (t.uidLength == uidLength && memcmp(t.uid, uid, uidLength) == 0) return &t;
+  }
+  return nullptr;
+}
+
+static bool isIgnored(const uint8_t* uid, uint8_t uidLength, uint16_t atqa, uint8_t sak) {
+  IgnoredTarget* t = findIgnored(uid, uidLength);
+  if (!t || t->atqa != atqa || t->sak != sak) return false;
+  if (t->removedAt != 0 && millis() - t->removedAt >= NFC_NEGATIVE_CACHE_HOLD) {
+    t->uidLength = 0;
+    return false;
+  }
+  t->removedAt = 0;
+  return true;
+}
+
+// Takes the same target's entry, a free one, or the one whose target left
+// longest ago. Targets still in the field are only replaced when all are.
+static void rememberIgnored(const uint8_t* uid, uint8_t uidLength, uint16_t atqa, uint8_t sak) {
+  IgnoredTarget* slot = findIgnored(uid, uidLength);
+  unsigned long now = millis();
+  for (IgnoredTarget& t : ignoredTargets) {
+    if (slot) break;
+    if (t.uidLength == 0) slot = &t;
+  }
+  if (!slot) {
+    slot = &ignoredTargets[0];
+    for (IgnoredTarget& t : ignoredTargets) {
+      unsigned long gone = t.removedAt ? now - t.removedAt : 0;
+      unsigned long slotGone = slot->removedAt ? now - slot->removedAt : 0;
+      if (gone > slotGone) slot = &t;
+    }
+  }
+  memcpy(slot->uid, uid, uidLength);
+  slot->uidLength = uidLength;
+  slot->atqa = atqa;
+  slot->sak = sak;
+  slot->removedAt = 0;
+}
+
+// Starts the hold time of the target that just left the field
+static void noteGone(const uint8_t* uid, uint8_t uidLength) {
+  IgnoredTarget* t = findIgnored(uid, uidLength);
+  if (t && t->removedAt == 0) t->removedAt = millis() | 1;
+}
+
+static void clearIgnored() { memset(ignoredTargets, 0, sizeof(ignoredTargets)); }
+
+void initializeNFC() {
+  Serial.println("Initializing PN532 NFC Reader...");
+  nfc.begin();
+
+  uint32_t version = nfc.getFirmwareVersion();
+  if (!version) {
+    Serial.println("❌ ERROR: PN532 not found!");
+    while (1);
+  }
+
+  Serial.print("✅ Found PN5");
+  Serial.println((version >> 24) & 0xFF, HEX);
+  nfc.SAMConfig();
+}
+
+static TagReadStatus readRecordPages(uint8_t* data, TagRecord& record) {
+  if (!pn532FastRead(nfc, TAG_RECORD_PAGE, TAG_RECORD_PAGE + ARRIVAL_READ_PAGES - 1, data)) {
+    record = TagRecord();
+    return TAG_READ_FAILED;
+  }
+  return parseTagRecord(data, record) ? TAG_READ_OK : TAG_READ_UNPROGRAMMED;
+}
+
+TagReadStatus readTagRecord(TagRecord& record) {
+  uint8_t data[ARRIVAL_READ_PAGES * TAG_PAGE_SIZE];
+  TagReadStatus status = readRecordPages(data, record);
+  if (status == TAG_READ_FAILED) statsRecordReadFailure();
+  return status;
+}
+
+// Arrival read failures are counted where the event is consumed, so only
+// loop() ever writes `stats`
+static void recordEventStats(const TagEvent& event) {
+  if (event.type == TAG_EVENT_ARRIVED && event.readStatus == TAG_READ_FAILED) statsRecordReadFailure();
+}
+
+// The record read already returned the header page and the first payload
+// page; remember them so the background read starts at page 10.
+static void startMetadataRead(const uint8_t* data, TagEvent& event) {
+  const uint8_t* header = data + (TAG_METADATA_PAGE - TAG_RECORD_PAGE) * TAG_PAGE_SIZE;
+  reader.metadataPending = parseTagMetadataHeader(header, reader.metadataHeader);
+  event.metadataHeader = reader.metadataHeader;
+  if (!reader.metadataPending) return;
+  memcpy(reader.metadata, header + TAG_PAGE_SIZE, TAG_PAGE_SIZE);
+  reader.metadataFetched = TAG_PAGE_SIZE;
+}
+
+// One NTAG READ per poll, so a long payload never delays the next
+// detection by more than a few milliseconds. A failed chunk is retried on
+// the next poll.
+static bool continueMetadataRead(TagEvent& event) {
+  if (reader.metadataFetched < reader.metadataHeader.length) {
+    uint8_t page = TAG_METADATA_PAYLOAD_PAGE + reader.metadataFetched / TAG_PAGE_SIZE;
+    if (!pn532ReadPages(nfc, page, reader.metadata + reader.metadataFetched)) return false;
+    reader.metadataFetched += NTAG_READ_SIZE;
+    if (reader.metadataFetched < reader.metadataHeader.length) return false;
+  }
+  reader.metadataPending = false;
+  if (!parseTagMetadata(reader.metadata, reader.metadataHeader, event.metadata)) {
+    Serial.println("⚠️  Tag metadata checksum mismatch");
+    return false;
+  }
+  event.type = TAG_EVENT_METADATA;
+  memcpy(event.uid, reader.uid, reader.uidLength);
+  event.uidLength = reader.uidLength;
+  event.lastSeen = reader.lastSeen;
+  return true;
+}
+
+static bool detectOnce(TagEvent& event) {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  bool tagDetected = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100);
+  if (tagDetected) {
+    unsigned long detectedAt = micros();
+    reader.lastSeen = millis();
+    bool isNewTag = !reader.present || uidLength != reader.uidLength ||
+                    memcmp(uid, reader.uid, uidLength) != 0;
+    reader.present = true;
+    if (!isNewTag) return reader.metadataPending && continueMetadataRead(event);
+
+    if (reader.uidLength) noteGone(reader.uid, reader.uidLength);
+    memcpy(reader.uid, uid, uidLength);
+    reader.uidLength = uidLength;
+    event.type = TAG_EVENT_ARRIVED;
+    memcpy(event.uid, uid, uidLength);
+    event.uidLength = uidLength;
+    reader.metadataPending = false;
+    event.metadataHeader = TagMetadataHeader();
+    TagEntry binding;
+    uint16_t atqa;
+    uint8_t sak;
+    pn532LastTarget(atqa, sak);
+    if (tagLibraryLookup(uid, uidLength, binding)) {
+      event.readStatus = TAG_READ_SKIPPED;
+      event.record = TagRecord();
+    } else if (!isNtag21x(atqa, sak) || isIgnored(uid, uidLength, atqa, sak)) {
+      event.readStatus = TAG_READ_IGNORED;
+      event.record = TagRecord();
+      rememberIgnored(uid, uidLength, atqa, sak);
+    } else {
+      uint8_t data[ARRIVAL_READ_PAGES * TAG_PAGE_SIZE];
+      event.readStatus = readRecordPages(data, event.record);
+      if (event.readStatus != TAG_READ_FAILED) startMetadataRead(data, event);
+      if (event.readStatus == TAG_READ_UNPROGRAMMED) rememberIgnored(uid, uidLength, atqa, sak);
+    }
+    event.detectedAt = detectedAt;
+    event.lastSeen = reader.lastSeen;
+    return true;
+  }
+
+  if (!reader.present) return false;
+  reader.present = false;
+  noteGone(reader.uid, reader.uidLength);
+  reader.metadataPending = false;
+  event.type = TAG_EVENT_REMOVED;
+  event.lastSeen = reader.lastSeen;
+  return true;
+}
+
+// The field is on from the start of a poll until its last tag read
+static bool pollOnce(TagEvent& event) {
+  energyEnter(POWER_NFC_FIELD_ON);
+  bool gotEvent = detectOnce(event);
+  energyEnter(POWER_NFC_FIELD_OFF);
+  return gotEvent;
+}
+
+#ifndef DUAL_CORE_NFC
+// ==================== SINGLE CORE: POLL FROM loop() ====================
+void nfcBegin() {}
+
+bool nfcNextEvent(TagEvent& event) {
+  if (!pollOnce(event)) return false;
+  recordEventStats(event);
+  return true;
+}
+
+void nfcAcquire() { clearIgnored(); }
+void nfcRelease() {}
+void nfcMergeStats() {}
+void nfcSkipMetadata() { reader.metadataPending = false; }
+
+#else
+// ==================== DUAL CORE: NFC TASK ====================
+// Arduino's loop() runs on core 1 (ARDUINO_RUNNING_CORE), so the NFC task
+// takes core 0 and keeps its schedule with vTaskDelayUntil.
+const BaseType_t NFC_TASK_CORE = 0;
+const UBaseType_t NFC_TASK_PRIORITY = 2;
+
+enum NfcCommand : uint8_t { NFC_PAUSE, NFC_RESUME, NFC_SKIP_METADATA };
+
+static SpscQueue<TagEvent, 8> tagEvents;      // NFC task → loop()
+static SpscQueue<NfcCommand, 4> nfcCommands;  // loop() → NFC task
+static std::atomic<bool> nfcPaused{false};
+
+// The task's poll lateness, cumulative. loop() merges what is new into
+// `stats` (nfcMergeStats), so a reset or copy on core 1 never races the
+// task.
+static Histogram taskLateness;                 // NFC task only
+static SeqLock<Histogram> publishedLateness;  // NFC task → loop()
+static Histogram mergedLateness;               // loop(): the part already in `stats`
+
+// How late a poll starts compared to its schedule. This is the jitter the
+// rest of the firmware adds to tag detection. (On single-core boards
+// onNfcTick measures it against the NFC timer.)
+static void recordPollLateness() {
+  unsigned long now = micros();
+  long lateness = (long)(now - reader.nextPollDue);
+  if (reader.nextPollDue != 0 && lateness >= 0) {
+    taskLateness.record(lateness);
+    publishedLateness.publish(taskLateness);
+  }
+  reader.nextPollDue += NFC_CHECK_INTERVAL * 1000;
+  if (reader.nextPollDue == 0 || (long)(now - reader.nextPollDue) >= 0) {
+    reader.nextPollDue = now + NFC_CHECK_INTERVAL * 1000;
+  }
+}
+
+static void nfcTask(void*) {
+  TickType_t lastWake = xTaskGetTickCount();
+  bool paused = false;
+  for (;;) {
+    NfcCommand command;
+    while (nfcCommands.pop(command)) {
+      if (command == NFC_SKIP_METADATA) reader.metadataPending = false;
+      else paused = command == NFC_PAUSE;
+      if (command == NFC_PAUSE) clearIgnored();
+    }
+    nfcPaused.store(paused, std::memory_order_release);
+
+    if (!paused) {
+      recordPollLateness();
+      TagEvent event;
+      if (pollOnce(event) && !tagEvents.push(event)) {
+        Serial.println("⚠️  Tag event queue full, event dropped");
+      }
+    }
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(paused ? 10 : NFC_CHECK_INTERVAL));
+  }
+}
+
+void nfcBegin() {
+  xTaskCreatePinnedToCore(nfcTask, "nfc", 4096, nullptr, NFC_TASK_PRIORITY, nullptr, NFC_TASK_CORE);
+  Serial.println("✅ NFC polling on core " + String(NFC_TASK_CORE));
+}
+
+bool nfcNextEvent(TagEvent& event) {
+  if (!tagEvents.pop(event)) return false;
+  recordEventStats(event);
+  return true;
+}
+
+// Adds the samples published since the last merge. The exact maximum is
+// only known when the newest samples hold the task's overall maximum;
+// otherwise it is bounded by their highest bucket.
+void nfcMergeStats() {
+  static Histogram snapshot;
+  publishedLateness.read(snapshot);
+  if (snapshot.count() == mergedLateness.count()) return;
+  Histogram& merged = stats.pollLatenessMicros;
+  uint32_t maximum = merged.maxValue();
+  for (uint16_t i = 0; i < Histogram::BUCKET_COUNT; i++) {
+    uint32_t added = snapshot.bucket(i) - mergedLateness.bucket(i);
+    if (!added) continue;
+    merged.addToBucket(i, added);
+    uint32_t bound = min(Histogram::bucketUpperBound(i), snapshot.maxValue());
+    if (bound > maximum) maximum = bound;
+  }
+  merged.setMaxValue(maximum);
+  mergedLateness = snapshot;
+}
+
+// Console reads and writes drive the PN532 from loop(); the task parks
+// first so the two cores never talk to the reader at the same time.
+void nfcAcquire() {
+  nfcCommands.push(NFC_PAUSE);
+  while (!nfcPaused.load(std::memory_order_acquire)) vTaskDelay(1);
+}
+
+void nfcRelease() {
+  nfcCommands.push(NFC_RESUME);
+  while (nfcPaused.load(std::memory_order_acquire)) vTaskDelay(1);
+}
+
+void nfcSkipMetadata() { nfcCommands.push(NFC_SKIP_METADATA); }
+#endif
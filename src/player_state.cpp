@@ -0,0 +1,31 @@
+#include "player_state.h"
+
+SeqLock<PlayerSnapshot> playerState;
+
+// Only loop() publishes, so comparing with its own last copy is race-free
+void publishPlayerState(const PlayerSnapshot& snapshot) {
+  static PlayerSnapshot last;
+  static bool published = false;
+  if (published && memcmp(&last, &snapshot, sizeof(snapshot)) == 0) return;
+  playerState.publish(snapshot);
+  last = snapshot;
+  published = true;
+}
+
+PlayerSnapshot readPlayerState() {
+  PlayerSnapshot snapshot;
+  playerState.read(snapshot);
+  return snapshot;
+}
+
+void printPlayerState() {
+  PlayerSnapshot s = readPlayerState();
+  Serial.println("▶️  State #" + String(playerState.version()) + (s.learning ? " (learn mode)" : ""));
+  Serial.println("  Tag present: " + String(s.tagPresent ? "yes" : "no"));
+  if (!s.playing) Serial.println("  Stopped");
+  else if (s.folder) Serial.println("  Playing folder " + String(s.folder) + " track " + String(s.track));
+  else Serial.println("  Playing track " + String(s.track));
+  Serial.println("  Volume " + String(s.volume) + ", EQ " + String(s.eq) +
+                 (s.shuffle ? ", shuffle" : "") + (s.buttonsLocked ? ", buttons locked" : "") +
+                 (s.sleepTimerArmed ? ", sleep timer set" : ""));
+}
@@ -0,0 +1,69 @@
+#include "pn532_ext.h"
+#include <Wire.h>
+
+const uint8_t PN532_I2C_ADDR = 0x24;
+const uint8_t PN532_CMD_INDATAEXCHANGE = 0x40;
+const uint8_t PN532_PN532TOHOST = 0xD5;
+const unsigned long PN532_RESPONSE_TIMEOUT = 50;
+
+// Adafruit_PN532.cpp keeps the last response frame here: 00 00 FF LEN LCS
+// D5 4B, then targets found, target number, ATQA (2), SAK, UID length, UID
+extern byte pn532_packetbuffer[];
+
+// Reading an I2C frame always starts with a status byte; bit 0 is set once
+// the PN532 has a response ready.
+static bool waitForResponse() {
+  unsigned long start = millis();
+  while (millis() - start < PN532_RESPONSE_TIMEOUT) {
+    if (Wire.requestFrom(PN532_I2C_ADDR, (uint8_t)1) == 1 && (Wire.read() & 0x01)) return true;
+    delay(1);
+  }
+  return false;
+}
+
+bool pn532DataExchange(Adafruit_PN532& nfc, const uint8_t* tagCommand, uint8_t commandLength,
+                       uint8_t* response, uint8_t responseLength) {
+  uint8_t command[16];
+  if (commandLength + 2 > (int)sizeof(command)) return false;
+  command[0] = PN532_CMD_INDATAEXCHANGE;
+  command[1] = 1;  // target number
+  memcpy(command + 2, tagCommand, commandLength);
+  if (!nfc.sendCommandCheckAck(command, commandLength + 2)) return false;
+  if (!waitForResponse()) return false;
+
+  // status, 00 00 FF, LEN, LCS, D5, 41, error, data..., DCS, 00
+  uint8_t frame[128];
+  uint8_t frameLength = responseLength + 11;
+  if (frameLength > sizeof(frame)) return false;
+  if (Wire.requestFrom(PN532_I2C_ADDR, frameLength) != frameLength) return false;
+  for (uint8_t i = 0; i < frameLength; i++) frame[i] = Wire.read();
+
+  uint8_t length = frame[4];
+  if (frame[1] != 0x00 || frame[2] != 0x00 || frame[3] != 0xFF) return false;
+  if ((uint8_t)(length + frame[5]) != 0 || length != responseLength + 3) return false;
+  if (frame[6] != PN532_PN532TOHOST || frame[7] != PN532_CMD_INDATAEXCHANGE + 1) return false;
+  if (frame[8] & 0x3F) return false;  // tag did not answer
+
+  uint8_t checksum = 0;
+  for (uint8_t i = 6; i < 6 + length + 1; i++) checksum += frame[i];
+  if (checksum != 0) return false;
+
+  memcpy(response, frame + 9, responseLength);
+  return true;
+}
+
+bool pn532ReadPages(Adafruit_PN532& nfc, uint8_t startPage, uint8_t* data) {
+  uint8_t command[2] = {NTAG_CMD_READ, startPage};
+  return pn532DataExchange(nfc, command, sizeof(command), data, NTAG_READ_SIZE);
+}
+
+bool pn532FastRead(Adafruit_PN532& nfc, uint8_t startPage, uint8_t endPage, uint8_t* data) {
+  if (endPage < startPage || endPage - startPage + 1 > NTAG_FAST_READ_MAX_PAGES) return false;
+  uint8_t command[3] = {NTAG_CMD_FAST_READ, startPage, endPage};
+  return pn532DataExchange(nfc, command, sizeof(command), data, (endPage - startPage + 1) * 4);
+}
+
+void pn532LastTarget(uint16_t& atqa, uint8_t& sak) {
+  atqa = pn532_packetbuffer[9] << 8 | pn532_packetbuffer[10];
+  sak = pn532_packetbuffer[11];
+}
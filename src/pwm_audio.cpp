@@ -0,0 +1,279 @@
+#if defined(ENABLE_ESP32_AUDIO) && defined(ENABLE_PWM_AUDIO)
+#include "pwm_audio.h"
+#include <DFRobotDFPlayerMini.h>
+#include <SD.h>
+#include <SPI.h>
+#include <AudioCodec.h>
+#include <FatVolume.h>
+#include <PwmRender.h>
+#include <SpscQueue.h>
+#include <TrackGain.h>
+#include "board_config.h"
+#include "resume_position.h"
+#include "seek_cache.h"
+#include "track_index.h"
+#include "visualizer.h"
+
+const uint8_t PWM_AUDIO_TIMER = 0;
+const uint32_t PWM_AUDIO_TIMER_HZ = 40000000;  // 80 MHz APB / 2
+const uint32_t PWM_AUDIO_DEFAULT_RATE = 22050;
+const uint8_t PWM_AUDIO_SDM_CHANNEL = 0;
+const uint32_t PWM_AUDIO_SDM_FREQUENCY = 10000000;
+const uint8_t PWM_AUDIO_LEDC_CHANNEL = 1;          // 0 is the visualiser's
+const uint32_t PWM_AUDIO_LEDC_FREQUENCY = 312500;  // 80 MHz / 256, 8 bits
+const uint8_t DUTY_SILENCE = 128;
+const int PWM_MAX_VOLUME = 30;
+const float DB_PER_VOLUME_STEP = 2.0f;  // as DFPLAYER_GAIN_PER_STEP assumes
+
+class FatSource : public AudioSource {
+ public:
+  size_t read(uint8_t* data, size_t length) override { return file.read(data, length); }
+  bool seek(uint32_t offset) override { return file.seek(offset); }
+  FatFile file;
+};
+
+static SpscQueue<uint8_t, PWM_AUDIO_RING_SIZE> ring;  // service → timer interrupt
+static PwmRenderer renderer;
+static FatSource source;
+static FatSource indexSource;  // the same file, for seekCacheService()
+static hw_timer_t* sampleTimer = nullptr;
+
+static struct {
+  AudioDecoder* decoder = nullptr;  // null when idle
+  bool decoding = false;            // false once the last block is rendered
+  bool seekable = false;            // an MP3, indexed by seek_cache
+  uint8_t folder = 0;
+  uint8_t track = 0;
+  uint32_t startMs = 0;             // where decoding began or last jumped to
+  uint64_t framesDecoded = 0;       // since startMs
+  uint32_t sampleRate = PWM_AUDIO_DEFAULT_RATE;
+  int volume = 0;
+  int8_t gain = 0;
+  int16_t pcm[AUDIO_BLOCK_MAX_FRAMES * AUDIO_MAX_CHANNELS];
+  uint8_t duty[AUDIO_BLOCK_MAX_FRAMES];
+  uint16_t rendered = 0;  // duty values in the block
+  uint16_t queued = 0;    // of those, already in the ring
+  bool eventPending = false;
+  uint8_t eventType = 0;
+  uint16_t eventValue = 0;
+} player;
+
+// Interrupt side. Load is published once a second of samples, as whole
+// 32-bit words, so the console never reads a half-updated counter.
+static volatile bool streaming = false;  // an empty ring is an underrun
+static volatile uint32_t underruns = 0;
+static volatile uint32_t windowCycles = 0;
+static volatile uint32_t windowCalls = 0;
+static volatile uint32_t loadCycles = 0;  // cycles spent in the last second of samples
+static volatile uint32_t worstCycles = 0;
+
+static inline void IRAM_ATTR writeDuty(uint8_t duty) {
+#ifdef PWM_AUDIO_LEDC
+  ledcWrite(PWM_AUDIO_LEDC_CHANNEL, duty);
+#else
+  sigmaDeltaWrite(PWM_AUDIO_SDM_CHANNEL, duty);
+#endif
+}
+
+static void IRAM_ATTR onSampleTimer() {
+  uint32_t start = ESP.getCycleCount();
+  uint8_t duty;
+  if (!ring.pop(duty)) {
+    duty = DUTY_SILENCE;
+    if (streaming) underruns++;
+  }
+  writeDuty(duty);
+  uint32_t cycles = ESP.getCycleCount() - start;
+  windowCycles += cycles;
+  if (cycles > worstCycles) worstCycles = cycles;
+  if (++windowCalls >= player.sampleRate) {
+    loadCycles = windowCycles;
+    windowCycles = 0;
+    windowCalls = 0;
+  }
+}
+
+bool pwmAudioBegin() {
+  Serial.println("Initializing SD card and PWM audio...");
+  SPI.begin(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_CS_PIN);
+  if (!SD.begin(SD_CS_PIN)) {
+    Serial.println("❌ ERROR: SD card not found!");
+    return false;
+  }
+  if (!trackIndexBegin(SD)) return false;
+  resumePositionBegin();
+#ifdef PWM_AUDIO_LEDC
+  ledcSetup(PWM_AUDIO_LEDC_CHANNEL, PWM_AUDIO_LEDC_FREQUENCY, 8);
+  ledcAttachPin(PWM_AUDIO_PIN, PWM_AUDIO_LEDC_CHANNEL);
+#else
+  sigmaDeltaSetup(PWM_AUDIO_PIN, PWM_AUDIO_SDM_CHANNEL, PWM_AUDIO_SDM_FREQUENCY);
+#endif
+  writeDuty(DUTY_SILENCE);
+  sampleTimer = timerBegin(PWM_AUDIO_TIMER, APB_CLK_FREQ / PWM_AUDIO_TIMER_HZ, true);
+  timerAttachInterrupt(sampleTimer, onSampleTimer, true);
+  timerAlarmWrite(sampleTimer, PWM_AUDIO_TIMER_HZ / player.sampleRate, true);
+  Serial.println("✅ PWM audio on GPIO " + String(PWM_AUDIO_PIN));
+  return true;
+}
+
+// Volume and track gain become one factor, once per change
+static void applyGain() {
+  if (player.volume <= 0) {
+    renderer.setGain(0);
+    return;
+  }
+  uint64_t volumeScale = lroundf(65536.0f * powf(10.0f, (player.volume - PWM_MAX_VOLUME) * DB_PER_VOLUME_STEP / 20));
+  renderer.setGain(volumeScale * trackGainScale(player.gain) >> 16);
+}
+
+static void raiseEvent(uint8_t type, uint16_t value) {
+  player.eventType = type;
+  player.eventValue = value;
+  player.eventPending = true;
+}
+
+// Decoded, not played: the ring's few hundred milliseconds are counted too
+static uint32_t decodedMs() { return player.startMs + player.framesDecoded * 1000 / player.sampleRate; }
+
+// An MP3 stopped part-way is remembered for next time; one that has been
+// decoded to the end is forgotten.
+void pwmPlayerStop() {
+  if (player.decoder && player.seekable) {
+    resumePositionSave(player.folder, player.track, player.decoding ? decodedMs() : 0);
+  }
+  if (sampleTimer) timerAlarmDisable(sampleTimer);
+  streaming = false;
+  uint8_t duty;
+  while (ring.pop(duty)) {}  // the interrupt is off, so this side may pop
+  writeDuty(DUTY_SILENCE);
+  player.decoder = nullptr;
+  player.decoding = false;
+  player.rendered = 0;
+  player.queued = 0;
+}
+
+// Moves the decoder to the frame that holds positionMs, once the track's
+// seek index reaches that far
+static bool seekDecoder(uint32_t positionMs) {
+  Mp3SeekPoint point;
+  if (!player.seekable) {
+    Serial.println("⏩ Only MP3 tracks can seek");
+    return false;
+  }
+  if (!seekCacheFind(positionMs, point) || !player.decoder->seekTo(point.offset)) {
+    Serial.println("⏩ Cannot seek to " + String(positionMs / 1000) + " s yet, the track is still being indexed");
+    return false;
+  }
+  Serial.println("⏩ Playing from " + String(point.timeMs) + " ms");
+  player.startMs = point.timeMs;
+  player.framesDecoded = 0;
+  return true;
+}
+
+bool pwmPlayerPlay(uint8_t folder, uint8_t track, int volume, int8_t gain, uint32_t positionMs) {
+  pwmPlayerStop();
+  player.eventPending = false;
+  AudioCodecType codec = AUDIO_CODEC_UNKNOWN;
+  if (!sampleTimer || !trackIndexOpen(folder, track, source.file) ||
+      !(player.decoder = openAudioDecoder(source, &codec))) {
+    raiseEvent(DFPlayerError, FileMismatch);
+    return false;
+  }
+  player.seekable = codec == AUDIO_CODEC_MP3;
+  player.folder = folder;
+  player.track = track;
+  player.startMs = 0;
+  player.framesDecoded = 0;
+  if (player.seekable) {
+    indexSource.file = source.file;
+    seekCacheOpen(folder, track, source.file.size(), source.file.startCluster(), indexSource);
+    if (positionMs > 0) seekDecoder(positionMs);
+  }
+  if (player.decoder->sampleRate() != player.sampleRate) {
+    player.sampleRate = player.decoder->sampleRate();
+    timerAlarmWrite(sampleTimer, PWM_AUDIO_TIMER_HZ / player.sampleRate, true);
+  }
+  player.volume = volume;
+  player.gain = gain;
+  applyGain();
+  renderer.reset();
+  player.decoding = true;
+  pwmPlayerService();  // fill the ring before the first sample is due
+  streaming = true;
+  timerAlarmEnable(sampleTimer);
+  return true;
+}
+
+// The ring is emptied first, so the new position is heard right away
+void pwmPlayerSeek(uint32_t positionMs) {
+  if (!player.decoder || !player.decoding) {
+    Serial.println("Error: nothing playing");
+    return;
+  }
+  if (!seekDecoder(positionMs)) return;
+  timerAlarmDisable(sampleTimer);
+  uint8_t duty;
+  while (ring.pop(duty)) {}
+  player.rendered = 0;
+  player.queued = 0;
+  renderer.reset();
+  pwmPlayerService();
+  if (player.decoder) timerAlarmEnable(sampleTimer);  // not if the seek went past the end
+}
+
+void pwmPlayerSetVolume(int volume) {
+  player.volume = volume;
+  applyGain();
+}
+
+// Decodes until the ring is full. The track has finished once the last
+// block is rendered and the interrupt has played the ring empty.
+// The current track's seek index is built alongside, a chunk a tick, and
+// carries on after playback stops.
+void pwmPlayerService() {
+  trackIndexService();
+  seekCacheService();
+  if (!player.decoder) return;
+  while (true) {
+    while (player.queued < player.rendered) {
+      if (!ring.push(player.duty[player.queued])) return;
+      player.queued++;
+    }
+    if (!player.decoding) break;
+    size_t frames = player.decoder->decode(player.pcm);
+    if (frames == 0) {
+      player.decoding = false;
+      streaming = false;
+      break;
+    }
+    player.framesDecoded += frames;
+    visualizerAudio(player.pcm, frames, player.decoder->channels(), player.sampleRate);
+    renderer.render(player.pcm, frames, player.decoder->channels(), player.duty);
+    player.rendered = frames;
+    player.queued = 0;
+  }
+  if (ring.empty()) {
+    pwmPlayerStop();
+    raiseEvent(DFPlayerPlayFinished, 0);
+  }
+}
+
+bool pwmPlayerNextEvent(uint8_t& type, uint16_t& value) {
+  if (!player.eventPending) return false;
+  player.eventPending = false;
+  type = player.eventType;
+  value = player.eventValue;
+  return true;
+}
+
+// Cycles inside the interrupt handler; its entry and exit are not included
+void printPwmAudio() {
+  uint64_t cpuHz = (uint64_t)ESP.getCpuFreqMHz() * 1000000;
+  uint32_t load = loadCycles;
+  char line[128];
+  snprintf(line, sizeof(line), "PWM rate=%lu ring=%u underruns=%lu isr_cycles_avg=%lu isr_cycles_max=%lu cpu_pct=%.2f",
+           (unsigned long)player.sampleRate, PWM_AUDIO_RING_SIZE, (unsigned long)underruns,
+           (unsigned long)(load / player.sampleRate), (unsigned long)worstCycles, 100.0 * load / cpuHz);
+  Serial.println(line);
+}
+#endif
@@ -0,0 +1,57 @@
+#ifdef ENABLE_ESP32_AUDIO
+#include "resume_position.h"
+#include <Preferences.h>
+#include "timers.h"
+
+const unsigned long RESUME_SAVE_DELAY = 2000;
+
+struct ResumePosition {
+  uint8_t folder;
+  uint8_t track;
+  uint32_t positionMs;
+};
+
+static ResumePosition positions[RESUME_POSITION_COUNT];  // most recently stopped first
+static uint8_t positionCount = 0;
+static WheelTimer saveTimer;  // armed while there are unsaved changes
+static Preferences prefs;
+
+static void save(void*) {
+  prefs.putBytes("positions", positions, positionCount * sizeof(ResumePosition));
+}
+
+void resumePositionBegin() {
+  prefs.begin("resume", false);
+  size_t bytes = prefs.getBytes("positions", positions, sizeof(positions));
+  positionCount = bytes / sizeof(ResumePosition);
+  saveTimer.callback = save;
+}
+
+static uint8_t findPosition(uint8_t folder, uint8_t track) {
+  uint8_t i = 0;
+  while (i < positionCount && (positions[i].folder != folder || positions[i].track != track)) i++;
+  return i;
+}
+
+uint32_t resumePositionFor(uint8_t folder, uint8_t track) {
+  uint8_t i = findPosition(folder, track);
+  return i < positionCount ? positions[i].positionMs : 0;
+}
+
+void resumePositionSave(uint8_t folder, uint8_t track, uint32_t positionMs) {
+  uint8_t i = findPosition(folder, track);
+  if (positionMs == 0) {
+    if (i == positionCount) return;
+    memmove(&positions[i], &positions[i + 1], (positionCount - 1 - i) * sizeof(ResumePosition));
+    positionCount--;
+  } else {
+    if (i == positionCount) {
+      if (positionCount < RESUME_POSITION_COUNT) positionCount++;
+      i = positionCount - 1;
+    }
+    memmove(&positions[1], &positions[0], i * sizeof(ResumePosition));
+    positions[0] = {folder, track, positionMs};
+  }
+  armTimer(saveTimer, RESUME_SAVE_DELAY);
+}
+#endif
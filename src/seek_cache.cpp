@@ -0,0 +1,81 @@
+#ifdef ENABLE_ESP32_AUDIO
+#include "seek_cache.h"
+#include <LittleFS.h>
+
+static Mp3SeekIndex seekIndex;
+static struct {
+  bool valid = false;  // seekIndex is for this track, complete or being built
+  uint8_t folder;
+  uint8_t track;
+  uint32_t size;
+  uint32_t stamp;
+  AudioSource* building = nullptr;  // the file being scanned, null when done
+  unsigned long buildMs;            // spent in seekCacheService() so far
+} cached;
+// File reads while indexing, and the encoded index on its way to or from
+// flash; the largest index fits exactly.
+static uint8_t buffer[MP3_SEEK_HEADER_SIZE + MP3_SEEK_MAX_POINTS * sizeof(Mp3SeekPoint)];
+
+static String indexPath(uint8_t folder, uint8_t track) {
+  char name[24];
+  snprintf(name, sizeof(name), "/seek-%02u-%03u.idx", folder, track);
+  return name;
+}
+
+static bool loadIndex() {
+  File f = LittleFS.open(indexPath(cached.folder, cached.track).c_str(), "r");
+  if (!f) return false;
+  size_t length = f.read(buffer, sizeof(buffer));
+  f.close();
+  return seekIndex.decode(buffer, length, cached.size, cached.stamp);
+}
+
+static void saveIndex() {
+  Serial.println("⏩ Indexed " + String(cached.folder) + "/" + String(cached.track) + ": " +
+                 String(seekIndex.frameCount()) + " frames, " + String(seekIndex.durationMs() / 1000) +
+                 " s, a point every " + String(seekIndex.intervalMs() / 1000) + " s (" + String(cached.buildMs) +
+                 " ms of reading)");
+  File f = LittleFS.open(indexPath(cached.folder, cached.track).c_str(), "w");
+  if (!f) return;
+  f.write(buffer, seekIndex.encode(buffer, sizeof(buffer)));
+  f.close();
+}
+
+void seekCacheOpen(uint8_t folder, uint8_t track, uint32_t size, uint32_t stamp, AudioSource& file) {
+  if (cached.valid && cached.folder == folder && cached.track == track && cached.size == size &&
+      cached.stamp == stamp) {
+    if (cached.building) cached.building = &file;  // carry on where the scan stopped
+    return;
+  }
+  cached = {};
+  cached.valid = true;
+  cached.folder = folder;
+  cached.track = track;
+  cached.size = size;
+  cached.stamp = stamp;
+  LittleFS.begin(true);
+  if (loadIndex()) return;
+  seekIndex.reset(size, stamp);
+  cached.building = &file;
+}
+
+// A partly built index is dropped when another track starts, and begun
+// again the next time its own track plays.
+void seekCacheService() {
+  if (!cached.building) return;
+  unsigned long start = millis();
+  bool more = cached.building->seek(seekIndex.bytesFed());
+  size_t n = more ? cached.building->read(buffer, SEEK_CACHE_CHUNK) : 0;
+  if (n > 0) seekIndex.feed(buffer, n);
+  cached.buildMs += millis() - start;
+  if (n == SEEK_CACHE_CHUNK) return;
+  cached.building = nullptr;
+  if (seekIndex.bytesFed() == cached.size) saveIndex();
+  else cached.valid = false;  // read error: an index that stops short would send resumes on a long walk
+}
+
+bool seekCacheFind(uint32_t positionMs, Mp3SeekPoint& point) {
+  if (!cached.valid || (cached.building && seekIndex.durationMs() <= positionMs)) return false;
+  return seekIndex.find(positionMs, point);
+}
+#endif
@@ -0,0 +1,95 @@
+#include "stats.h"
+#include "version.h"
+
+Stats stats;
+
+void statsRecordDetection() { stats.tagDetections++; }
+
+void statsRecordReadFailure() { stats.readFailures++; }
+
+void statsRecordGraceStop() { stats.graceStops++; }
+
+void statsRecordTagToPlay(unsigned long elapsedMicros) {
+  stats.tagToPlayMicros.record(elapsedMicros);
+}
+
+void statsRecordPollLateness(unsigned long lateMicros) {
+  stats.pollLatenessMicros.record(lateMicros);
+}
+
+// Per-tag counts live in a small fixed table; once it is full the least
+// played entry makes room, so the busiest tags are always tracked.
+void statsRecordPlay(const uint8_t* uid, uint8_t uidLength, int track) {
+  stats.plays++;
+
+  TagPlayCount* slot = nullptr;
+  for (uint8_t i = 0; i < stats.tagCount; i++) {
+    TagPlayCount& entry = stats.tags[i];
+    if (entry.uidLength == uidLength && memcmp(entry.uid, uid, uidLength) == 0) {
+      slot = &entry;
+      break;
+    }
+  }
+  if (!slot) {
+    if (stats.tagCount < STATS_MAX_TAGS) {
+      slot = &stats.tags[stats.tagCount++];
+    } else {
+      slot = &stats.tags[0];
+      for (uint8_t i = 1; i < STATS_MAX_TAGS; i++) {
+        if (stats.tags[i].plays < slot->plays) slot = &stats.tags[i];
+      }
+    }
+    memcpy(slot->uid, uid, uidLength);
+    slot->uidLength = uidLength;
+    slot->plays = 0;
+  }
+  slot->track = track;
+  slot->plays++;
+}
+
+static void printHistogram(const char* label, const Histogram& h) {
+  Serial.println(String(label) + "n=" + String(h.count()) +
+                 " p50=" + String(h.percentile(50)) +
+                 " p90=" + String(h.percentile(90)) +
+                 " p99=" + String(h.percentile(99)) +
+                 " max=" + String(h.maxValue()));
+}
+
+void printStats() {
+  Serial.println("📊 Uptime: " + String(millis() / 1000) + " s");
+  Serial.println("  Tag detections: " + String(stats.tagDetections));
+  Serial.println("  Plays:          " + String(stats.plays));
+  Serial.println("  Read failures:  " + String(stats.readFailures));
+  Serial.println("  Grace stops:    " + String(stats.graceStops));
+  printHistogram("  Tag-to-play µs: ", stats.tagToPlayMicros);
+  printHistogram("  Poll late µs:   ", stats.pollLatenessMicros);
+}
+
+size_t encodeStats(const Stats& snapshot, uint8_t* out, size_t capacity) {
+  static uint32_t bootId = esp_random();
+  StatsDump dump;
+  strncpy(dump.firmware, FIRMWARE_VERSION, STATS_DUMP_MAX_STRING);
+  // Base MAC in transmission order, the same id telemetry topics use
+  uint64_t mac = ESP.getEfuseMac();
+  for (uint8_t i = 0; i < 6; i++) snprintf(dump.deviceId + 2 * i, 3, "%02x", (uint8_t)(mac >> (8 * i)));
+  dump.bootId = bootId;
+  dump.uptimeSeconds = millis() / 1000;
+  dump.detections = snapshot.tagDetections;
+  dump.plays = snapshot.plays;
+  dump.readFailures = snapshot.readFailures;
+  dump.graceStops = snapshot.graceStops;
+  dump.tagToPlayMicros = snapshot.tagToPlayMicros;
+  return encodeStatsDump(dump, out, capacity);
+}
+
+// One hex line, so dumps can be collected from plain serial logs
+void printStatsDump() {
+  static uint8_t dump[STATS_DUMP_MAX_SIZE];
+  size_t length = encodeStats(stats, dump, sizeof(dump));
+  Serial.print("STATSDUMP ");
+  for (size_t i = 0; i < length; i++) {
+    if (dump[i] < 0x10) Serial.print("0");
+    Serial.print(dump[i], HEX);
+  }
+  Serial.println();
+}
@@ -0,0 +1,166 @@
+#include "tag_library.h"
+#include <Preferences.h>
+#include "timers.h"
+
+// Flash writes are deferred until the table has been quiet for a moment,
+// so a burst of web assignments costs one NVS commit instead of many.
+const unsigned long TAG_LIBRARY_SAVE_DELAY = 2000;
+
+// UID → entry index, open addressing with linear probing at most half
+// full, so a lookup is a hash and usually a single probe. Entries only move
+// when the table is full and one is recycled; the index is rebuilt then.
+const uint8_t TAG_INDEX_SIZE = 64;  // power of two, at least 2 × TAG_LIBRARY_SIZE
+const uint8_t INDEX_EMPTY = 0xFF;
+
+static TagEntry entries[TAG_LIBRARY_SIZE];
+static uint8_t entryCount = 0;
+static uint8_t uidIndex[TAG_INDEX_SIZE];
+// The NFC task looks up bindings from the other core on dual-core boards
+static portMUX_TYPE libraryLock = portMUX_INITIALIZER_UNLOCKED;
+static WheelTimer saveTimer;  // armed while there are unsaved changes
+static Preferences prefs;
+
+static void save(void*) {
+  prefs.putBytes("entries", entries, entryCount * sizeof(TagEntry));
+}
+
+static void markDirty() { armTimer(saveTimer, TAG_LIBRARY_SAVE_DELAY); }
+
+// FNV-1a
+static uint8_t uidHash(const uint8_t* uid, uint8_t uidLength) {
+  uint32_t hash = 2166136261u;
+  for (uint8_t i = 0; i < uidLength; i++) hash = (hash ^ uid[i]) * 16777619u;
+  return (hash ^ (hash >> 16)) & (TAG_INDEX_SIZE - 1);
+}
+
+static void indexEntry(uint8_t entry) {
+  uint8_t slot = uidHash(entries[entry].uid, entries[entry].uidLength);
+  while (uidIndex[slot] != INDEX_EMPTY) slot = (slot + 1) & (TAG_INDEX_SIZE - 1);
+  uidIndex[slot] = entry;
+}
+
+static void rebuildIndex() {
+  memset(uidIndex, INDEX_EMPTY, sizeof(uidIndex));
+  for (uint8_t i = 0; i < entryCount; i++) indexEntry(i);
+}
+
+void tagLibraryBegin() {
+  prefs.begin("taglib", false);
+  size_t bytes = prefs.getBytes("entries", entries, sizeof(entries));
+  entryCount = bytes / sizeof(TagEntry);
+  rebuildIndex();
+  saveTimer.callback = save;
+  Serial.println("✅ Tag library: " + String(entryCount) + " known tags");
+}
+
+const TagEntry* tagLibraryFind(const uint8_t* uid, uint8_t uidLength) {
+  uint8_t slot = uidHash(uid, uidLength);
+  for (uint8_t probes = 0; probes < TAG_INDEX_SIZE; probes++) {
+    uint8_t i = uidIndex[slot];
+    if (i == INDEX_EMPTY) return nullptr;
+    if (entries[i].uidLength == uidLength && memcmp(entries[i].uid, uid, uidLength) == 0) {
+      return &entries[i];
+    }
+    slot = (slot + 1) & (TAG_INDEX_SIZE - 1);
+  }
+  return nullptr;
+}
+
+bool tagLibraryLookup(const uint8_t* uid, uint8_t uidLength, TagEntry& binding) {
+  portENTER_CRITICAL(&libraryLock);
+  const TagEntry* entry = tagLibraryFind(uid, uidLength);
+  bool bound = entry && (entry->track || entry->folder);
+  if (bound) binding = *entry;
+  portEXIT_CRITICAL(&libraryLock);
+  return bound;
+}
+
+// Returns a slot for a new UID. When the table is full, the oldest entry
+// without an assignment is recycled; assigned tags are never dropped.
+static TagEntry* allocateEntry(const uint8_t* uid, uint8_t uidLength) {
+  bool recycled = entryCount == TAG_LIBRARY_SIZE;
+  if (recycled) {
+    uint8_t i = 0;
+    while (i < TAG_LIBRARY_SIZE && (entries[i].track || entries[i].folder)) i++;
+    if (i == TAG_LIBRARY_SIZE) return nullptr;
+    memmove(&entries[i], &entries[i + 1], (TAG_LIBRARY_SIZE - 1 - i) * sizeof(TagEntry));
+    entryCount--;
+  }
+  TagEntry* entry = &entries[entryCount++];
+  memset(entry, 0, sizeof(TagEntry));
+  memcpy(entry->uid, uid, uidLength);
+  entry->uidLength = uidLength;
+  if (recycled) rebuildIndex();
+  else indexEntry(entryCount - 1);
+  return entry;
+}
+
+void tagLibraryNoteSeen(const uint8_t* uid, uint8_t uidLength, int tagTrack) {
+  uint8_t track = tagTrack > 0 ? tagTrack : 0;
+  portENTER_CRITICAL(&libraryLock);
+  TagEntry* entry = (TagEntry*)tagLibraryFind(uid, uidLength);
+  if (!entry) entry = allocateEntry(uid, uidLength);
+  bool changed = entry && entry->tagTrack != track;
+  if (changed) entry->tagTrack = track;
+  portEXIT_CRITICAL(&libraryLock);
+  if (changed) markDirty();
+}
+
+bool tagLibraryAssign(const uint8_t* uid, uint8_t uidLength, uint8_t track, uint8_t folder) {
+  portENTER_CRITICAL(&libraryLock);
+  TagEntry* entry = (TagEntry*)tagLibraryFind(uid, uidLength);
+  if (!entry) entry = allocateEntry(uid, uidLength);
+  if (entry) {
+    entry->track = folder ? 0 : track;
+    entry->folder = folder;
+  }
+  portEXIT_CRITICAL(&libraryLock);
+  if (!entry) return false;
+  markDirty();
+  return true;
+}
+
+uint8_t tagLibraryCount() { return entryCount; }
+
+const TagEntry& tagLibraryEntry(uint8_t index) { return entries[index]; }
+
+void printTagLibrary() {
+  Serial.println("Known tags: " + String(entryCount));
+  for (uint8_t i = 0; i < entryCount; i++) {
+    const TagEntry& e = entries[i];
+    String uid = "";
+    for (uint8_t j = 0; j < e.uidLength; j++) {
+      if (e.uid[j] < 0x10) uid += "0";
+      uid += String(e.uid[j], HEX);
+    }
+    uid.toUpperCase();
+    String line = "  " + uid + "  tag #" + String(e.tagTrack);
+    if (e.folder) line += "  → playlist folder " + String(e.folder);
+    else if (e.track) line += "  → track " + String(e.track);
+    Serial.println(line);
+  }
+}
+
+// Accepts "04A1B2C3D4E5F6" or "04:A1:B2:C3", 4 or 7 bytes.
+bool parseUid(const char* text, uint8_t* uid, uint8_t* uidLength) {
+  uint8_t length = 0;
+  int high = -1;
+  for (const char* p = text; *p; p++) {
+    if (*p == ':') continue;
+    int nibble;
+    if (*p >= '0' && *p <= '9') nibble = *p - '0';
+    else if (*p >= 'a' && *p <= 'f') nibble = *p - 'a' + 10;
+    else if (*p >= 'A' && *p <= 'F') nibble = *p - 'A' + 10;
+    else return false;
+    if (high < 0) {
+      high = nibble;
+    } else {
+      if (length >= 7) return false;
+      uid[length++] = (high << 4) | nibble;
+      high = -1;
+    }
+  }
+  if (high >= 0 || (length != 4 && length != 7)) return false;
+  *uidLength = length;
+  return true;
+}
@@ -0,0 +1,76 @@
+#include "tag_writer.h"
+#include "nfc_reader.h"
+#include "pn532_ext.h"
+
+// Running average of one NTAG page write, seeded with the datasheet figure
+static unsigned long pageWriteMicros = 4100;
+
+bool readTagPages(uint8_t firstPage, uint8_t pageCount, uint8_t* data) {
+  for (uint8_t done = 0; done < pageCount;) {
+    uint8_t n = min((uint8_t)(pageCount - done), NTAG_FAST_READ_MAX_PAGES);
+    if (!pn532FastRead(nfc, firstPage + done, firstPage + done + n - 1, data + done * TAG_PAGE_SIZE)) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+// If the tag cannot be read first (no FAST_READ support, RF hiccup), every
+// page is written as before.
+TagWriteResult writeTagPages(uint8_t firstPage, const uint8_t* data, uint8_t pageCount,
+                             const uint8_t* current, bool verify) {
+  TagWriteResult result;
+  result.pageCount = pageCount;
+  if (pageCount == 0 || pageCount > TAG_WRITE_MAX_PAGES) return result;
+  unsigned long start = micros();
+
+  uint8_t readBack[TAG_WRITE_MAX_PAGES * TAG_PAGE_SIZE];
+  bool known = current != nullptr;
+  if (!known && readTagPages(firstPage, pageCount, readBack)) {
+    current = readBack;
+    known = true;
+  }
+  for (uint8_t page = 0; page < pageCount; page++) {
+    const uint8_t* wanted = data + page * TAG_PAGE_SIZE;
+    if (known && memcmp(current + page * TAG_PAGE_SIZE, wanted, TAG_PAGE_SIZE) == 0) continue;
+    uint8_t buffer[TAG_PAGE_SIZE];
+    memcpy(buffer, wanted, TAG_PAGE_SIZE);
+    unsigned long writeStart = micros();
+    if (!nfc.ntag2xx_WritePage(firstPage + page, buffer)) {
+      result.elapsedMicros = micros() - start;
+      return result;
+    }
+    pageWriteMicros = (7 * pageWriteMicros + (micros() - writeStart)) / 8;
+    result.pagesWritten++;
+  }
+
+  result.ok = true;
+  if (verify) {
+    result.verified = readTagPages(firstPage, pageCount, readBack) &&
+                      memcmp(readBack, data, pageCount * TAG_PAGE_SIZE) == 0;
+    result.ok = result.verified;
+  }
+  result.elapsedMicros = micros() - start;
+  result.savedMicros = (pageCount - result.pagesWritten) * pageWriteMicros;
+  return result;
+}
+
+// Choosing the spare slot needs the current slots, so a tag that cannot be
+// read is not written at all.
+TagWriteResult writeRecordSlot(const TagRecord& record, bool verify) {
+  TagWriteResult result;
+  result.pageCount = TAG_RECORD_PAGES;
+  unsigned long start = micros();
+  uint8_t current[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+  if (!readTagPages(TAG_RECORD_PAGE, TAG_RECORD_PAGES, current)) {
+    result.elapsedMicros = micros() - start;
+    return result;
+  }
+  uint8_t pages[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+  memcpy(pages, current, sizeof(pages));
+  encodeTagRecord(record, pages);
+  result = writeTagPages(TAG_RECORD_PAGE, pages, TAG_RECORD_PAGES, current, verify);
+  result.elapsedMicros = micros() - start;
+  return result;
+}
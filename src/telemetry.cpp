@@ -0,0 +1,189 @@
+#include "telemetry.h"
+
+#ifdef ENABLE_TELEMETRY
+#include <stdarg.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "player_state.h"
+#include "stats.h"
+#include "timers.h"
+#include "version.h"
+#include "wifi_link.h"
+
+// loop() hands a copy of the counters to a dedicated task through a
+// one-slot queue. xQueueOverwrite never blocks, so a stalled broker or a
+// dead access point can only delay the task, never tag detection or audio.
+// Memory is bounded by that single slot plus one payload buffer.
+const unsigned long TELEMETRY_INTERVAL = 60000;
+const unsigned long MQTT_RECONNECT_INTERVAL = 10000;
+const uint16_t TELEMETRY_PAYLOAD_SIZE = 1024;
+const uint16_t TELEMETRY_BUCKETS_END = TELEMETRY_PAYLOAD_SIZE / 2;  // the raw buckets end before here
+const uint16_t TELEMETRY_STATE_RESERVE = 96;  // closes the tag list, "truncated" and the player state
+// encodeStats builds a StatsDump of about 1 KB on this stack, next to
+// PubSubClient's and lwIP's own frames
+const uint32_t TELEMETRY_TASK_STACK = 6144;
+const UBaseType_t TELEMETRY_STACK_MARGIN = 512;  // bytes left unused before we warn
+
+static QueueHandle_t snapshotQueue = nullptr;
+static WheelTimer snapshotTimer;
+
+static WiFiClient wifiClient;
+static PubSubClient mqtt(wifiClient);
+static char payload[TELEMETRY_PAYLOAD_SIZE];
+static uint8_t dump[STATS_DUMP_MAX_SIZE];
+static String statsTopic;
+static String dumpTopic;
+
+// snprintf-style appender. A piece that would not end before `end` is
+// left out entirely, so the buffer always holds whole pieces.
+struct PayloadWriter {
+  char* buf;
+  size_t size;
+  size_t len = 0;
+
+  bool appendBefore(size_t end, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool fits = vappend(end, fmt, args);
+    va_end(args);
+    return fits;
+  }
+
+  void append(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vappend(size, fmt, args);
+    va_end(args);
+  }
+
+  void rewind(size_t mark) {
+    len = mark;
+    buf[len] = '\0';
+  }
+
+ private:
+  bool vappend(size_t end, const char* fmt, va_list args) {
+    if (len >= end) return false;
+    int n = vsnprintf(buf + len, end - len, fmt, args);
+    if (n < 0 || (size_t)n >= end - len) {
+      buf[len] = '\0';
+      return false;
+    }
+    len += n;
+    return true;
+  }
+};
+
+// Compact JSON: cumulative counters since boot (so a lost message loses
+// nothing), tag-to-play percentiles plus the raw non-empty histogram
+// buckets for fleet-side merging, per-tag play counts and the player state.
+// It always fits: the buckets go out whole or not at all (the fleet can
+// only merge a complete list; the binary dump always has them), and tags
+// that do not fit are counted in "truncated".
+static size_t formatPayload(const Stats& s) {
+  const Histogram& h = s.tagToPlayMicros;
+  PayloadWriter w{payload, sizeof(payload)};
+  w.append("{\"fw\":\"%s\",\"up\":%lu,\"det\":%lu,\"plays\":%lu,\"rf\":%lu,\"gs\":%lu",
+           FIRMWARE_VERSION, millis() / 1000, (unsigned long)s.tagDetections,
+           (unsigned long)s.plays, (unsigned long)s.readFailures,
+           (unsigned long)s.graceStops);
+  w.append(",\"lat\":{\"n\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu",
+           (unsigned long)h.count(), (unsigned long)h.percentile(50),
+           (unsigned long)h.percentile(90), (unsigned long)h.percentile(99),
+           (unsigned long)h.maxValue());
+  size_t mark = w.len;
+  bool fits = w.appendBefore(TELEMETRY_BUCKETS_END, ",\"b\":[");
+  bool first = true;
+  for (uint16_t i = 0; fits && i < Histogram::BUCKET_COUNT; i++) {
+    if (h.bucket(i) == 0) continue;
+    fits = w.appendBefore(TELEMETRY_BUCKETS_END, "%s[%u,%lu]", first ? "" : ",", i, (unsigned long)h.bucket(i));
+    first = false;
+  }
+  if (!fits || !w.appendBefore(TELEMETRY_BUCKETS_END, "]")) w.rewind(mark);
+  w.append("},\"tags\":[");
+  const size_t tagsEnd = sizeof(payload) - TELEMETRY_STATE_RESERVE;
+  uint8_t sent = 0;
+  for (; sent < s.tagCount; sent++) {
+    const TagPlayCount& t = s.tags[sent];
+    mark = w.len;
+    fits = w.appendBefore(tagsEnd, "%s[\"", sent ? "," : "");
+    for (uint8_t j = 0; fits && j < t.uidLength; j++) fits = w.appendBefore(tagsEnd, "%02X", t.uid[j]);
+    if (!fits || !w.appendBefore(tagsEnd, "\",%u,%lu]", t.track, (unsigned long)t.plays)) {
+      w.rewind(mark);
+      break;
+    }
+  }
+  w.append("]");
+  if (sent < s.tagCount) w.append(",\"truncated\":%u", s.tagCount - sent);
+  // Read straight from the seqlock: this task runs beside loop()
+  PlayerSnapshot st = readPlayerState();
+  w.append(",\"st\":{\"play\":%d,\"trk\":%u,\"fld\":%u,\"vol\":%u}}", st.playing, st.track,
+           st.folder, st.volume);
+  return w.len;
+}
+
+// Warns once if a publish came close to the end of the stack
+static void checkStack() {
+  static bool warned = false;
+  UBaseType_t headroom = uxTaskGetStackHighWaterMark(nullptr);
+  if (warned || headroom >= TELEMETRY_STACK_MARGIN) return;
+  warned = true;
+  Serial.println("⚠️  Telemetry stack headroom " + String(headroom) + " bytes");
+}
+
+// The JSON report and the binary dump are retried independently, so one
+// failing to publish never holds back the other.
+static void telemetryTask(void*) {
+  static Stats snapshot;
+  bool jsonPending = false;
+  bool dumpPending = false;
+  unsigned long lastConnectAttempt = 0;
+
+  for (;;) {
+    if (xQueueReceive(snapshotQueue, &snapshot, pdMS_TO_TICKS(1000)) == pdTRUE) {
+      jsonPending = dumpPending = true;
+    }
+    if (!wifiLinkConnected()) continue;
+
+    if (!mqtt.connected()) {
+      unsigned long now = millis();
+      if (lastConnectAttempt != 0 && now - lastConnectAttempt < MQTT_RECONNECT_INTERVAL) continue;
+      lastConnectAttempt = now;
+      String clientId = String(TELEMETRY_TOPIC_PREFIX) + "-" + wifiLinkDeviceId();
+      if (!mqtt.connect(clientId.c_str())) continue;
+      statsTopic = String(TELEMETRY_TOPIC_PREFIX) + "/" + wifiLinkDeviceId() + "/stats";
+      dumpTopic = String(TELEMETRY_TOPIC_PREFIX) + "/" + wifiLinkDeviceId() + "/dump";
+    }
+    mqtt.loop();
+
+    if (jsonPending && mqtt.publish(statsTopic.c_str(), (const uint8_t*)payload, formatPayload(snapshot))) {
+      jsonPending = false;
+    }
+    // Same snapshot in the binary format the fleet tool merges
+    if (dumpPending) {
+      size_t dumpLength = encodeStats(snapshot, dump, sizeof(dump));
+      if (dumpLength == 0 || mqtt.publish(dumpTopic.c_str(), dump, dumpLength)) dumpPending = false;
+      checkStack();
+    }
+  }
+}
+
+static void takeSnapshot(void*) {
+  xQueueOverwrite(snapshotQueue, &stats);
+  armPeriodic(snapshotTimer, TELEMETRY_INTERVAL);
+}
+
+void telemetryBegin() {
+  if (strlen(MQTT_BROKER_HOST) == 0) {
+    Serial.println("⚠️  Telemetry disabled: no MQTT_BROKER_HOST configured");
+    return;
+  }
+  mqtt.setServer(MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+  mqtt.setBufferSize(max((size_t)TELEMETRY_PAYLOAD_SIZE, STATS_DUMP_MAX_SIZE) + 128);
+  snapshotQueue = xQueueCreate(1, sizeof(Stats));
+  xTaskCreate(telemetryTask, "telemetry", TELEMETRY_TASK_STACK, nullptr, 1, nullptr);
+  snapshotTimer.callback = takeSnapshot;
+  armTimer(snapshotTimer, TELEMETRY_INTERVAL);
+  Serial.println("✅ Telemetry → mqtt://" + String(MQTT_BROKER_HOST) + ":" + String(MQTT_BROKER_PORT));
+}
+#endif
@@ -0,0 +1,35 @@
+#include "timers.h"
+#include "energy.h"
+
+// Upper bound on a single sleep, in case nothing at all is armed.
+const unsigned long MAX_LOOP_SLEEP = 1000;
+
+TimerWheel timers;
+
+void timersBegin() { timers.begin(millis()); }
+
+void armTimer(WheelTimer& timer, unsigned long delayMs) { timers.arm(timer, millis() + delayMs); }
+
+void armTimerAt(WheelTimer& timer, unsigned long when) { timers.arm(timer, when); }
+
+void armPeriodic(WheelTimer& timer, unsigned long period) {
+  unsigned long now = millis();
+  unsigned long next = timer.expiry + period;
+  if ((long)(next - now) <= 0) next = now + period;
+  timers.arm(timer, next);
+}
+
+void runTimers() { timers.advance(millis()); }
+
+void sleepUntilNextTimer() {
+  uint32_t next;
+  unsigned long wait = MAX_LOOP_SLEEP;
+  if (timers.nextExpiry(next)) {
+    long remaining = (long)(next - millis());
+    wait = remaining > 0 ? min((unsigned long)remaining, MAX_LOOP_SLEEP) : 0;
+  }
+  if (wait == 0) return;
+  energyEnter(POWER_CPU_SLEEP);
+  delay(wait);
+  energyEnter(POWER_CPU_ACTIVE);
+}
@@ -0,0 +1,74 @@
+#include "track_gain.h"
+#include <Preferences.h>
+#include "timers.h"
+
+// Same deferred save as the tag library: a series of `gain` commands
+// costs one NVS commit.
+const unsigned long TRACK_GAIN_SAVE_DELAY = 2000;
+
+static TrackGainTable table;
+static uint8_t encoded[TRACK_GAIN_HEADER_SIZE + TRACK_GAIN_MAX_ENTRIES * TRACK_GAIN_ENTRY_SIZE];
+static WheelTimer saveTimer;  // armed while there are unsaved changes
+static Preferences prefs;
+
+static void save(void*) {
+  size_t length = table.encode(encoded, sizeof(encoded));
+  prefs.putBytes("table", encoded, length);
+}
+
+static void markDirty() { armTimer(saveTimer, TRACK_GAIN_SAVE_DELAY); }
+
+void trackGainBegin() {
+  prefs.begin("gains", false);
+  size_t length = prefs.getBytes("table", encoded, sizeof(encoded));
+  if (length > 0) table.decode(encoded, length);
+  saveTimer.callback = save;
+  Serial.println("✅ Track gains: " + String(table.size()) + " tracks");
+}
+
+int8_t trackGainFor(uint8_t folder, uint8_t track) { return table.find(folder, track); }
+
+bool trackGainSet(uint8_t folder, uint8_t track, float db) {
+  if (!table.set(folder, track, trackGainFromDb(db))) return false;
+  markDirty();
+  return true;
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool trackGainLoad(const String& hex) {
+  size_t length = hex.length() / 2;
+  if (hex.length() % 2 != 0 || length > sizeof(encoded)) return false;
+  for (size_t i = 0; i < length; i++) {
+    int high = hexDigit(hex[2 * i]);
+    int low = hexDigit(hex[2 * i + 1]);
+    if (high < 0 || low < 0) return false;
+    encoded[i] = high << 4 | low;
+  }
+  // A bad paste must not wipe the table that is in use
+  static TrackGainTable candidate;
+  if (!candidate.decode(encoded, length)) return false;
+  table = candidate;
+  markDirty();
+  return true;
+}
+
+void trackGainClear() {
+  table.clear();
+  markDirty();
+}
+
+void printTrackGains() {
+  Serial.println("🎚️ Track gains: " + String(table.size()) + "/" + String(TRACK_GAIN_MAX_ENTRIES));
+  for (uint16_t i = 0; i < table.size(); i++) {
+    const TrackGainEntry& e = table.entry(i);
+    String where = e.folder ? "folder " + String(e.folder) + " track " + String(e.track) : "track " + String(e.track);
+    Serial.println("  " + where + ": " + String(trackGainDb(e.gain), 2) + " dB → " +
+                   String(dfPlayerVolumeOffset(e.gain)) + " steps");
+  }
+}
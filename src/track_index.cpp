@@ -0,0 +1,178 @@
+#ifdef ENABLE_ESP32_AUDIO
+#include "track_index.h"
+#include <LittleFS.h>
+#include <TrackScan.h>
+
+// "AMTI" <format> <volume serial u32> <directory checksum u32>, then per
+// track, ordered by folder and track: <track> <first cluster u32> <size u32>,
+// and last the number of tracks in each folder 0..99.
+const char* const TRACK_INDEX_PATH = "/tracks.idx";
+const char* const TRACK_INDEX_BUILD_PATH = "/tracks.new";  // renamed once complete
+const uint8_t TRACK_INDEX_FORMAT = 1;
+const uint8_t TRACK_INDEX_HEADER_SIZE = 4 + 1 + 4 + 4;
+const uint8_t TRACK_INDEX_ENTRY_SIZE = 9;
+const uint8_t FOLDER_COUNT = TRACK_SCAN_MAX_FOLDER + 1;
+// Directory sectors read per service tick while checking or rebuilding:
+// about 2 ms of SPI reads, and a card with a few thousand tracks has a few
+// hundred directory sectors.
+const uint16_t TRACK_INDEX_SCAN_SECTORS = 4;
+
+enum TrackIndexScan : uint8_t { SCAN_NONE, SCAN_CHECKING, SCAN_BUILDING };
+
+static FatVolume volume;
+static struct {
+  bool ready = false;
+  TrackIndexScan scan = SCAN_NONE;
+  uint32_t checksum;       // of the loaded index, then of the card once checked
+  unsigned long scanMs;    // spent in trackIndexService() so far
+  uint16_t folderStart[FOLDER_COUNT + 1];  // entry index, prefix sums of the counts
+} trackIndex;
+
+static bool readSdSector(uint32_t sector, uint8_t* data, void* sd) {
+  return ((fs::SDFS*)sd)->readRAW(data, sector);
+}
+
+static void put32(uint8_t* out, uint32_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+  out[2] = v >> 16;
+  out[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t* in) {
+  return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+// The folder table is rebuilt from the counts at the end of the file. Only
+// the serial has to match; the checksum is returned for checking later.
+static bool loadIndex(uint32_t serial, uint32_t& checksum) {
+  File f = LittleFS.open(TRACK_INDEX_PATH, "r");
+  if (!f) return false;
+  uint8_t header[TRACK_INDEX_HEADER_SIZE];
+  uint8_t counts[FOLDER_COUNT];
+  size_t size = f.size();
+  bool ok = size >= sizeof(header) + sizeof(counts) && f.read(header, sizeof(header)) == sizeof(header) &&
+            f.seek(size - sizeof(counts)) && f.read(counts, sizeof(counts)) == sizeof(counts);
+  f.close();
+  if (!ok || memcmp(header, "AMTI", 4) != 0 || header[4] != TRACK_INDEX_FORMAT) return false;
+  if (get32(header + 5) != serial) return false;
+  checksum = get32(header + 9);
+  trackIndex.folderStart[0] = 0;
+  for (uint8_t i = 0; i < FOLDER_COUNT; i++) trackIndex.folderStart[i + 1] = trackIndex.folderStart[i] + counts[i];
+  return size == sizeof(header) + trackIndex.folderStart[FOLDER_COUNT] * TRACK_INDEX_ENTRY_SIZE + sizeof(counts);
+}
+
+static struct {
+  File file;
+  uint8_t counts[FOLDER_COUNT];
+} writer;
+
+static void writeEntry(const TrackLocation& location, void*) {
+  uint8_t entry[TRACK_INDEX_ENTRY_SIZE];
+  entry[0] = location.track;
+  put32(entry + 1, location.firstCluster);
+  put32(entry + 5, location.size);
+  writer.file.write(entry, sizeof(entry));
+  writer.counts[location.folder]++;
+}
+
+// Tracks are written as the scan finds them, under the checksum the check
+// just computed; a build that ends with another checksum is thrown away.
+static bool startBuild() {
+  memset(writer.counts, 0, sizeof(writer.counts));
+  writer.file = LittleFS.open(TRACK_INDEX_BUILD_PATH, "w");
+  if (!writer.file) return false;
+  uint8_t header[TRACK_INDEX_HEADER_SIZE] = {'A', 'M', 'T', 'I', TRACK_INDEX_FORMAT};
+  put32(header + 5, volume.serial());
+  put32(header + 9, trackIndex.checksum);
+  writer.file.write(header, sizeof(header));
+  trackScanBegin(volume, writeEntry, nullptr);
+  trackIndex.scan = SCAN_BUILDING;
+  return true;
+}
+
+static bool finishBuild(bool ok) {
+  if (ok) writer.file.write(writer.counts, sizeof(writer.counts));
+  writer.file.close();
+  if (ok && trackScanChecksum() == trackIndex.checksum) {
+    LittleFS.remove(TRACK_INDEX_PATH);
+    uint32_t checksum;
+    if (LittleFS.rename(TRACK_INDEX_BUILD_PATH, TRACK_INDEX_PATH) && loadIndex(volume.serial(), checksum)) return true;
+  }
+  LittleFS.remove(TRACK_INDEX_BUILD_PATH);
+  return false;
+}
+
+// A stale index is only dropped once the check has found a difference, so
+// the first plays after boot never wait for the directories.
+bool trackIndexBegin(fs::SDFS& sd) {
+  trackIndex.ready = false;
+  trackIndex.scan = SCAN_NONE;
+  if (!volume.mount(readSdSector, &sd)) {
+    Serial.println("⚠️  Track index: SD card is not FAT32");
+    return false;
+  }
+  LittleFS.begin(true);
+  trackIndex.ready = loadIndex(volume.serial(), trackIndex.checksum);
+  trackIndex.scanMs = 0;
+  trackScanBegin(volume, nullptr, nullptr);
+  trackIndex.scan = SCAN_CHECKING;
+  if (trackIndex.ready) {
+    Serial.println("✅ Track index: " + String(trackIndex.folderStart[FOLDER_COUNT]) + " tracks, checking the card");
+  } else {
+    Serial.println("Track index: none for this card, building");
+  }
+  return true;
+}
+
+void trackIndexService() {
+  if (trackIndex.scan == SCAN_NONE) return;
+  unsigned long start = millis();
+  TrackScanStatus status = trackScanStep(TRACK_INDEX_SCAN_SECTORS);
+  trackIndex.scanMs += millis() - start;
+  if (status == TRACK_SCAN_RUNNING) return;
+  TrackIndexScan finished = trackIndex.scan;
+  trackIndex.scan = SCAN_NONE;
+  if (finished == SCAN_CHECKING) {
+    if (status == TRACK_SCAN_FAILED) {
+      Serial.println("⚠️  Track index: reading the card's directories failed");
+      return;
+    }
+    if (trackIndex.ready && trackScanChecksum() == trackIndex.checksum) {
+      Serial.println("✅ Track index: card unchanged (" + String(trackIndex.scanMs) + " ms)");
+      return;
+    }
+    trackIndex.ready = false;
+    trackIndex.checksum = trackScanChecksum();
+    if (!startBuild()) Serial.println("⚠️  Track index: build failed");
+    return;
+  }
+  if (!finishBuild(status == TRACK_SCAN_DONE)) {
+    Serial.println("⚠️  Track index: build failed");
+    return;
+  }
+  trackIndex.ready = true;
+  Serial.println("✅ Track index: " + String(trackIndex.folderStart[FOLDER_COUNT]) + " tracks, rebuilt (" +
+                 String(trackIndex.scanMs) + " ms)");
+}
+
+bool trackIndexOpen(uint8_t folder, uint8_t track, FatFile& file) {
+  if (!trackIndex.ready || folder >= FOLDER_COUNT) return false;
+  File f = LittleFS.open(TRACK_INDEX_PATH, "r");
+  if (!f) return false;
+  uint16_t low = trackIndex.folderStart[folder];
+  uint16_t high = trackIndex.folderStart[folder + 1];
+  uint8_t entry[TRACK_INDEX_ENTRY_SIZE];
+  bool found = false;
+  while (low < high && !found) {
+    uint16_t mid = (low + high) / 2;
+    if (!f.seek(TRACK_INDEX_HEADER_SIZE + mid * TRACK_INDEX_ENTRY_SIZE) || f.read(entry, sizeof(entry)) != sizeof(entry)) break;
+    if (entry[0] == track) found = true;
+    else if (entry[0] < track) low = mid + 1;
+    else high = mid;
+  }
+  f.close();
+  if (found) file.open(volume, get32(entry + 1), get32(entry + 5));
+  return found;
+}
+#endif
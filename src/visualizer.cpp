@@ -0,0 +1,114 @@
+#if defined(ENABLE_ESP32_AUDIO) && defined(ENABLE_VISUALIZER)
+#include "visualizer.h"
+#include <Spectrum.h>
+#include "board_config.h"
+
+const uint8_t VISUALIZER_LEDC_CHANNEL = 0;
+const uint32_t VISUALIZER_PWM_FREQUENCY = 5000;
+const uint8_t VISUALIZER_MIN_BRIGHTNESS = 16;  // never looks off while playing
+const uint8_t LED_BANDS = 4;                   // the single LED follows the bass half
+
+static Spectrum spectrum;
+static struct {
+  bool on = false;
+  uint32_t sampleRate = 0;
+  uint32_t stepEstimateUs = 0;  // slowest recent step, decays so one interrupt cannot stall it
+  uint32_t worstStepUs = 0;
+  uint32_t worstBlockUs = 0;
+} viz;
+
+// Levels are logarithmic already; squaring them looks more even on an LED
+static uint8_t brightness(uint8_t level) { return (uint16_t)level * level / 255; }
+
+#ifdef VISUALIZER_STRIP_PIN
+#ifndef VISUALIZER_STRIP_LEDS
+#define VISUALIZER_STRIP_LEDS SPECTRUM_BANDS
+#endif
+// WS2812 bits at a 100 ns tick: 0 = 0.4 µs high, 0.8 µs low; 1 = 0.8 / 0.4
+const uint8_t WS2812_SHORT = 4;
+const uint8_t WS2812_LONG = 8;
+// Red for the bass through to violet for the treble
+const uint8_t BAND_COLOURS[SPECTRUM_BANDS][3] = {
+  {255, 0, 0}, {255, 96, 0}, {255, 200, 0}, {96, 255, 0},
+  {0, 255, 96}, {0, 160, 255}, {64, 0, 255}, {200, 0, 255},
+};
+
+static rmt_obj_t* strip = nullptr;
+static rmt_data_t stripBits[VISUALIZER_STRIP_LEDS * 24];
+
+static void showStrip(const uint8_t* levels) {
+  if (!strip) return;
+  rmt_data_t* bit = stripBits;
+  for (uint8_t led = 0; led < VISUALIZER_STRIP_LEDS; led++) {
+    uint8_t band = led * SPECTRUM_BANDS / VISUALIZER_STRIP_LEDS;
+    uint8_t level = viz.on ? brightness(levels[band]) : 0;
+    const uint8_t* rgb = BAND_COLOURS[band];
+    uint8_t grb[3] = {(uint8_t)(rgb[1] * level / 255), (uint8_t)(rgb[0] * level / 255), (uint8_t)(rgb[2] * level / 255)};
+    for (uint8_t byte = 0; byte < 3; byte++) {
+      for (int8_t b = 7; b >= 0; b--, bit++) {
+        bool one = grb[byte] >> b & 1;
+        bit->level0 = 1;
+        bit->duration0 = one ? WS2812_LONG : WS2812_SHORT;
+        bit->level1 = 0;
+        bit->duration1 = one ? WS2812_SHORT : WS2812_LONG;
+      }
+    }
+  }
+  rmtWrite(strip, stripBits, sizeof(stripBits) / sizeof(stripBits[0]));
+}
+#endif
+
+static void showLevels(const uint8_t* levels) {
+  uint8_t loudest = 0;
+  for (uint8_t band = 0; band < LED_BANDS; band++) loudest = max(loudest, levels[band]);
+  if (viz.on) ledcWrite(VISUALIZER_LEDC_CHANNEL, max(brightness(loudest), VISUALIZER_MIN_BRIGHTNESS));
+#ifdef VISUALIZER_STRIP_PIN
+  showStrip(levels);
+#endif
+}
+
+void visualizerBegin() {
+  ledcSetup(VISUALIZER_LEDC_CHANNEL, VISUALIZER_PWM_FREQUENCY, 8);
+  ledcAttachPin(LED_PIN, VISUALIZER_LEDC_CHANNEL);
+  ledcWrite(VISUALIZER_LEDC_CHANNEL, 0);
+#ifdef VISUALIZER_STRIP_PIN
+  strip = rmtInit(VISUALIZER_STRIP_PIN, RMT_TX_MODE, RMT_MEM_64);
+  if (strip) rmtSetTick(strip, 100);
+  else Serial.println("⚠️  Visualiser strip: no RMT channel");
+#endif
+}
+
+bool visualizerSetLed(bool on) {
+  viz.on = on;
+  ledcWrite(VISUALIZER_LEDC_CHANNEL, on ? 255 : 0);
+#ifdef VISUALIZER_STRIP_PIN
+  if (!on) showStrip(spectrum.levels());
+#endif
+  return true;
+}
+
+void visualizerAudio(const int16_t* pcm, size_t frames, uint8_t channels, uint32_t sampleRate) {
+  int64_t start = esp_timer_get_time();
+  if (sampleRate != viz.sampleRate) {
+    spectrum.begin(sampleRate);
+    viz.sampleRate = sampleRate;
+  }
+  spectrum.feed(pcm, frames, channels);
+  while (spectrum.busy()) {
+    int64_t stepStart = esp_timer_get_time();
+    if (stepStart - start + viz.stepEstimateUs > VISUALIZER_BUDGET_US) break;
+    bool ready = spectrum.step();
+    uint32_t stepUs = esp_timer_get_time() - stepStart;
+    viz.stepEstimateUs = max(stepUs, viz.stepEstimateUs - viz.stepEstimateUs / 8);
+    viz.worstStepUs = max(viz.worstStepUs, stepUs);
+    if (ready) showLevels(spectrum.levels());
+  }
+  viz.worstBlockUs = max(viz.worstBlockUs, (uint32_t)(esp_timer_get_time() - start));
+}
+
+void printVisualizer() {
+  Serial.println("🌈 Visualiser: " + String(spectrum.windows()) + " windows, " + String(spectrum.dropped()) +
+                 " dropped, worst step " + String(viz.worstStepUs) + " µs, worst block " + String(viz.worstBlockUs) +
+                 " µs of " + String(VISUALIZER_BUDGET_US) + " µs");
+}
+#endif
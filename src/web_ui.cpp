@@ -0,0 +1,311 @@
+#include "web_ui.h"
+
+#ifdef ENABLE_WEB_UI
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include "player_state.h"
+#include "stats.h"
+#include "tag_library.h"
+#include "timers.h"
+#include "web_ui_page.h"
+
+// Single-threaded, event-driven HTTP server driven from loop(). One
+// select() with a zero timeout tells us which of a fixed set of connection
+// slots can make progress; each ready slot then reads, or sends at most one
+// small chunk with MSG_DONTWAIT. Responses are generated chunk by chunk and
+// streamed until the connection closes, so no call ever waits on the
+// network and the work per loop pass stays bounded.
+const uint16_t WEB_UI_PORT = 80;
+const uint8_t WEB_MAX_CONNECTIONS = 3;
+const uint16_t WEB_REQUEST_SIZE = 512;
+const uint16_t WEB_CHUNK_SIZE = 256;
+const unsigned long WEB_CONNECTION_TIMEOUT = 5000;
+
+enum SlotPhase : uint8_t { SLOT_FREE, SLOT_READING, SLOT_WRITING };
+enum Route : uint8_t { ROUTE_PAGE, ROUTE_TAGS, ROUTE_STATS, ROUTE_STATE, ROUTE_ASSIGN, ROUTE_BAD_REQUEST, ROUTE_NOT_FOUND };
+
+struct Connection {
+  int fd = -1;
+  SlotPhase phase = SLOT_FREE;
+  Route route;
+  bool assigned;
+  WheelTimer timeout;
+  char request[WEB_REQUEST_SIZE];
+  uint16_t requestLength;
+  char chunk[WEB_CHUNK_SIZE];
+  uint16_t chunkLength;
+  uint16_t chunkSent;
+  uint16_t cursor;  // position of the response generator
+};
+
+static Connection connections[WEB_MAX_CONNECTIONS];
+static int listenFd = -1;
+
+static void closeConnection(Connection& c) {
+  timers.cancel(c.timeout);
+  close(c.fd);
+  c.fd = -1;
+  c.phase = SLOT_FREE;
+}
+
+static void onConnectionTimeout(void* context) { closeConnection(*(Connection*)context); }
+
+// ==================== REQUEST PARSING ====================
+static bool queryParam(const char* query, const char* name, char* out, size_t outSize) {
+  size_t nameLength = strlen(name);
+  for (const char* p = query; p && *p;) {
+    if (strncmp(p, name, nameLength) == 0 && p[nameLength] == '=') {
+      p += nameLength + 1;
+      size_t n = 0;
+      while (*p && *p != '&' && n + 1 < outSize) out[n++] = *p++;
+      out[n] = '\0';
+      return true;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  return false;
+}
+
+static Route handleAssign(Connection& c, const char* query) {
+  char value[24];
+  uint8_t uid[7], uidLength;
+  if (!query || !queryParam(query, "uid", value, sizeof(value)) || !parseUid(value, uid, &uidLength)) {
+    return ROUTE_BAD_REQUEST;
+  }
+  int track = queryParam(query, "track", value, sizeof(value)) ? atoi(value) : 0;
+  int folder = queryParam(query, "folder", value, sizeof(value)) ? atoi(value) : 0;
+  if (track < 0 || track > 99 || folder < 0 || folder > 99) return ROUTE_BAD_REQUEST;
+  c.assigned = tagLibraryAssign(uid, uidLength, track, folder);
+  return ROUTE_ASSIGN;
+}
+
+static Route routeRequest(Connection& c) {
+  // "METHOD /path?query HTTP/1.x"
+  char* method = c.request;
+  char* target = strchr(method, ' ');
+  if (!target) return ROUTE_BAD_REQUEST;
+  *target++ = '\0';
+  char* end = strchr(target, ' ');
+  if (!end) return ROUTE_BAD_REQUEST;
+  *end = '\0';
+  char* query = strchr(target, '?');
+  if (query) *query++ = '\0';
+
+  bool isGet = strcmp(method, "GET") == 0;
+  if (isGet && strcmp(target, "/") == 0) return ROUTE_PAGE;
+  if (isGet && strcmp(target, "/api/tags") == 0) return ROUTE_TAGS;
+  if (isGet && strcmp(target, "/api/stats") == 0) return ROUTE_STATS;
+  if (isGet && strcmp(target, "/api/state") == 0) return ROUTE_STATE;
+  if (strcmp(method, "POST") == 0 && strcmp(target, "/api/tags") == 0) return handleAssign(c, query);
+  return ROUTE_NOT_FOUND;
+}
+
+static void readRequest(Connection& c) {
+  int n = recv(c.fd, c.request + c.requestLength, WEB_REQUEST_SIZE - 1 - c.requestLength, MSG_DONTWAIT);
+  if (n == 0 || (n < 0 && errno != EWOULDBLOCK && errno != EAGAIN)) {
+    closeConnection(c);
+    return;
+  }
+  if (n < 0) return;
+  c.requestLength += n;
+  c.request[c.requestLength] = '\0';
+
+  // Only the request line matters; bodies are ignored.
+  if (strstr(c.request, "\r\n\r\n") || strstr(c.request, "\n\n")) {
+    c.route = routeRequest(c);
+  } else if (c.requestLength >= WEB_REQUEST_SIZE - 1) {
+    c.route = ROUTE_BAD_REQUEST;
+  } else {
+    return;
+  }
+  c.phase = SLOT_WRITING;
+  c.cursor = 0;
+  c.chunkLength = c.chunkSent = 0;
+}
+
+// ==================== RESPONSE GENERATION ====================
+static uint32_t playsForTag(const TagEntry& e) {
+  for (uint8_t i = 0; i < stats.tagCount; i++) {
+    const TagPlayCount& t = stats.tags[i];
+    if (t.uidLength == e.uidLength && memcmp(t.uid, e.uid, e.uidLength) == 0) return t.plays;
+  }
+  return 0;
+}
+
+static int header(char* out, const char* status, const char* contentType) {
+  return snprintf(out, WEB_CHUNK_SIZE,
+                  "HTTP/1.1 %s\r\nContent-Type: %s\r\nCache-Control: no-store\r\n"
+                  "Connection: close\r\n\r\n", status, contentType);
+}
+
+// Fills c.chunk with the next piece of the response. Returns false once
+// the response is complete.
+static bool nextChunk(Connection& c) {
+  char* out = c.chunk;
+  int n = 0;
+  int limit = WEB_CHUNK_SIZE - 1;  // a truncated snprintf ends in its NUL
+  uint16_t step = c.cursor++;
+
+  switch (c.route) {
+    case ROUTE_PAGE: {
+      if (step == 0) {
+        n = header(out, "200 OK", "text/html; charset=utf-8");
+        break;
+      }
+      size_t offset = (size_t)(step - 1) * WEB_CHUNK_SIZE;
+      size_t total = sizeof(INDEX_HTML) - 1;
+      if (offset >= total) return false;
+      n = min((size_t)WEB_CHUNK_SIZE, total - offset);
+      memcpy_P(out, INDEX_HTML + offset, n);
+      limit = WEB_CHUNK_SIZE;  // copied as is, every byte is page
+      break;
+    }
+    case ROUTE_TAGS: {
+      uint8_t count = tagLibraryCount();
+      if (step == 0) {
+        n = header(out, "200 OK", "application/json");
+        n += snprintf(out + n, WEB_CHUNK_SIZE - n, "[");
+        break;
+      }
+      if (step > count) {
+        if (step > count + 1) return false;
+        n = snprintf(out, WEB_CHUNK_SIZE, "]\n");
+        break;
+      }
+      const TagEntry& e = tagLibraryEntry(step - 1);
+      n = snprintf(out, WEB_CHUNK_SIZE, "%s{\"uid\":\"", step > 1 ? "," : "");
+      for (uint8_t i = 0; i < e.uidLength; i++) n += snprintf(out + n, WEB_CHUNK_SIZE - n, "%02X", e.uid[i]);
+      n += snprintf(out + n, WEB_CHUNK_SIZE - n, "\",\"tag\":%u,\"track\":%u,\"folder\":%u,\"plays\":%lu}",
+                    e.tagTrack, e.track, e.folder, (unsigned long)playsForTag(e));
+      break;
+    }
+    case ROUTE_STATS: {
+      if (step == 0) {
+        n = header(out, "200 OK", "application/json");
+        break;
+      }
+      if (step > 1) return false;
+      const Histogram& h = stats.tagToPlayMicros;
+      n = snprintf(out, WEB_CHUNK_SIZE,
+                   "{\"up\":%lu,\"det\":%lu,\"plays\":%lu,\"rf\":%lu,\"gs\":%lu,"
+                   "\"lat\":{\"n\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}}\n",
+                   millis() / 1000, (unsigned long)stats.tagDetections, (unsigned long)stats.plays,
+                   (unsigned long)stats.readFailures, (unsigned long)stats.graceStops,
+                   (unsigned long)h.count(), (unsigned long)h.percentile(50),
+                   (unsigned long)h.percentile(90), (unsigned long)h.percentile(99),
+                   (unsigned long)h.maxValue());
+      break;
+    }
+    case ROUTE_STATE: {
+      if (step == 0) {
+        n = header(out, "200 OK", "application/json");
+        break;
+      }
+      if (step > 1) return false;
+      PlayerSnapshot s = readPlayerState();
+      n = snprintf(out, WEB_CHUNK_SIZE,
+                   "{\"tag\":%d,\"playing\":%d,\"track\":%u,\"folder\":%u,\"volume\":%u,"
+                   "\"eq\":%u,\"shuffle\":%d,\"locked\":%d,\"sleep\":%d,\"learn\":%d}\n",
+                   s.tagPresent, s.playing, s.track, s.folder, s.volume, s.eq, s.shuffle,
+                   s.buttonsLocked, s.sleepTimerArmed, s.learning);
+      break;
+    }
+    case ROUTE_ASSIGN:
+      if (step > 0) return false;
+      n = header(out, c.assigned ? "200 OK" : "507 Insufficient Storage", "application/json");
+      n += snprintf(out + n, WEB_CHUNK_SIZE - n, c.assigned ? "{\"ok\":true}\n" : "{\"ok\":false}\n");
+      break;
+    case ROUTE_BAD_REQUEST:
+      if (step > 0) return false;
+      n = header(out, "400 Bad Request", "text/plain");
+      n += snprintf(out + n, WEB_CHUNK_SIZE - n, "bad request\n");
+      break;
+    case ROUTE_NOT_FOUND:
+      if (step > 0) return false;
+      n = header(out, "404 Not Found", "text/plain");
+      n += snprintf(out + n, WEB_CHUNK_SIZE - n, "not found\n");
+      break;
+  }
+
+  c.chunkLength = min(n, limit);
+  c.chunkSent = 0;
+  return true;
+}
+
+static void writeResponse(Connection& c) {
+  if (c.chunkSent == c.chunkLength && !nextChunk(c)) {
+    closeConnection(c);
+    return;
+  }
+  int n = send(c.fd, c.chunk + c.chunkSent, c.chunkLength - c.chunkSent, MSG_DONTWAIT);
+  if (n < 0) {
+    if (errno != EWOULDBLOCK && errno != EAGAIN) closeConnection(c);
+    return;
+  }
+  c.chunkSent += n;
+}
+
+// ==================== EVENT LOOP ====================
+static void acceptConnections() {
+  for (Connection& c : connections) {
+    if (c.phase != SLOT_FREE) continue;
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return;  // nothing pending (or error): try again next pass
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    c.fd = fd;
+    c.phase = SLOT_READING;
+    c.requestLength = 0;
+    c.timeout.callback = onConnectionTimeout;
+    c.timeout.context = &c;
+    armTimer(c.timeout, WEB_CONNECTION_TIMEOUT);
+  }
+  // All slots busy: further clients wait in the listen backlog.
+}
+
+void webUiBegin() {
+  listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (listenFd < 0) {
+    Serial.println("❌ Web UI: socket failed");
+    return;
+  }
+  int reuse = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(WEB_UI_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 4) < 0) {
+    Serial.println("❌ Web UI: bind/listen failed");
+    close(listenFd);
+    listenFd = -1;
+    return;
+  }
+  fcntl(listenFd, F_SETFL, O_NONBLOCK);
+  Serial.println("✅ Web UI listening on port " + String(WEB_UI_PORT));
+}
+
+void webUiLoop() {
+  if (listenFd < 0) return;
+
+  fd_set readable, writable;
+  FD_ZERO(&readable);
+  FD_ZERO(&writable);
+  FD_SET(listenFd, &readable);
+  int maxFd = listenFd;
+  for (Connection& c : connections) {
+    if (c.phase == SLOT_READING) FD_SET(c.fd, &readable);
+    if (c.phase == SLOT_WRITING) FD_SET(c.fd, &writable);
+    if (c.phase != SLOT_FREE && c.fd > maxFd) maxFd = c.fd;
+  }
+  struct timeval noWait = {0, 0};
+  if (select(maxFd + 1, &readable, &writable, nullptr, &noWait) < 0) return;
+
+  if (FD_ISSET(listenFd, &readable)) acceptConnections();
+
+  for (Connection& c : connections) {
+    if (c.phase == SLOT_READING && FD_ISSET(c.fd, &readable)) readRequest(c);
+    else if (c.phase == SLOT_WRITING && FD_ISSET(c.fd, &writable)) writeResponse(c);
+  }
+}
+#endif
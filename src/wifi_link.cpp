@@ -0,0 +1,35 @@
+#include "wifi_link.h"
+
+#ifdef USE_WIFI
+#include <WiFi.h>
+
+// WiFi.begin() returns immediately; association and reconnects are handled
+// by the Wi-Fi driver task, so loop() never waits on the network.
+// Without station credentials the web UI build opens its own access point
+// instead, so a box can be managed with nothing but a phone.
+void wifiLinkBegin() {
+  if (strlen(WIFI_SSID) == 0) {
+#ifdef ENABLE_WEB_UI
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(WIFI_AP_SSID, strlen(WIFI_AP_PASSWORD) ? WIFI_AP_PASSWORD : nullptr);
+    Serial.println("📶 Access point \"" + String(WIFI_AP_SSID) + "\" at " + WiFi.softAPIP().toString());
+#else
+    Serial.println("⚠️  Wi-Fi disabled: no WIFI_SSID configured");
+#endif
+    return;
+  }
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  Serial.println("📶 Connecting to Wi-Fi \"" + String(WIFI_SSID) + "\"...");
+}
+
+bool wifiLinkConnected() { return WiFi.status() == WL_CONNECTED; }
+
+String wifiLinkDeviceId() {
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  mac.toLowerCase();
+  return mac;
+}
+#endif
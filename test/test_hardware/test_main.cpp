@@ -0,0 +1,257 @@
+// On-device tests against the real PN532 and DFPlayer, through the same
+// modules the firmware uses. Needs the box wired as in board_config.h, an
+// SD card with 0001.mp3, and a tag written by this firmware on the reader:
+//   pio test -e esp32-c3-devkitm-1-test
+// Besides Unity's own PASS/FAIL lines every timing test prints
+//   TIMING <name> max_us=<worst> limit_us=<limit>
+// so a bench rig can track the numbers over time, not just the verdict.
+#include <Arduino.h>
+#include <DFPlayerFrame.h>
+#include <DFRobotDFPlayerMini.h>
+#include <HardwareSerial.h>
+#include <Wire.h>
+#include <unity.h>
+#include "audio_power.h"
+#include "board_config.h"
+#include "nfc_reader.h"
+#include "pn532_ext.h"
+#include "player_state.h"
+#include "tag_library.h"
+#include "timers.h"
+
+// Budgets, with headroom over what a healthy C3 board measures
+const unsigned long UID_POLL_LIMIT_US = 30000;
+const unsigned long PAGE_READ_LIMIT_US = 10000;     // one NTAG READ, 4 pages
+const unsigned long ARRIVAL_READ_LIMIT_US = 15000;  // FAST_READ of pages 4..9
+const unsigned long PLAY_ENQUEUE_LIMIT_US = 200;    // volume + EQ + play frames into the UART
+const unsigned long LOOP_BUDGET_US = NFC_CHECK_INTERVAL * 1000 / 2;
+const uint8_t REPEATS = 10;
+const uint8_t WAKE_REPEATS = 3;                                  // each costs a sleep and a wake
+const unsigned long WAKE_LIMIT_US = AUDIO_WAKE_TIMEOUT * 1000UL;  // the firmware gives up here
+
+HardwareSerial dfPlayerSerial(1);
+DFRobotDFPlayerMini dfPlayer;
+static bool dfPlayerOnline = false;
+
+static void reportTiming(const char* name, unsigned long maxMicros, unsigned long limitMicros) {
+  char line[96];
+  snprintf(line, sizeof(line), "TIMING %s max_us=%lu limit_us=%lu", name, maxMicros, limitMicros);
+  Serial.println(line);
+}
+
+static void requireTag() {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  if (!nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100)) {
+    TEST_FAIL_MESSAGE("no tag on the reader");
+  }
+}
+
+void setUp() {}
+
+void tearDown() {
+  if (dfPlayerOnline) dfPlayer.stop();
+}
+
+void test_pn532_responds() {
+  TEST_ASSERT_NOT_EQUAL_MESSAGE(0, nfc.getFirmwareVersion(), "PN532 not found");
+}
+
+void test_uid_poll_time() {
+  requireTag();
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < REPEATS; i++) {
+    uint8_t uid[7];
+    uint8_t uidLength;
+    unsigned long start = micros();
+    bool found = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100);
+    unsigned long elapsed = micros() - start;
+    TEST_ASSERT_TRUE_MESSAGE(found, "tag lost during the test");
+    worst = max(worst, elapsed);
+  }
+  reportTiming("uid_poll", worst, UID_POLL_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(UID_POLL_LIMIT_US, worst);
+}
+
+void test_page_read_time() {
+  requireTag();
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < REPEATS; i++) {
+    uint8_t data[NTAG_READ_SIZE];
+    unsigned long start = micros();
+    bool ok = pn532ReadPages(nfc, TAG_RECORD_PAGE, data);
+    unsigned long elapsed = micros() - start;
+    TEST_ASSERT_TRUE_MESSAGE(ok, "NTAG READ failed");
+    worst = max(worst, elapsed);
+  }
+  reportTiming("page_read", worst, PAGE_READ_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(PAGE_READ_LIMIT_US, worst);
+}
+
+void test_arrival_read_time() {
+  requireTag();
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < REPEATS; i++) {
+    TagRecord record;
+    unsigned long start = micros();
+    TagReadStatus status = readTagRecord(record);
+    unsigned long elapsed = micros() - start;
+    TEST_ASSERT_EQUAL_MESSAGE(TAG_READ_OK, status, "tag has no valid record");
+    worst = max(worst, elapsed);
+  }
+  reportTiming("arrival_read", worst, ARRIVAL_READ_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(ARRIVAL_READ_LIMIT_US, worst);
+}
+
+void test_dfplayer_responds() {
+  dfPlayerSerial.begin(9600, SERIAL_8N1, DFPLAYER_RX_PIN, DFPLAYER_TX_PIN);
+  dfPlayerOnline = dfPlayer.begin(dfPlayerSerial);
+  TEST_ASSERT_TRUE_MESSAGE(dfPlayerOnline, "DFPlayer not responding");
+}
+
+// The same three frames the firmware sends when a tag with presets
+// arrives; queuing them must not wait for the 9600 baud line.
+void test_play_enqueue_time() {
+  if (!dfPlayerOnline) TEST_IGNORE_MESSAGE("DFPlayer offline");
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < REPEATS; i++) {
+    dfPlayerSerial.flush();
+    unsigned long start = micros();
+    uint8_t burst[3 * DFPLAYER_FRAME_SIZE];
+    encodeDFPlayerFrame(DFPLAYER_CMD_VOLUME, 10, false, burst);
+    encodeDFPlayerFrame(DFPLAYER_CMD_EQ, 0, false, burst + DFPLAYER_FRAME_SIZE);
+    encodeDFPlayerFrame(DFPLAYER_CMD_PLAY, 1, false, burst + 2 * DFPLAYER_FRAME_SIZE);
+    dfPlayerSerial.write(burst, sizeof(burst));
+    worst = max(worst, micros() - start);
+  }
+  reportTiming("play_enqueue", worst, PLAY_ENQUEUE_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(PLAY_ENQUEUE_LIMIT_US, worst);
+}
+
+static void sendFrames(const uint8_t* frames, uint8_t count) {
+  dfPlayerSerial.write(frames, count * DFPLAYER_FRAME_SIZE);
+}
+
+// Stopped and asleep, as the idle timer leaves it, with nothing unread
+static void sleepModule() {
+  dfPlayer.stop();
+  delay(200);
+  uint8_t frame[DFPLAYER_FRAME_SIZE];
+  encodeDFPlayerFrame(0x0A, 0, false, frame);  // sleep
+  sendFrames(frame, 1);
+  delay(1000);
+  while (dfPlayerSerial.available()) dfPlayerSerial.read();
+}
+
+// Microseconds from start until BUSY goes low, or 0 if it never does
+static unsigned long waitForBusy(unsigned long start) {
+  while (micros() - start < WAKE_LIMIT_US) {
+    if (digitalRead(DFPLAYER_BUSY_PIN) == LOW) return micros() - start;
+    delay(1);
+  }
+  return 0;
+}
+
+// Reset, then volume and play once the module reports its card online
+static unsigned long wakeByReset() {
+  uint8_t frames[2 * DFPLAYER_FRAME_SIZE];
+  unsigned long start = micros();
+  encodeDFPlayerFrame(0x0C, 0, false, frames);
+  sendFrames(frames, 1);
+  uint8_t reply[DFPLAYER_FRAME_SIZE];
+  uint8_t received = 0;
+  while (micros() - start < WAKE_LIMIT_US) {
+    if (!dfPlayerSerial.available()) continue;
+    uint8_t byte = dfPlayerSerial.read();
+    if (received == 0 && byte != 0x7E) continue;  // frame start
+    reply[received++] = byte;
+    if (received < DFPLAYER_FRAME_SIZE) continue;
+    if (reply[3] == 0x3F) break;  // card online
+    received = 0;
+  }
+  encodeDFPlayerFrame(DFPLAYER_CMD_VOLUME, 10, false, frames);
+  encodeDFPlayerFrame(DFPLAYER_CMD_PLAY, 1, false, frames + DFPLAYER_FRAME_SIZE);
+  sendFrames(frames, 2);
+  return waitForBusy(start);
+}
+
+// What audioPowerWake() sends: select the SD card with the play frame in
+// the same write, while the card is still starting up
+static unsigned long wakeBySelectingCard() {
+  uint8_t frames[2 * DFPLAYER_FRAME_SIZE];
+  encodeDFPlayerFrame(0x09, 0x02, false, frames);  // output device: SD
+  encodeDFPlayerFrame(DFPLAYER_CMD_PLAY, 1, false, frames + DFPLAYER_FRAME_SIZE);
+  unsigned long start = micros();
+  sendFrames(frames, 2);
+  return waitForBusy(start);
+}
+
+// Both ways out of sleep, timed to the BUSY line. The module must take
+// the play frame that follows the wake frame, and the wake the firmware
+// uses has to beat the reset it replaces.
+void test_wake_to_busy() {
+  if (!dfPlayerOnline) TEST_IGNORE_MESSAGE("DFPlayer offline");
+  pinMode(DFPLAYER_BUSY_PIN, INPUT);
+  unsigned long worstSelect = 0;
+  unsigned long worstReset = 0;
+  for (uint8_t i = 0; i < WAKE_REPEATS; i++) {
+    sleepModule();
+    unsigned long selectCard = wakeBySelectingCard();
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(0, selectCard, "no audio after the SD wake burst");
+    worstSelect = max(worstSelect, selectCard);
+    sleepModule();
+    unsigned long reset = wakeByReset();
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(0, reset, "no audio after reset");
+    worstReset = max(worstReset, reset);
+  }
+  reportTiming("wake_select_sd", worstSelect, WAKE_LIMIT_US);
+  reportTiming("wake_reset", worstReset, WAKE_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(worstReset, worstSelect);
+}
+
+// One pass of the firmware's loop() with a tag arriving: timers, a poll
+// through the reader with its record read, and a state publish. It has to
+// fit well inside the poll interval or detection starts to drift.
+void test_loop_iteration_budget() {
+  requireTag();
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < REPEATS; i++) {
+    delay(NFC_CHECK_INTERVAL);  // let the reader notice the tag again
+    nfcSkipMetadata();
+    unsigned long start = micros();
+    runTimers();
+    TagEvent event;
+    bool gotEvent = nfcNextEvent(event);
+    PlayerSnapshot snapshot = {};
+    snapshot.tagPresent = true;
+    snapshot.track = event.record.track;
+    publishPlayerState(snapshot);
+    worst = max(worst, micros() - start);
+    if (i == 0) TEST_ASSERT_TRUE_MESSAGE(gotEvent && event.type == TAG_EVENT_ARRIVED, "no arrival event");
+  }
+  reportTiming("loop_iteration", worst, LOOP_BUDGET_US);
+  TEST_ASSERT_LESS_THAN_UINT32(LOOP_BUDGET_US, worst);
+}
+
+void setup() {
+  delay(2000);  // the test runner needs the USB serial port back after reset
+  timersBegin();
+  Wire.begin(SDA_PIN, SCL_PIN);
+  nfc.begin();
+  nfc.SAMConfig();
+  tagLibraryBegin();
+  nfcBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_pn532_responds);
+  RUN_TEST(test_uid_poll_time);
+  RUN_TEST(test_page_read_time);
+  RUN_TEST(test_arrival_read_time);
+  RUN_TEST(test_dfplayer_responds);
+  RUN_TEST(test_play_enqueue_time);
+  RUN_TEST(test_wake_to_busy);
+  RUN_TEST(test_loop_iteration_budget);
+  UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,342 @@
+// Host tests of lib/FatIndex: FatVolume, FatFile and the track folder scan
+// behind the on-chip audio path's track index, against a small FAT32 image
+// built here in memory:
+//   pio test -e native
+// One sector per cluster, so a few hundred bytes are enough to spread a
+// directory or a file over several clusters.
+#include <FatVolume.h>
+#include <TrackScan.h>
+#include <string.h>
+#include <unity.h>
+
+const uint32_t IMAGE_SECTORS = 256;
+const uint16_t RESERVED_SECTORS = 32;
+const uint32_t FAT_SECTORS = 2;
+const uint32_t DATA_START = RESERVED_SECTORS + FAT_SECTORS;
+const uint32_t VOLUME_SERIAL = 0x1234ABCD;
+
+const uint32_t ROOT_CLUSTER = 2;
+const uint32_t FOLDER_01_CLUSTER = 3;  // continued in FOLDER_01_NEXT_CLUSTER
+const uint32_t FOLDER_01_NEXT_CLUSTER = 10;
+const uint32_t FOLDER_02_CLUSTER = 4;
+const uint32_t SONG_CHAIN[] = {20, 21, 30, 25};  // out of order and with a gap
+const uint32_t SONG_SIZE = 3 * FAT_SECTOR_SIZE + 264;
+const uint32_t TRACK_2_CLUSTER = 40;
+const uint32_t TRACK_3_CLUSTER = 41;
+const uint32_t TRACK_5_CLUSTER = 42;
+const uint32_t DUPLICATE_CLUSTER = 43;
+const uint8_t TRACK_3_SLOT = 1;  // in FOLDER_01_NEXT_CLUSTER
+
+static uint8_t image[IMAGE_SECTORS * FAT_SECTOR_SIZE];
+static uint32_t failingSector = UINT32_MAX;
+static unsigned sectorReads;
+
+static bool readImage(uint32_t sector, uint8_t* data, void*) {
+  if (sector >= IMAGE_SECTORS || sector == failingSector) return false;
+  memcpy(data, image + sector * FAT_SECTOR_SIZE, FAT_SECTOR_SIZE);
+  sectorReads++;
+  return true;
+}
+
+static void put16(uint8_t* out, uint16_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+}
+
+static void put32(uint8_t* out, uint32_t v) {
+  put16(out, v);
+  put16(out + 2, v >> 16);
+}
+
+static uint8_t* clusterData(uint32_t cluster) { return image + (DATA_START + cluster - 2) * FAT_SECTOR_SIZE; }
+
+static void setFat(uint32_t cluster, uint32_t next) { put32(image + RESERVED_SECTORS * FAT_SECTOR_SIZE + cluster * 4, next); }
+
+static uint8_t* dirSlot(uint32_t cluster, uint8_t slot) { return clusterData(cluster) + slot * 32; }
+
+static void putEntry(uint32_t cluster, uint8_t slot, const char* name, uint8_t attributes, uint32_t first, uint32_t size) {
+  uint8_t* raw = dirSlot(cluster, slot);
+  memcpy(raw, name, 11);
+  raw[11] = attributes;
+  put16(raw + 20, first >> 16);
+  put16(raw + 26, first);
+  put32(raw + 28, size);
+}
+
+// A long-name part: sequence byte, then attributes 0x0F
+static void putLongName(uint32_t cluster, uint8_t slot) {
+  uint8_t* raw = dirSlot(cluster, slot);
+  memset(raw, 0xFF, 32);
+  raw[0] = 0x41;
+  raw[11] = 0x0F;
+}
+
+static void putDeleted(uint32_t cluster, uint8_t slot, const char* name, uint32_t first) {
+  putEntry(cluster, slot, name, 0x20, first, 100);
+  dirSlot(cluster, slot)[0] = 0xE5;
+}
+
+static uint8_t songByte(uint32_t offset) { return offset * 7 + offset / 251; }
+
+static void buildImage() {
+  memset(image, 0, sizeof(image));
+  uint8_t* boot = image;
+  boot[0] = 0xEB;
+  put16(boot + 11, FAT_SECTOR_SIZE);
+  boot[13] = 1;
+  put16(boot + 14, RESERVED_SECTORS);
+  boot[16] = 1;
+  put32(boot + 32, IMAGE_SECTORS);
+  put32(boot + 36, FAT_SECTORS);
+  put32(boot + 44, ROOT_CLUSTER);
+  put32(boot + 67, VOLUME_SERIAL);
+  put16(boot + 510, 0xAA55);
+
+  const uint32_t endOfChain = 0x0FFFFFFF;
+  setFat(ROOT_CLUSTER, endOfChain);
+  putEntry(ROOT_CLUSTER, 0, "AMBERTAG   ", 0x08, 0, 0);
+  putLongName(ROOT_CLUSTER, 1);
+  putEntry(ROOT_CLUSTER, 2, "01         ", FAT_ATTR_DIRECTORY, FOLDER_01_CLUSTER, 0);
+  putDeleted(ROOT_CLUSTER, 3, "03         ", 50);
+  putEntry(ROOT_CLUSTER, 4, "README  TXT", 0x20, 51, 10);
+  putEntry(ROOT_CLUSTER, 5, "02         ", FAT_ATTR_DIRECTORY, FOLDER_02_CLUSTER, 0);
+  putEntry(ROOT_CLUSTER, 6, "ABC        ", FAT_ATTR_DIRECTORY, 52, 0);
+
+  // A full first cluster, so the listing has to follow the chain
+  setFat(FOLDER_01_CLUSTER, FOLDER_01_NEXT_CLUSTER);
+  setFat(FOLDER_01_NEXT_CLUSTER, endOfChain);
+  putEntry(FOLDER_01_CLUSTER, 0, ".          ", FAT_ATTR_DIRECTORY, FOLDER_01_CLUSTER, 0);
+  putEntry(FOLDER_01_CLUSTER, 1, "..         ", FAT_ATTR_DIRECTORY, 0, 0);
+  putLongName(FOLDER_01_CLUSTER, 2);
+  putEntry(FOLDER_01_CLUSTER, 3, "001SON~1MP3", 0x20, SONG_CHAIN[0], SONG_SIZE);
+  putDeleted(FOLDER_01_CLUSTER, 4, "002OLD  MP3", 53);
+  putEntry(FOLDER_01_CLUSTER, 5, "002SONG MP3", 0x20, TRACK_2_CLUSTER, 700);
+  putEntry(FOLDER_01_CLUSTER, 6, "001COPY MP3", 0x20, DUPLICATE_CLUSTER, 600);
+  putEntry(FOLDER_01_CLUSTER, 7, "004NOTESTXT", 0x20, 54, 10);
+  for (uint8_t slot = 8; slot < 16; slot++) putDeleted(FOLDER_01_CLUSTER, slot, "009GONE MP3", 55);
+  putLongName(FOLDER_01_NEXT_CLUSTER, 0);
+  putEntry(FOLDER_01_NEXT_CLUSTER, TRACK_3_SLOT, "003SONG WAV", 0x20, TRACK_3_CLUSTER, 800);
+
+  setFat(FOLDER_02_CLUSTER, endOfChain);
+  putEntry(FOLDER_02_CLUSTER, 0, "005TRACKMP3", 0x20, TRACK_5_CLUSTER, 900);
+
+  const size_t songClusters = sizeof(SONG_CHAIN) / sizeof(SONG_CHAIN[0]);
+  for (size_t i = 0; i < songClusters; i++) {
+    setFat(SONG_CHAIN[i], i + 1 < songClusters ? SONG_CHAIN[i + 1] : endOfChain);
+    for (uint16_t b = 0; b < FAT_SECTOR_SIZE; b++) clusterData(SONG_CHAIN[i])[b] = songByte(i * FAT_SECTOR_SIZE + b);
+  }
+}
+
+static FatVolume volume;
+
+void setUp() {
+  buildImage();
+  failingSector = UINT32_MAX;
+  TEST_ASSERT_TRUE(volume.mount(readImage, nullptr));
+}
+
+void tearDown() {}
+
+struct Listing {
+  unsigned count;
+  char names[16][12];
+};
+
+static bool listEntry(const FatDirEntry& entry, void* context) {
+  Listing& listing = *(Listing*)context;
+  if (listing.count < 16) {
+    memcpy(listing.names[listing.count], entry.name, 11);
+    listing.names[listing.count][11] = '\0';
+  }
+  listing.count++;
+  return true;
+}
+
+struct Tracks {
+  unsigned count;
+  TrackLocation found[8];
+};
+
+static void collectTrack(const TrackLocation& location, void* context) {
+  Tracks& tracks = *(Tracks*)context;
+  if (tracks.count < 8) tracks.found[tracks.count] = location;
+  tracks.count++;
+}
+
+static void assertTrack(const TrackLocation& expected, const TrackLocation& actual) {
+  TEST_ASSERT_EQUAL_UINT8(expected.folder, actual.folder);
+  TEST_ASSERT_EQUAL_UINT8(expected.track, actual.track);
+  TEST_ASSERT_EQUAL_UINT32(expected.firstCluster, actual.firstCluster);
+  TEST_ASSERT_EQUAL_UINT32(expected.size, actual.size);
+}
+
+static uint32_t checksumOf() {
+  uint32_t checksum = 0;
+  TEST_ASSERT_TRUE(scanTrackFolders(volume, nullptr, nullptr, checksum));
+  return checksum;
+}
+
+void test_mount_reads_boot_sector() {
+  TEST_ASSERT_EQUAL_HEX32(VOLUME_SERIAL, volume.serial());
+  TEST_ASSERT_EQUAL_UINT32(ROOT_CLUSTER, volume.rootCluster());
+  TEST_ASSERT_EQUAL_UINT32(FAT_SECTOR_SIZE, volume.clusterBytes());
+}
+
+void test_mount_rejects_fat16() {
+  put32(image + 36, 0);  // FAT32 sectors-per-FAT field left empty
+  TEST_ASSERT_FALSE(volume.mount(readImage, nullptr));
+}
+
+void test_listing_skips_label_long_names_and_deleted() {
+  Listing listing = {};
+  TEST_ASSERT_TRUE(volume.forEachEntry(ROOT_CLUSTER, listEntry, &listing));
+  TEST_ASSERT_EQUAL_UINT(4, listing.count);
+  TEST_ASSERT_EQUAL_STRING("01         ", listing.names[0]);
+  TEST_ASSERT_EQUAL_STRING("README  TXT", listing.names[1]);
+  TEST_ASSERT_EQUAL_STRING("02         ", listing.names[2]);
+  TEST_ASSERT_EQUAL_STRING("ABC        ", listing.names[3]);
+}
+
+void test_listing_follows_directory_chain() {
+  Listing listing = {};
+  TEST_ASSERT_TRUE(volume.forEachEntry(FOLDER_01_CLUSTER, listEntry, &listing));
+  TEST_ASSERT_EQUAL_UINT(7, listing.count);
+  TEST_ASSERT_EQUAL_STRING("003SONG WAV", listing.names[6]);
+}
+
+void test_listing_stops_at_end_marker() {
+  // Nothing after the root's last entry is read, not even the FAT
+  setFat(ROOT_CLUSTER, 60);
+  putEntry(60, 0, "99         ", FAT_ATTR_DIRECTORY, 61, 0);
+  TEST_ASSERT_TRUE(volume.mount(readImage, nullptr));
+  Listing listing = {};
+  sectorReads = 0;
+  TEST_ASSERT_TRUE(volume.forEachEntry(ROOT_CLUSTER, listEntry, &listing));
+  TEST_ASSERT_EQUAL_UINT(4, listing.count);
+  TEST_ASSERT_EQUAL_UINT(1, sectorReads);
+}
+
+void test_file_reads_fragmented_chain() {
+  FatFile file;
+  file.open(volume, SONG_CHAIN[0], SONG_SIZE);
+  uint8_t data[SONG_SIZE + 10];
+  size_t total = 0;
+  size_t n;
+  // Odd-sized reads, so most straddle a cluster boundary
+  while ((n = file.read(data + total, 100)) > 0) total += n;
+  TEST_ASSERT_EQUAL_UINT(SONG_SIZE, total);
+  TEST_ASSERT_EQUAL_UINT32(SONG_SIZE, file.position());
+  for (uint32_t i = 0; i < SONG_SIZE; i++) {
+    if (data[i] != songByte(i)) TEST_FAIL_MESSAGE("wrong byte");
+  }
+}
+
+void test_file_backward_seek_restarts_chain() {
+  FatFile file;
+  file.open(volume, SONG_CHAIN[0], SONG_SIZE);
+  uint8_t data[64];
+  TEST_ASSERT_TRUE(file.seek(SONG_SIZE - 40));
+  TEST_ASSERT_EQUAL_UINT(40, file.read(data, sizeof(data)));
+  TEST_ASSERT_EQUAL_UINT8(songByte(SONG_SIZE - 40), data[0]);
+
+  // Back into the first cluster, then forward into the third
+  TEST_ASSERT_TRUE(file.seek(100));
+  TEST_ASSERT_EQUAL_UINT(sizeof(data), file.read(data, sizeof(data)));
+  for (uint8_t i = 0; i < sizeof(data); i++) TEST_ASSERT_EQUAL_UINT8(songByte(100 + i), data[i]);
+  TEST_ASSERT_TRUE(file.seek(2 * FAT_SECTOR_SIZE + 5));
+  TEST_ASSERT_EQUAL_UINT(sizeof(data), file.read(data, sizeof(data)));
+  for (uint8_t i = 0; i < sizeof(data); i++) TEST_ASSERT_EQUAL_UINT8(songByte(2 * FAT_SECTOR_SIZE + 5 + i), data[i]);
+
+  TEST_ASSERT_FALSE(file.seek(SONG_SIZE + 1));
+}
+
+void test_file_read_stops_at_broken_chain() {
+  setFat(SONG_CHAIN[1], 0);  // free cluster in the middle of the chain
+  FatFile file;
+  file.open(volume, SONG_CHAIN[0], SONG_SIZE);
+  uint8_t data[SONG_SIZE];
+  TEST_ASSERT_EQUAL_UINT(2 * FAT_SECTOR_SIZE, file.read(data, sizeof(data)));
+}
+
+void test_scan_finds_tracks_in_order() {
+  Tracks tracks = {};
+  uint32_t checksum;
+  TEST_ASSERT_TRUE(scanTrackFolders(volume, collectTrack, &tracks, checksum));
+  TEST_ASSERT_EQUAL_UINT(4, tracks.count);
+  const TrackLocation expected[] = {
+      {1, 1, SONG_CHAIN[0], SONG_SIZE},  // the first of the two 001 files
+      {1, 2, TRACK_2_CLUSTER, 700},
+      {1, 3, TRACK_3_CLUSTER, 800},
+      {2, 5, TRACK_5_CLUSTER, 900},
+  };
+  for (uint8_t i = 0; i < 4; i++) assertTrack(expected[i], tracks.found[i]);
+}
+
+void test_checksum_follows_directories_not_data() {
+  uint32_t original = checksumOf();
+  clusterData(SONG_CHAIN[2])[7] ^= 0xFF;
+  TEST_ASSERT_EQUAL_HEX32(original, checksumOf());
+
+  dirSlot(FOLDER_01_NEXT_CLUSTER, TRACK_3_SLOT)[3] = 'X';  // renamed
+  TEST_ASSERT_NOT_EQUAL(original, checksumOf());
+  dirSlot(FOLDER_01_NEXT_CLUSTER, TRACK_3_SLOT)[3] = 'S';
+  TEST_ASSERT_EQUAL_HEX32(original, checksumOf());
+
+  put32(dirSlot(FOLDER_02_CLUSTER, 0) + 28, 901);  // rewritten
+  TEST_ASSERT_NOT_EQUAL(original, checksumOf());
+  put32(dirSlot(FOLDER_02_CLUSTER, 0) + 28, 900);
+
+  putEntry(FOLDER_02_CLUSTER, 1, "006NEW  MP3", 0x20, 44, 10);  // copied in
+  TEST_ASSERT_NOT_EQUAL(original, checksumOf());
+}
+
+void test_sliced_scan_matches_full_scan() {
+  Tracks whole = {};
+  uint32_t checksum;
+  TEST_ASSERT_TRUE(scanTrackFolders(volume, collectTrack, &whole, checksum));
+
+  Tracks sliced = {};
+  trackScanBegin(volume, collectTrack, &sliced);
+  unsigned steps = 0;
+  sectorReads = 0;
+  TrackScanStatus status;
+  do {
+    unsigned before = sectorReads;
+    status = trackScanStep(1);
+    steps++;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT(2, sectorReads - before);  // one directory sector, maybe one FAT sector
+  } while (status == TRACK_SCAN_RUNNING);
+  TEST_ASSERT_EQUAL(TRACK_SCAN_DONE, status);
+  TEST_ASSERT_EQUAL_UINT(4, steps);  // root, 01 twice, 02
+  TEST_ASSERT_EQUAL_HEX32(checksum, trackScanChecksum());
+  TEST_ASSERT_EQUAL_UINT(whole.count, sliced.count);
+  for (uint8_t i = 0; i < whole.count; i++) assertTrack(whole.found[i], sliced.found[i]);
+}
+
+void test_scan_reports_read_error() {
+  failingSector = DATA_START + FOLDER_01_NEXT_CLUSTER - 2;
+  uint32_t checksum;
+  TEST_ASSERT_FALSE(scanTrackFolders(volume, nullptr, nullptr, checksum));
+  trackScanBegin(volume, nullptr, nullptr);
+  TrackScanStatus status;
+  do status = trackScanStep(1);
+  while (status == TRACK_SCAN_RUNNING);
+  TEST_ASSERT_EQUAL(TRACK_SCAN_FAILED, status);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mount_reads_boot_sector);
+  RUN_TEST(test_mount_rejects_fat16);
+  RUN_TEST(test_listing_skips_label_long_names_and_deleted);
+  RUN_TEST(test_listing_follows_directory_chain);
+  RUN_TEST(test_listing_stops_at_end_marker);
+  RUN_TEST(test_file_reads_fragmented_chain);
+  RUN_TEST(test_file_backward_seek_restarts_chain);
+  RUN_TEST(test_file_read_stops_at_broken_chain);
+  RUN_TEST(test_scan_finds_tracks_in_order);
+  RUN_TEST(test_checksum_follows_directories_not_data);
+  RUN_TEST(test_sliced_scan_matches_full_scan);
+  RUN_TEST(test_scan_reports_read_error);
+  return UNITY_END();
+}
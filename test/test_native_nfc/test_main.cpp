@@ -0,0 +1,248 @@
+// Host tests of the NFC path: the unmodified Adafruit PN532 driver,
+// pn532_ext, nfc_reader and tag_writer run against an emulated PN532 on a
+// fake Wire bus, under a virtual clock (lib/HostArduino, lib/Pn532Emulator):
+//   pio test -e native
+// Timing tests print the same TIMING lines as test_hardware, in emulated
+// microseconds: driver polling, I2C transfer time and the PN532 latencies
+// set below, with nothing from the PC they run on.
+#include <Arduino.h>
+#include <Pn532Emulator.h>
+#include <Preferences.h>
+#include <Wire.h>
+#include <unity.h>
+#include "board_config.h"
+#include "nfc_reader.h"
+#include "pn532_ext.h"
+#include "tag_library.h"
+#include "tag_writer.h"
+#include "timers.h"
+
+// Same budgets as test_hardware
+const unsigned long UID_POLL_LIMIT_US = 30000;
+const unsigned long PAGE_READ_LIMIT_US = 10000;
+const unsigned long ARRIVAL_READ_LIMIT_US = 15000;
+
+class EmulatedPn532 : public HostI2cDevice {
+ public:
+  Pn532Emulator chip;
+  void i2cWrite(const uint8_t* data, size_t length) override { chip.write(data, length, micros()); }
+  void i2cRead(uint8_t* data, size_t length) override { chip.read(data, length, micros()); }
+};
+
+static EmulatedPn532 pn532;
+
+static int pn532Irq(void*) { return pn532.chip.frameReady(micros()) ? LOW : HIGH; }
+
+static const uint8_t TAG_UID[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x80};
+
+static void reportTiming(const char* name, unsigned long maxMicros, unsigned long limitMicros) {
+  char line[96];
+  snprintf(line, sizeof(line), "TIMING %s max_us=%lu limit_us=%lu", name, maxMicros, limitMicros);
+  Serial.println(line);
+}
+
+// A tag whose UID differs per test, so the reader sees a new arrival
+static void placeSongTag(uint8_t uidTail, uint8_t track) {
+  uint8_t uid[7];
+  memcpy(uid, TAG_UID, sizeof(uid));
+  uid[6] = uidTail;
+  pn532.chip.placeTag(uid, sizeof(uid));
+  uint8_t pages[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+  memset(pages, 0, sizeof(pages));
+  encodeTagRecord(songRecord(track), pages);
+  for (uint8_t i = 0; i < TAG_RECORD_PAGES; i++) memcpy(pn532.chip.page(TAG_RECORD_PAGE + i), pages + i * 4, 4);
+}
+
+// What the console does before reading or writing: select the tag
+static void activateTag() {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  TEST_ASSERT_TRUE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100));
+}
+
+static bool nextEvent(TagEvent& event) {
+  hostAdvanceMicros(NFC_CHECK_INTERVAL * 1000UL);
+  return nfcNextEvent(event);
+}
+
+// Every test starts with an empty field and a reader that has noticed it
+void setUp() {
+  pn532.chip.removeTarget();
+  TagEvent event;
+  nextEvent(event);
+  hostAdvanceMicros(2 * NFC_NEGATIVE_CACHE_HOLD * 1000UL);
+  pn532.chip.stats = Pn532EmulatorStats();
+}
+
+void tearDown() {}
+
+void test_firmware_version() { TEST_ASSERT_EQUAL_HEX32(PN532_EMULATOR_FIRMWARE, nfc.getFirmwareVersion()); }
+
+void test_initialize_configures_sam() {
+  if (!nfc.getFirmwareVersion()) TEST_FAIL_MESSAGE("PN532 not found");
+  initializeNFC();
+  TEST_ASSERT_TRUE(pn532.chip.samConfigured());
+  TEST_ASSERT_EQUAL_UINT32(0, pn532.chip.stats.badFrames);
+}
+
+void test_empty_field() {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  TEST_ASSERT_FALSE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100));
+  TagEvent event;
+  TEST_ASSERT_FALSE(nextEvent(event));
+}
+
+void test_arrival_reads_record_once() {
+  placeSongTag(0x01, 12);
+  TagEvent event;
+  TEST_ASSERT_TRUE(nextEvent(event));
+  TEST_ASSERT_EQUAL(TAG_EVENT_ARRIVED, event.type);
+  TEST_ASSERT_EQUAL(TAG_READ_OK, event.readStatus);
+  TEST_ASSERT_EQUAL_UINT8(12, event.record.track);
+  TEST_ASSERT_EQUAL_UINT8(7, event.uidLength);
+  TEST_ASSERT_EQUAL_UINT32(1, pn532.chip.stats.pageReads);  // one FAST_READ
+
+  TEST_ASSERT_FALSE(nextEvent(event));  // still there, nothing new
+  TEST_ASSERT_EQUAL_UINT32(1, pn532.chip.stats.pageReads);
+  pn532.chip.removeTarget();
+  TEST_ASSERT_TRUE(nextEvent(event));
+  TEST_ASSERT_EQUAL(TAG_EVENT_REMOVED, event.type);
+}
+
+void test_foreign_card_not_read() {
+  const uint8_t bankCard[4] = {0x8A, 0x21, 0x5C, 0x0F};
+  pn532.chip.placeCard(bankCard, sizeof(bankCard), 0x0004, 0x20);
+  TagEvent event;
+  TEST_ASSERT_TRUE(nextEvent(event));
+  TEST_ASSERT_EQUAL(TAG_READ_IGNORED, event.readStatus);
+  TEST_ASSERT_EQUAL_UINT32(0, pn532.chip.stats.exchanges);
+}
+
+void test_read_failure_reported() {
+  placeSongTag(0x02, 3);
+  pn532.chip.dropExchanges(1);
+  TagEvent event;
+  TEST_ASSERT_TRUE(nextEvent(event));
+  TEST_ASSERT_EQUAL(TAG_READ_FAILED, event.readStatus);
+}
+
+void test_write_record_slot() {
+  placeSongTag(0x03, 5);
+  nfcAcquire();
+  activateTag();
+  TagWriteResult result = writeRecordSlot(songRecord(7));
+  nfcRelease();
+  TEST_ASSERT_TRUE(result.ok);
+  TEST_ASSERT_TRUE(result.verified);
+  TEST_ASSERT_EQUAL_UINT32(2, pn532.chip.stats.pageWrites);  // one slot
+
+  uint8_t pages[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+  for (uint8_t i = 0; i < TAG_RECORD_PAGES; i++) memcpy(pages + i * 4, pn532.chip.page(TAG_RECORD_PAGE + i), 4);
+  TagRecord record;
+  TEST_ASSERT_TRUE(parseTagRecord(pages, record));
+  TEST_ASSERT_EQUAL_UINT8(7, record.track);
+}
+
+// A write into slot B that stops after its first page, over every preset
+// the older record could have left in the second one: the slot's CRC has
+// to reject the mix, or the half-written record would win as the newest.
+void test_torn_slot_write_keeps_previous_record() {
+  uint16_t accepted = 0;
+  for (uint16_t oldVolume = 0; oldVolume <= 30; oldVolume++) {
+    for (uint8_t track = 1; track <= 99; track++) {
+      uint8_t pages[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+      memset(pages, 0, sizeof(pages));
+      encodeTagRecord(songRecord(1, oldVolume), pages);  // slot B, sequence 1
+      encodeTagRecord(songRecord(2), pages);             // slot A, sequence 2
+      uint8_t torn[sizeof(pages)];
+      memcpy(torn, pages, sizeof(pages));
+      TEST_ASSERT_EQUAL_UINT8(1, encodeTagRecord(songRecord(track, 20), torn));
+      memcpy(pages + 2 * TAG_PAGE_SIZE, torn + 2 * TAG_PAGE_SIZE, TAG_PAGE_SIZE);  // page 6 only
+      TagRecord record;
+      TEST_ASSERT_TRUE(parseTagRecord(pages, record));
+      if (record.track != 2) accepted++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, accepted);
+}
+
+void test_uid_poll_time() {
+  placeSongTag(0x04, 1);
+  unsigned long start = micros();
+  uint8_t uid[7];
+  uint8_t uidLength;
+  TEST_ASSERT_TRUE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 100));
+  unsigned long elapsed = micros() - start;
+  reportTiming("uid_poll", elapsed, UID_POLL_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(UID_POLL_LIMIT_US, elapsed);
+}
+
+void test_page_read_time() {
+  placeSongTag(0x05, 1);
+  activateTag();
+  uint8_t data[NTAG_READ_SIZE];
+  unsigned long start = micros();
+  TEST_ASSERT_TRUE(pn532ReadPages(nfc, TAG_RECORD_PAGE, data));
+  unsigned long elapsed = micros() - start;
+  reportTiming("page_read", elapsed, PAGE_READ_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(PAGE_READ_LIMIT_US, elapsed);
+}
+
+void test_arrival_read_time() {
+  placeSongTag(0x06, 1);
+  activateTag();
+  TagRecord record;
+  unsigned long start = micros();
+  TEST_ASSERT_EQUAL(TAG_READ_OK, readTagRecord(record));
+  unsigned long elapsed = micros() - start;
+  reportTiming("arrival_read", elapsed, ARRIVAL_READ_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(ARRIVAL_READ_LIMIT_US, elapsed);
+}
+
+// The driver checks for the ACK once, then every 10 ms: an ACK that misses
+// the first check costs a whole poll period on every command.
+void test_slow_ack_costs_a_poll_period() {
+  placeSongTag(0x07, 1);
+  activateTag();
+  uint8_t data[NTAG_READ_SIZE];
+  unsigned long start = micros();
+  TEST_ASSERT_TRUE(pn532ReadPages(nfc, TAG_RECORD_PAGE, data));
+  unsigned long fast = micros() - start;
+  pn532.chip.latencies.ackMicros = 2000;
+  start = micros();
+  bool ok = pn532ReadPages(nfc, TAG_RECORD_PAGE, data);
+  unsigned long slow = micros() - start;
+  pn532.chip.latencies = Pn532Latencies();
+  TEST_ASSERT_TRUE(ok);
+  TEST_ASSERT_LESS_THAN_UINT32(10000, fast);
+  TEST_ASSERT_GREATER_THAN_UINT32(10000, slow);
+}
+
+int main() {
+  Wire.attach(PN532_EMULATOR_ADDRESS, &pn532);
+  // nfc_reader hands the driver SDA_PIN as its IRQ pin. Driver versions that
+  // wait on IRQ rather than the status byte find the emulated line there.
+  hostDrivePin(SDA_PIN, pn532Irq, nullptr);
+  hostErasePreferences();
+  timersBegin();
+  Wire.begin(SDA_PIN, SCL_PIN);
+  nfc.begin();
+  tagLibraryBegin();
+  nfcBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_firmware_version);
+  RUN_TEST(test_initialize_configures_sam);
+  RUN_TEST(test_empty_field);
+  RUN_TEST(test_arrival_reads_record_once);
+  RUN_TEST(test_foreign_card_not_read);
+  RUN_TEST(test_read_failure_reported);
+  RUN_TEST(test_write_record_slot);
+  RUN_TEST(test_torn_slot_write_keeps_previous_record);
+  RUN_TEST(test_uid_poll_time);
+  RUN_TEST(test_page_read_time);
+  RUN_TEST(test_arrival_read_time);
+  RUN_TEST(test_slow_ack_costs_a_poll_period);
+  return UNITY_END();
+}
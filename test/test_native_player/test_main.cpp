@@ -0,0 +1,379 @@
+// End-to-end host tests of the play path: the firmware's own setup() and
+// loop() run against an emulated PN532 and DFPlayer (lib/Pn532Emulator,
+// lib/DFPlayerEmulator) under the virtual clock:
+//   pio test -e native
+// Tag-to-sound runs from the moment a tag lands on the reader to the first
+// sample the DFPlayer plays: the poll phase, the tag read, the frames on
+// the 9600 baud line and the module's processing and SD seek, with the
+// DFPlayer latencies set in DFPlayerEmulator.h. The emulated module also
+// drives the BUSY line, so the firmware's own wake-to-audio figure is
+// measured the way it is on a box.
+#include <Arduino.h>
+#include <DFPlayerEmulator.h>
+#include <DFPlayerFrame.h>
+#include <Pn532Emulator.h>
+#include <Preferences.h>
+#include <TagRecord.h>
+#include <Wire.h>
+#include <unity.h>
+#include "audio_power.h"
+#include "board_config.h"
+#include "energy.h"
+#include "nfc_reader.h"
+#include "stats.h"
+#include "tag_library.h"
+
+void setup();
+void loop();
+extern HardwareSerial dfPlayerSerial;
+
+const unsigned long TAG_TO_SOUND_LIMIT_US = 400000;
+const unsigned long WAKE_TAG_TO_SOUND_LIMIT_US = 700000;
+const uint16_t TEST_IDLE_TIMEOUT = 5;  // seconds
+const unsigned long GRACE_PERIOD_US = 2000000;  // TAG_GRACE_PERIOD in main.cpp
+const uint8_t ARRIVALS = 8;
+const uint8_t PLAYLIST_FOLDER = 2;
+
+class EmulatedPn532 : public HostI2cDevice {
+ public:
+  Pn532Emulator chip;
+  void i2cWrite(const uint8_t* data, size_t length) override { chip.write(data, length, micros()); }
+  void i2cRead(uint8_t* data, size_t length) override { chip.read(data, length, micros()); }
+};
+
+class EmulatedDFPlayer : public HostSerialDevice {
+ public:
+  DFPlayerEmulator module;
+  void serialReceive(uint8_t c, uint32_t at) override { module.receive(c, at); }
+  int serialSend(uint32_t now) override { return module.send(now); }
+};
+
+static EmulatedPn532 pn532;
+static EmulatedDFPlayer dfPlayerModule;
+static DFPlayerEmulator& player = dfPlayerModule.module;
+
+static int pn532Irq(void*) { return pn532.chip.frameReady(micros()) ? LOW : HIGH; }
+
+static int dfPlayerBusy(void*) { return player.playing(micros()) ? LOW : HIGH; }
+
+static const uint8_t TAG_UID[7] = {0x04, 0x51, 0x62, 0x73, 0x84, 0x95, 0x00};
+
+static void reportTiming(const char* name, unsigned long maxMicros, unsigned long limitMicros) {
+  char line[96];
+  snprintf(line, sizeof(line), "TIMING %s max_us=%lu limit_us=%lu", name, maxMicros, limitMicros);
+  Serial.println(line);
+}
+
+static void placeSongTag(uint8_t uidTail, const TagRecord& record) {
+  uint8_t uid[7];
+  memcpy(uid, TAG_UID, sizeof(uid));
+  uid[6] = uidTail;
+  pn532.chip.placeTag(uid, sizeof(uid));
+  uint8_t pages[TAG_RECORD_PAGES * TAG_PAGE_SIZE];
+  memset(pages, 0, sizeof(pages));
+  encodeTagRecord(record, pages);
+  for (uint8_t i = 0; i < TAG_RECORD_PAGES; i++) memcpy(pn532.chip.page(TAG_RECORD_PAGE + i), pages + i * 4, 4);
+}
+
+static void runFor(unsigned long us) {
+  unsigned long start = micros();
+  while (micros() - start < us) loop();
+}
+
+// Runs the firmware until the audio log holds an event of that kind,
+// returning its index, or -1 after `us`
+static int runUntilAudio(DFPlayerAudioChange change, unsigned long us) {
+  unsigned long start = micros();
+  while (micros() - start < us) {
+    loop();
+    player.playing(micros());
+    for (uint8_t i = 0; i < player.audioEvents(); i++) {
+      const DFPlayerAudioEvent& e = player.audioEvent(i);
+      if (e.change == change && (int32_t)(micros() - e.at) >= 0) return i;
+    }
+  }
+  return -1;
+}
+
+// Every test starts with an empty field, the box silent and the log empty
+void setUp() {
+  pn532.chip.removeTarget();
+  runFor(GRACE_PERIOD_US + 500000);
+  player.clearAudioLog();
+  player.stats = DFPlayerEmulatorStats();
+}
+
+void tearDown() {}
+
+void test_player_online_after_setup() {
+  TEST_ASSERT_FALSE(player.sleeping(micros()));
+  TEST_ASSERT_EQUAL_UINT8(20, player.volume());  // DEFAULT_VOLUME
+  TEST_ASSERT_EQUAL_UINT32(0, dfPlayerSerial.rxOverflows());
+}
+
+// Arrivals land at different points of the poll interval, so the worst
+// case includes a whole NFC_CHECK_INTERVAL of waiting
+void test_tag_to_sound() {
+  unsigned long worst = 0;
+  for (uint8_t i = 0; i < ARRIVALS; i++) {
+    runFor(i * NFC_CHECK_INTERVAL * 1000UL / ARRIVALS + 1000);
+    player.clearAudioLog();
+    placeSongTag(0x10 + i, songRecord(1 + i));
+    unsigned long placedAt = micros();
+    int started = runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000);
+    TEST_ASSERT_TRUE_MESSAGE(started >= 0, "no audio");
+    const DFPlayerAudioEvent& e = player.audioEvent(started);
+    TEST_ASSERT_EQUAL_UINT16(1 + i, e.track);
+    worst = max(worst, (unsigned long)(e.at - placedAt));
+    pn532.chip.removeTarget();
+    runFor(GRACE_PERIOD_US + 500000);
+  }
+  reportTiming("tag_to_sound", worst, TAG_TO_SOUND_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(TAG_TO_SOUND_LIMIT_US, worst);
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.droppedFrames);
+}
+
+// Volume, EQ and play arrive back to back; none may be lost in the
+// module's input FIFO
+void test_preset_burst_reaches_player() {
+  placeSongTag(0x20, songRecord(4, 12, 3));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  TEST_ASSERT_EQUAL_UINT8(12, player.volume());
+  TEST_ASSERT_EQUAL_UINT8(3, player.eq());
+  TEST_ASSERT_EQUAL_UINT32(3, player.stats.frames);
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.droppedFrames);
+}
+
+void test_removal_stops_after_grace_period() {
+  placeSongTag(0x21, songRecord(5));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  pn532.chip.removeTarget();
+  unsigned long removedAt = micros();
+  int stopped = runUntilAudio(DFPLAYER_AUDIO_STOPPED, GRACE_PERIOD_US + 1000000);
+  TEST_ASSERT_TRUE_MESSAGE(stopped >= 0, "still playing");
+  unsigned long elapsed = player.audioEvent(stopped).at - removedAt;
+  reportTiming("removal_to_silence", elapsed, GRACE_PERIOD_US + NFC_CHECK_INTERVAL * 1000UL);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(GRACE_PERIOD_US - NFC_CHECK_INTERVAL * 1000UL, elapsed);
+  TEST_ASSERT_LESS_THAN_UINT32(GRACE_PERIOD_US + NFC_CHECK_INTERVAL * 1000UL, elapsed);
+}
+
+// A bank card swapped in for the figure within one poll: the figure's
+// removal is never reported, the grace period must still end the music
+void test_song_tag_replaced_by_foreign_card() {
+  static const uint8_t bankCard[4] = {0xB1, 0xB2, 0xB3, 0xB4};
+  placeSongTag(0x22, songRecord(5));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  pn532.chip.placeCard(bankCard, sizeof(bankCard), 0x0004, 0x20);
+  runFor(1000000);
+  TEST_ASSERT_TRUE(player.playing(micros()));  // the grace period covers the swap
+  pn532.chip.removeTarget();
+  TEST_ASSERT_TRUE_MESSAGE(runUntilAudio(DFPLAYER_AUDIO_STOPPED, GRACE_PERIOD_US) >= 0, "still playing");
+}
+
+// A control tag left in the figure's place acts, then lets the music end
+void test_control_tag_left_on_reader() {
+  placeSongTag(0x23, songRecord(5));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  placeSongTag(0x24, controlRecord(CONTROL_SET_VOLUME, 15));
+  int stopped = runUntilAudio(DFPLAYER_AUDIO_STOPPED, GRACE_PERIOD_US + NFC_CHECK_INTERVAL * 2000UL);
+  TEST_ASSERT_TRUE_MESSAGE(stopped >= 0, "still playing");
+  TEST_ASSERT_TRUE(pn532.chip.targetPresent());
+  TEST_ASSERT_EQUAL_UINT8(15, player.volume());
+}
+
+// Each NFC tick polls the reader once, tag changes included, and records
+// how late it started
+void test_one_poll_per_nfc_tick() {
+  uint32_t latenessBefore = stats.pollLatenessMicros.count();
+  Pn532EmulatorStats before = pn532.chip.stats;
+  placeSongTag(0x25, songRecord(5));
+  runFor(1000000);
+  pn532.chip.removeTarget();
+  runFor(1000000);
+  uint32_t polls = (pn532.chip.stats.commands - before.commands) - (pn532.chip.stats.exchanges - before.exchanges);
+  uint32_t ticks = stats.pollLatenessMicros.count() - latenessBefore;
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2000 / NFC_CHECK_INTERVAL - 1, ticks);
+  TEST_ASSERT_EQUAL_UINT32(ticks, polls);
+}
+
+// The playlist moves on at each "play finished" (sent twice, played once)
+// and wraps when the next file is missing
+void test_playlist_advances_and_wraps() {
+  uint8_t uid[7];
+  memcpy(uid, TAG_UID, sizeof(uid));
+  uid[6] = 0x30;
+  TEST_ASSERT_TRUE(tagLibraryAssign(uid, sizeof(uid), 0, PLAYLIST_FOLDER));
+  player.latencies.trackMicros = 3000000;
+  placeSongTag(0x30, songRecord(1));
+  runFor(3 * 3000000 + 2000000);
+  player.latencies = DFPlayerLatencies();
+
+  const uint16_t expected[] = {1, 2, 1, 2};
+  uint8_t starts = 0;
+  for (uint8_t i = 0; i < player.audioEvents() && starts < 4; i++) {
+    const DFPlayerAudioEvent& e = player.audioEvent(i);
+    if (e.change != DFPLAYER_AUDIO_STARTED) continue;
+    TEST_ASSERT_EQUAL_UINT8(PLAYLIST_FOLDER, e.folder);
+    TEST_ASSERT_EQUAL_UINT16(expected[starts], e.track);
+    starts++;
+  }
+  TEST_ASSERT_EQUAL_UINT8(4, starts);
+  TEST_ASSERT_EQUAL_UINT32(1, player.stats.errors);  // track 3 is missing, once
+}
+
+// Plays a tag, takes it away and waits out the idle timeout
+static void playThenSleep(uint8_t uidTail) {
+  player.clearAudioLog();
+  placeSongTag(uidTail, songRecord(6));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  pn532.chip.removeTarget();
+  runFor(GRACE_PERIOD_US + TEST_IDLE_TIMEOUT * 1000000UL + 500000);
+}
+
+void test_idle_puts_audio_chain_to_sleep() {
+  audioPowerSetIdleTimeout(TEST_IDLE_TIMEOUT);
+  playThenSleep(0x40);
+  TEST_ASSERT_TRUE(player.sleeping(micros()));
+  TEST_ASSERT_TRUE(audioPowerAsleep());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(AMP_SHUTDOWN_PIN));
+
+  // 36 s asleep instead of idle: 36 s × (20 - 10) mA = 0.1 mAh
+  energyReset();
+  runFor(36000000);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.1f, energySavedMilliampHours(POWER_AUDIO_SLEEP, POWER_AUDIO_IDLE));
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.errors);  // nothing was sent to the sleeping module
+}
+
+// Sleeping turned back on while the box sits silent counts from then
+void test_idle_timeout_enabled_while_idle() {
+  audioPowerSetIdleTimeout(0);
+  placeSongTag(0x45, songRecord(6));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  pn532.chip.removeTarget();
+  runFor(GRACE_PERIOD_US + TEST_IDLE_TIMEOUT * 1000000UL + 500000);
+  TEST_ASSERT_FALSE(audioPowerAsleep());
+  audioPowerSetIdleTimeout(TEST_IDLE_TIMEOUT);
+  runFor(TEST_IDLE_TIMEOUT * 1000000UL + 500000);
+  TEST_ASSERT_TRUE(audioPowerAsleep());
+  TEST_ASSERT_TRUE(player.sleeping(micros()));
+}
+
+// The wake frame leads the play burst; the module takes it from its FIFO
+// and plays without the firmware waiting for anything
+void test_tag_wakes_audio_chain() {
+  audioPowerSetIdleTimeout(TEST_IDLE_TIMEOUT);
+  playThenSleep(0x41);
+  TEST_ASSERT_TRUE(audioPowerAsleep());
+  player.clearAudioLog();
+  player.stats = DFPlayerEmulatorStats();
+  uint32_t wakesBefore = audioPowerStats.wakeToAudioMicros.count();
+
+  placeSongTag(0x42, songRecord(7));
+  unsigned long placedAt = micros();
+  int started = runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000);
+  TEST_ASSERT_TRUE_MESSAGE(started >= 0, "no audio after wake");
+  unsigned long elapsed = player.audioEvent(started).at - placedAt;
+  reportTiming("wake_tag_to_sound", elapsed, WAKE_TAG_TO_SOUND_LIMIT_US);
+  TEST_ASSERT_LESS_THAN_UINT32(WAKE_TAG_TO_SOUND_LIMIT_US, elapsed);
+  TEST_ASSERT_FALSE(player.sleeping(micros()));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(AMP_SHUTDOWN_PIN));
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.errors);
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.droppedFrames);
+
+  runFor(100000);  // BUSY is sampled on the service tick
+  TEST_ASSERT_EQUAL_UINT32(wakesBefore + 1, audioPowerStats.wakeToAudioMicros.count());
+  reportTiming("wake_to_audio", audioPowerStats.wakeToAudioMicros.maxValue(), WAKE_TAG_TO_SOUND_LIMIT_US);
+}
+
+// A volume button pressed while the module sleeps cannot reach it; the
+// wake burst carries the new volume
+void test_volume_change_while_asleep() {
+  audioPowerSetIdleTimeout(TEST_IDLE_TIMEOUT);
+  playThenSleep(0x43);
+  uint8_t before = player.volume();
+  hostSetPin(VOLUME_UP_PIN, LOW);
+  runFor(50000);
+  hostSetPin(VOLUME_UP_PIN, HIGH);
+  runFor(50000);
+  TEST_ASSERT_EQUAL_UINT32(0, player.stats.errors);
+
+  player.clearAudioLog();
+  placeSongTag(0x44, songRecord(8));
+  TEST_ASSERT_TRUE(runUntilAudio(DFPLAYER_AUDIO_STARTED, 2000000) >= 0);
+  TEST_ASSERT_EQUAL_UINT8(before + 1, player.volume());
+}
+
+// The two ways out of sleep, on a bare module: select the SD card with
+// the play burst right behind it, or reset, wait for "card online" and
+// send volume and play again. The firmware uses the first.
+static uint32_t sendFrames(DFPlayerEmulator& module, const uint8_t* frames, uint8_t count, uint32_t at) {
+  for (uint16_t i = 0; i < count * DFPLAYER_FRAME_SIZE; i++) {
+    at += DFPLAYER_EMULATOR_CHARACTER_MICROS;
+    module.receive(frames[i], at);
+  }
+  return at;
+}
+
+static uint32_t wakeToSound(bool reset) {
+  DFPlayerEmulator module;
+  module.setTrackCount(0, 1);
+  uint8_t frames[3 * DFPLAYER_FRAME_SIZE];
+  encodeDFPlayerFrame(0x0A, 0, false, frames);  // sleep
+  uint32_t at = sendFrames(module, frames, 1, 0) + 1000000;
+  uint32_t wakeAt = at;
+  if (reset) {
+    encodeDFPlayerFrame(0x0C, 0, false, frames);
+    at = sendFrames(module, frames, 1, at);
+    // 10 bytes of "card online"
+    for (uint8_t received = 0; received < DFPLAYER_FRAME_SIZE; at += 1000) {
+      if (module.send(at) >= 0) received++;
+    }
+    encodeDFPlayerFrame(DFPLAYER_CMD_VOLUME, 20, false, frames);
+    encodeDFPlayerFrame(DFPLAYER_CMD_PLAY, 1, false, frames + DFPLAYER_FRAME_SIZE);
+    sendFrames(module, frames, 2, at);
+  } else {
+    encodeDFPlayerFrame(0x09, 0x02, false, frames);  // output device: SD
+    encodeDFPlayerFrame(DFPLAYER_CMD_PLAY, 1, false, frames + DFPLAYER_FRAME_SIZE);
+    sendFrames(module, frames, 2, at);
+  }
+  module.playing(wakeAt + 5000000);
+  for (uint8_t i = 0; i < module.audioEvents(); i++) {
+    if (module.audioEvent(i).change == DFPLAYER_AUDIO_STARTED) return module.audioEvent(i).at - wakeAt;
+  }
+  return UINT32_MAX;
+}
+
+void test_wake_sequences() {
+  uint32_t selectCard = wakeToSound(false);
+  uint32_t reset = wakeToSound(true);
+  // The limit is what the reset costs
+  reportTiming("wake_select_sd", selectCard, reset);
+  TEST_ASSERT_LESS_THAN_UINT32(reset, selectCard);
+}
+
+int main() {
+  Wire.attach(PN532_EMULATOR_ADDRESS, &pn532);
+  hostDrivePin(SDA_PIN, pn532Irq, nullptr);
+  hostDrivePin(DFPLAYER_BUSY_PIN, dfPlayerBusy, nullptr);
+  dfPlayerSerial.attach(&dfPlayerModule);
+  player.setTrackCount(0, 20);
+  player.setTrackCount(PLAYLIST_FOLDER, 2);
+  hostErasePreferences();
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_player_online_after_setup);
+  RUN_TEST(test_tag_to_sound);
+  RUN_TEST(test_preset_burst_reaches_player);
+  RUN_TEST(test_removal_stops_after_grace_period);
+  RUN_TEST(test_song_tag_replaced_by_foreign_card);
+  RUN_TEST(test_control_tag_left_on_reader);
+  RUN_TEST(test_one_poll_per_nfc_tick);
+  RUN_TEST(test_playlist_advances_and_wraps);
+  RUN_TEST(test_idle_puts_audio_chain_to_sleep);
+  RUN_TEST(test_idle_timeout_enabled_while_idle);
+  RUN_TEST(test_tag_wakes_audio_chain);
+  RUN_TEST(test_volume_change_while_asleep);
+  RUN_TEST(test_wake_sequences);
+  return UNITY_END();
+}
@@ -0,0 +1,78 @@
+// Host tests of the web UI's HTTP server: web_ui.cpp runs against the
+// in-memory sockets of lib/HostArduino (lwip/sockets.h), with
+// ENABLE_WEB_UI set by its env:
+//   pio test -e native-webui
+// A test connects with a complete request, runs webUiLoop() until the
+// server closes the connection and checks what came back.
+#include <Arduino.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include <unity.h>
+#include <string>
+#include "tag_library.h"
+#include "timers.h"
+#include "web_ui.h"
+#include "web_ui_page.h"
+
+const uint16_t MAX_LOOP_PASSES = 1000;
+
+static std::string request(const char* text) {
+  int connection = hostSocketConnect(text);
+  for (uint16_t i = 0; i < MAX_LOOP_PASSES && !hostSocketClosed(connection); i++) webUiLoop();
+  TEST_ASSERT_TRUE_MESSAGE(hostSocketClosed(connection), "response never finished");
+  return hostSocketReceived(connection);
+}
+
+static std::string body(const std::string& response) {
+  size_t end = response.find("\r\n\r\n");
+  TEST_ASSERT_TRUE_MESSAGE(end != std::string::npos, "no header");
+  return response.substr(end + 4);
+}
+
+void setUp() { hostSocketSendLimit(0); }
+
+void tearDown() {}
+
+void test_page_served_byte_for_byte() {
+  std::string response = request("GET / HTTP/1.1\r\nHost: box\r\n\r\n");
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 200 OK\r\n", response.c_str(), 17);
+  std::string page = body(response);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(INDEX_HTML) - 1, page.size());
+  TEST_ASSERT_TRUE(page == INDEX_HTML);
+}
+
+// Sends that take less than a chunk resume where they stopped
+void test_page_survives_partial_sends() {
+  hostSocketSendLimit(100);
+  std::string page = body(request("GET / HTTP/1.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL_UINT32(sizeof(INDEX_HTML) - 1, page.size());
+  TEST_ASSERT_TRUE(page == INDEX_HTML);
+}
+
+void test_tags_listed_as_json() {
+  const uint8_t uid[7] = {0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
+  TEST_ASSERT_TRUE(tagLibraryAssign(uid, sizeof(uid), 7, 0));
+  std::string json = body(request("GET /api/tags HTTP/1.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL_STRING("[{\"uid\":\"04A1B2C3D4E5F6\",\"tag\":0,\"track\":7,\"folder\":0,\"plays\":0}]\n",
+                           json.c_str());
+}
+
+void test_unknown_path_not_found() {
+  std::string response = request("GET /nope HTTP/1.1\r\n\r\n");
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 404 Not Found\r\n", response.c_str(), 24);
+  TEST_ASSERT_EQUAL_STRING("not found\n", body(response).c_str());
+}
+
+int main() {
+  hostErasePreferences();
+  timersBegin();
+  tagLibraryBegin();
+  webUiBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_page_served_byte_for_byte);
+  RUN_TEST(test_page_survives_partial_sends);
+  RUN_TEST(test_tags_listed_as_json);
+  RUN_TEST(test_unknown_path_not_found);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// audio_convert: batch-converts a music library to IMA ADPCM WAV for the
+// on-chip audio path, keeping the folder layout and track numbers.
+//
+//   g++ -std=c++17 -O2 -Ilib/AudioCodec -o audio_convert tools/audio_convert.cpp
+//       lib/AudioCodec/AudioCodec.cpp lib/AudioCodec/WavDecoder.cpp
+//       lib/AudioCodec/ImaAdpcm.cpp lib/AudioCodec/Mp3Decoder.cpp
+//   ./audio_convert [--mono] <library dir> <output dir>
+//
+// Every file any decoder in lib/AudioCodec can open is converted, so with
+// the default build that is PCM WAV. Add -DENABLE_MP3_CODEC and the Helix
+// sources (-I<libhelix>/src plus its .c files) to convert MP3s directly;
+// otherwise decode them first, e.g. `ffmpeg -i 001.mp3 001.wav`.
+// Output files keep their relative path with a .wav extension, so
+// 12/087 Lullaby.mp3 becomes 12/087 Lullaby.wav. --mono averages the
+// channels, halving the size again for speakers that are mono anyway.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <AudioCodec.h>
+#include <ImaAdpcm.h>
+#include <WavDecoder.h>
+
+namespace fs = std::filesystem;
+
+class FileSource : public AudioSource {
+ public:
+  explicit FileSource(FILE* file) : file(file) {}
+  size_t read(uint8_t* data, size_t length) override { return fread(data, 1, length, file); }
+  bool seek(uint32_t offset) override { return fseek(file, offset, SEEK_SET) == 0; }
+
+ private:
+  FILE* file;
+};
+
+static bool mono = false;
+static uint64_t bytesIn = 0;
+static uint64_t bytesOut = 0;
+
+// Fills whole ADPCM blocks from the decoder's output; the last block is
+// padded by repeating the final frame and the fact chunk has the real length.
+static bool convert(const fs::path& input, const fs::path& output) {
+  FILE* in = fopen(input.string().c_str(), "rb");
+  if (!in) return false;
+  FileSource source(in);
+  AudioCodecType codec;
+  AudioDecoder* decoder = openAudioDecoder(source, &codec);
+  if (!decoder) {
+    fclose(in);
+    printf("skip  %s (%s)\n", input.string().c_str(), codec == AUDIO_CODEC_UNKNOWN ? "not audio" : "no decoder");
+    return true;
+  }
+  fs::create_directories(output.parent_path());
+  FILE* out = fopen(output.string().c_str(), "wb");
+  if (!out) {
+    fclose(in);
+    return false;
+  }
+
+  uint8_t channels = mono ? 1 : decoder->channels();
+  uint16_t blockAlign = 512 * channels;
+  uint16_t samplesPerBlock = imaSamplesPerBlock(blockAlign, channels);
+  std::vector<uint8_t> header(WAV_IMA_HEADER_SIZE);
+  fwrite(header.data(), 1, header.size(), out);
+
+  static int16_t decoded[AUDIO_BLOCK_MAX_FRAMES * AUDIO_MAX_CHANNELS];
+  std::vector<int16_t> pending;
+  std::vector<uint8_t> block(blockAlign);
+  ImaState states[AUDIO_MAX_CHANNELS];
+  uint32_t frames = 0;
+  uint32_t dataSize = 0;
+  bool finished = false;
+  while (!finished) {
+    size_t n = decoder->decode(decoded);
+    for (size_t i = 0; i < n; i++) {
+      if (mono && decoder->channels() == 2) pending.push_back((decoded[2 * i] + decoded[2 * i + 1]) / 2);
+      else for (uint8_t c = 0; c < channels; c++) pending.push_back(decoded[i * decoder->channels() + c]);
+    }
+    frames += n;
+    finished = n == 0;
+    if (finished && !pending.empty()) {
+      while (pending.size() < (size_t)samplesPerBlock * channels) {
+        for (uint8_t c = 0; c < channels; c++) pending.push_back(pending[pending.size() - channels]);
+      }
+    }
+    size_t blockSamples = (size_t)samplesPerBlock * channels;
+    size_t used = 0;
+    while (pending.size() - used >= blockSamples) {
+      imaEncodeBlock(pending.data() + used, channels, blockAlign, states, block.data());
+      fwrite(block.data(), 1, blockAlign, out);
+      dataSize += blockAlign;
+      used += blockSamples;
+    }
+    pending.erase(pending.begin(), pending.begin() + used);
+  }
+  writeWavImaHeader(header.data(), decoder->sampleRate(), channels, blockAlign, frames, dataSize);
+  fseek(out, 0, SEEK_SET);
+  fwrite(header.data(), 1, header.size(), out);
+  fclose(out);
+  fclose(in);
+
+  uint64_t inSize = fs::file_size(input);
+  bytesIn += inSize;
+  bytesOut += WAV_IMA_HEADER_SIZE + dataSize;
+  printf("%-5s %s → %s, %.1f s, %u Hz %s\n", audioCodecName(codec), input.string().c_str(),
+         output.string().c_str(), (double)frames / decoder->sampleRate(), decoder->sampleRate(),
+         channels == 1 ? "mono" : "stereo");
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--mono") == 0) mono = true;
+    else paths.push_back(argv[i]);
+  }
+  if (paths.size() != 2 || !fs::is_directory(paths[0])) {
+    fprintf(stderr, "usage: audio_convert [--mono] <library dir> <output dir>\n");
+    return 2;
+  }
+  fs::path library = paths[0];
+  fs::path target = paths[1];
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::recursive_directory_iterator(library)) {
+    if (entry.is_regular_file()) files.push_back(entry.path());
+  }
+  std::sort(files.begin(), files.end());
+  for (const fs::path& file : files) {
+    fs::path output = target / fs::relative(file, library);
+    output.replace_extension(".wav");
+    if (!convert(file, output)) {
+      fprintf(stderr, "error: %s\n", file.string().c_str());
+      return 1;
+    }
+  }
+  if (bytesIn > 0) {
+    printf("%.1f MB in, %.1f MB out\n", bytesIn / 1e6, bytesOut / 1e6);
+  }
+  return 0;
+}
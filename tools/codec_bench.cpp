@@ -0,0 +1,57 @@
+// codec_bench: decode cost per codec, in CPU cycles per second of audio.
+//
+//   g++ -std=c++17 -O2 -Ilib/AudioCodec -o codec_bench tools/codec_bench.cpp
+//       lib/AudioCodec/AudioCodec.cpp lib/AudioCodec/WavDecoder.cpp
+//       lib/AudioCodec/ImaAdpcm.cpp lib/AudioCodec/Mp3Decoder.cpp
+//   ./codec_bench 001.mp3 001.wav 001-adpcm.wav ...
+//
+// Uses the same decoders as the firmware (build with -DENABLE_MP3_CODEC and
+// the Helix sources for MP3, as for audio_convert). Cycles are counted with
+// the x86 TSC, so absolute numbers are a desktop's; the ratios between
+// codecs carry over. The `codecs` console command measures PCM and ADPCM on
+// the board itself.
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <AudioCodec.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+// Nanoseconds: reads as cycles of a 1 GHz clock
+static uint64_t cycleCount() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: codec_bench <audio files...>\n");
+    return 2;
+  }
+  printf("%-10s %8s %9s %15s  %s\n", "codec", "rate", "audio_s", "Mcycles/audio_s", "file");
+  for (int i = 1; i < argc; i++) {
+    FILE* f = fopen(argv[i], "rb");
+    if (!f) {
+      fprintf(stderr, "cannot open %s\n", argv[i]);
+      return 1;
+    }
+    // Decoding from RAM keeps file I/O out of the measurement
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    MemorySource source(data.data(), data.size());
+    DecodeBenchmark result;
+    if (!benchmarkDecode(source, cycleCount, result)) {
+      printf("%-10s %8s %9s %15s  %s\n", audioCodecName(result.codec), "-", "-", "no decoder", argv[i]);
+      continue;
+    }
+    printf("%-10s %8u %9.1f %15.2f  %s\n", audioCodecName(result.codec), result.sampleRate,
+           (double)result.frames / result.sampleRate, result.cyclesPerAudioSecond() / 1e6, argv[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+// fft_bench: accuracy and cost of the visualiser's fixed-point FFT.
+//
+//   g++ -std=c++17 -O2 -Ilib/Spectrum -o fft_bench tools/fft_bench.cpp
+//       lib/Spectrum/Fft.cpp lib/Spectrum/Spectrum.cpp
+//   ./fft_bench [iterations]
+//
+// Compares fft256 against a double-precision DFT of the same input (tones
+// plus noise at several levels) and prints the error in LSB, then times the
+// kernel, each stage and each Spectrum step. Cycles are counted with the x86
+// TSC as in codec_bench, so they are a desktop's; what carries over to the
+// board is that no single step costs much more than a quarter of the whole
+// transform, which is what lets the visualiser keep to a per-block budget.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <Fft.h>
+#include <Spectrum.h>
+
+const size_t AUDIO_BENCH_FRAMES = 1152;
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+// Nanoseconds: reads as cycles of a 1 GHz clock
+static uint64_t cycleCount() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static void makeSignal(FftComplex* data, double amplitude, std::mt19937& random) {
+  std::uniform_real_distribution<double> noise(-0.05, 0.05);
+  for (uint16_t n = 0; n < FFT_SIZE; n++) {
+    double x = 0.6 * sin(2 * M_PI * 5 * n / FFT_SIZE) + 0.3 * sin(2 * M_PI * 37.5 * n / FFT_SIZE) + noise(random);
+    data[n].re = (int16_t)lround(32767 * amplitude * std::max(-1.0, std::min(1.0, x)));
+    data[n].im = 0;
+  }
+}
+
+// Largest error against the exact DFT / 256, in LSB
+static double maxError(const FftComplex* input, const FftComplex* output) {
+  double worst = 0;
+  for (uint16_t k = 0; k < FFT_SIZE; k++) {
+    double re = 0, im = 0;
+    for (uint16_t n = 0; n < FFT_SIZE; n++) {
+      double angle = -2 * M_PI * k * n / FFT_SIZE;
+      re += input[n].re * cos(angle) - input[n].im * sin(angle);
+      im += input[n].re * sin(angle) + input[n].im * cos(angle);
+    }
+    worst = std::max(worst, std::max(fabs(re / FFT_SIZE - output[k].re), fabs(im / FFT_SIZE - output[k].im)));
+  }
+  return worst;
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+  if (iterations <= 0) {
+    fprintf(stderr, "usage: fft_bench [iterations]\n");
+    return 2;
+  }
+  std::mt19937 random(1);
+  FftComplex input[FFT_SIZE], data[FFT_SIZE];
+
+  printf("%-10s %12s\n", "amplitude", "max_err_lsb");
+  bool accurate = true;
+  for (double amplitude : {1.0, 0.25, 0.01}) {
+    makeSignal(input, amplitude, random);
+    std::copy(input, input + FFT_SIZE, data);
+    fft256(data);
+    double error = maxError(input, data);
+    accurate = accurate && error < 4;
+    printf("%-10.2f %12.2f\n", amplitude, error);
+  }
+
+  makeSignal(input, 0.5, random);
+  uint64_t stageCycles[FFT_STAGES] = {};
+  uint64_t reorderCycles = 0;
+  for (int i = 0; i < iterations; i++) {
+    std::copy(input, input + FFT_SIZE, data);
+    for (uint8_t stage = 0; stage < FFT_STAGES; stage++) {
+      uint64_t start = cycleCount();
+      fftStage(data, stage);
+      stageCycles[stage] += cycleCount() - start;
+    }
+    uint64_t start = cycleCount();
+    fftReorder(data);
+    reorderCycles += cycleCount() - start;
+  }
+  uint64_t total = reorderCycles;
+  for (uint8_t stage = 0; stage < FFT_STAGES; stage++) {
+    printf("stage %u     %10.0f cycles\n", stage, (double)stageCycles[stage] / iterations);
+    total += stageCycles[stage];
+  }
+  printf("reorder     %10.0f cycles\n", (double)reorderCycles / iterations);
+  printf("fft256      %10.0f cycles\n", (double)total / iterations);
+
+  // The visualiser's view: one 44.1 kHz stereo block per feed(), then
+  // steps. The tone has a whole number of periods per block, so repeating
+  // the block adds no clicks.
+  static Spectrum spectrum;
+  spectrum.begin(44100);
+  static int16_t block[AUDIO_BENCH_FRAMES * 2];
+  for (size_t i = 0; i < AUDIO_BENCH_FRAMES; i++) {
+    block[2 * i] = block[2 * i + 1] = (int16_t)(16000 * sin(2 * M_PI * 11.0 * i / AUDIO_BENCH_FRAMES));
+  }
+  uint64_t feedCycles = 0;
+  uint64_t stepCycles[SPECTRUM_STEPS] = {};
+  uint32_t windows = 0;
+  int blocks = iterations / 10 + 1;
+  for (int i = 0; i < blocks; i++) {
+    uint64_t start = cycleCount();
+    spectrum.feed(block, AUDIO_BENCH_FRAMES, 2);
+    feedCycles += cycleCount() - start;
+    for (uint8_t s = 0; spectrum.busy(); s++) {
+      start = cycleCount();
+      spectrum.step();
+      stepCycles[s] += cycleCount() - start;
+      if (s == SPECTRUM_STEPS - 1) windows++;
+    }
+  }
+  printf("feed        %10.0f cycles per %zu-frame block\n", (double)feedCycles / blocks, AUDIO_BENCH_FRAMES);
+  for (uint8_t s = 0; s < SPECTRUM_STEPS && windows; s++) {
+    printf("step %u      %10.0f cycles%s\n", s, (double)stepCycles[s] / windows, s < FFT_STAGES ? "" : " (levels)");
+  }
+  printf("levels     ");
+  for (uint8_t band = 0; band < SPECTRUM_BANDS; band++) printf(" %3u", spectrum.levels()[band]);
+  printf("\n");
+  return accurate ? 0 : 1;
+}
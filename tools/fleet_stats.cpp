@@ -0,0 +1,180 @@
+// fleet_stats: merges stats dumps from many boxes into per-firmware numbers.
+//
+//   g++ -std=c++17 -O2 -Ilib/Histogram -Ilib/StatsDump -o fleet_stats
+//       tools/fleet_stats.cpp lib/Histogram/Histogram.cpp lib/StatsDump/StatsDump.cpp
+//   ./fleet_stats [--csv] dumps.bin serial.log ...
+//
+// Inputs are raw dumps, one per file or concatenated (for example
+// `mosquitto_sub -t 'avatarbox/+/dump' -N > dumps.bin`), or text logs with
+// the STATSDUMP lines the `dump` console command prints. Files are read in
+// chunks and every dump is folded in as it is decoded. Counters are totals
+// since boot, so only the newest dump of each boot is kept: memory grows
+// with the number of boots, never with the number of events.
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <Histogram.h>
+#include <StatsDump.h>
+
+struct FirmwareTotals {
+  std::set<std::string> boxes;
+  uint32_t boots = 0;
+  uint64_t detections = 0;
+  uint64_t plays = 0;
+  uint64_t readFailures = 0;
+  uint64_t graceStops = 0;
+  uint64_t uptimeSeconds = 0;
+  Histogram tagToPlayMicros;
+};
+
+static std::map<std::string, StatsDump> latestPerBoot;  // "device/boot" → newest dump
+static uint64_t dumpsRead = 0;
+static uint64_t bytesSkipped = 0;
+
+static void ingest(const StatsDump& dump) {
+  dumpsRead++;
+  char key[64];
+  snprintf(key, sizeof(key), "%s/%08x", dump.deviceId, dump.bootId);
+  auto it = latestPerBoot.find(key);
+  if (it == latestPerBoot.end()) latestPerBoot.emplace(key, dump);
+  else if (dump.uptimeSeconds >= it->second.uptimeSeconds) it->second = dump;
+}
+
+// Decodes as many dumps as the buffer holds and drops them from the front.
+// A buffer that cannot start a dump is resynchronised on the next magic.
+static void drainBinary(std::vector<uint8_t>& buffer, bool atEnd) {
+  size_t pos = 0;
+  while (pos < buffer.size()) {
+    StatsDump dump;
+    size_t used = decodeStatsDump(buffer.data() + pos, buffer.size() - pos, dump);
+    if (used > 0) {
+      ingest(dump);
+      pos += used;
+      continue;
+    }
+    bool complete = atEnd || buffer.size() - pos >= STATS_DUMP_MAX_SIZE;
+    bool magic = buffer.size() - pos >= 4 && memcmp(buffer.data() + pos, "AMBS", 4) == 0;
+    if (!complete && (magic || buffer.size() - pos < 4)) break;  // wait for more bytes
+    pos++;
+    bytesSkipped++;
+  }
+  buffer.erase(buffer.begin(), buffer.begin() + pos);
+}
+
+static void readBinary(std::ifstream& in) {
+  std::vector<uint8_t> buffer;
+  char chunk[64 * 1024];
+  while (in) {
+    in.read(chunk, sizeof(chunk));
+    buffer.insert(buffer.end(), chunk, chunk + in.gcount());
+    drainBinary(buffer, false);
+  }
+  drainBinary(buffer, true);
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static void readText(std::ifstream& in) {
+  std::string line;
+  std::vector<uint8_t> bytes;
+  while (std::getline(in, line)) {
+    size_t start = line.find("STATSDUMP ");
+    if (start == std::string::npos) continue;
+    bytes.clear();
+    for (size_t i = start + 10; i + 1 < line.size(); i += 2) {
+      int high = hexValue(line[i]), low = hexValue(line[i + 1]);
+      if (high < 0 || low < 0) break;
+      bytes.push_back(high << 4 | low);
+    }
+    StatsDump dump;
+    if (decodeStatsDump(bytes.data(), bytes.size(), dump) > 0) ingest(dump);
+    else bytesSkipped += bytes.size();
+  }
+}
+
+static bool readFile(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    fprintf(stderr, "fleet_stats: cannot open %s\n", path);
+    return false;
+  }
+  char magic[4] = {0};
+  in.read(magic, 4);
+  in.clear();
+  in.seekg(0);
+  if (memcmp(magic, "AMBS", 4) == 0) readBinary(in);
+  else readText(in);
+  return true;
+}
+
+static double percent(uint64_t part, uint64_t whole) { return whole ? 100.0 * part / whole : 0.0; }
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  int files = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0) {
+      csv = true;
+      continue;
+    }
+    if (!readFile(argv[i])) return 1;
+    files++;
+  }
+  if (files == 0) {
+    fprintf(stderr, "usage: fleet_stats [--csv] <dump or log files...>\n");
+    return 2;
+  }
+
+  std::map<std::string, FirmwareTotals> byFirmware;
+  for (const auto& entry : latestPerBoot) {
+    const StatsDump& d = entry.second;
+    FirmwareTotals& t = byFirmware[d.firmware];
+    t.boxes.insert(d.deviceId);
+    t.boots++;
+    t.detections += d.detections;
+    t.plays += d.plays;
+    t.readFailures += d.readFailures;
+    t.graceStops += d.graceStops;
+    t.uptimeSeconds += d.uptimeSeconds;
+    t.tagToPlayMicros.merge(d.tagToPlayMicros);
+  }
+
+  if (csv) {
+    printf("firmware,boxes,boots,uptime_h,detections,plays,ttp_n,ttp_p50_us,ttp_p90_us,ttp_p99_us,"
+           "ttp_max_us,read_fail_pct,grace_stops,grace_stops_per_100_plays\n");
+  } else {
+    printf("%-10s %6s %6s %9s %9s %8s  %-31s %9s %12s\n", "firmware", "boxes", "boots", "uptime_h",
+           "detect", "plays", "tag-to-play ms p50/p90/p99/max", "read_fail", "grace/100pl");
+  }
+  for (const auto& entry : byFirmware) {
+    const FirmwareTotals& t = entry.second;
+    const Histogram& h = t.tagToPlayMicros;
+    double gracePer100 = t.plays ? 100.0 * t.graceStops / t.plays : 0.0;
+    if (csv) {
+      printf("%s,%zu,%u,%.1f,%llu,%llu,%u,%u,%u,%u,%u,%.2f,%llu,%.2f\n", entry.first.c_str(),
+             t.boxes.size(), t.boots, t.uptimeSeconds / 3600.0, (unsigned long long)t.detections,
+             (unsigned long long)t.plays, h.count(), h.percentile(50), h.percentile(90),
+             h.percentile(99), h.maxValue(), percent(t.readFailures, t.detections),
+             (unsigned long long)t.graceStops, gracePer100);
+    } else {
+      char latency[64];
+      snprintf(latency, sizeof(latency), "%.1f/%.1f/%.1f/%.1f", h.percentile(50) / 1000.0,
+               h.percentile(90) / 1000.0, h.percentile(99) / 1000.0, h.maxValue() / 1000.0);
+      printf("%-10s %6zu %6u %9.1f %9llu %8llu  %-31s %8.2f%% %12.2f\n", entry.first.c_str(),
+             t.boxes.size(), t.boots, t.uptimeSeconds / 3600.0, (unsigned long long)t.detections,
+             (unsigned long long)t.plays, latency, percent(t.readFailures, t.detections), gracePer100);
+    }
+  }
+  fprintf(stderr, "fleet_stats: %llu dumps, %zu boots, %llu bytes skipped\n",
+          (unsigned long long)dumpsRead, latestPerBoot.size(), (unsigned long long)bytesSkipped);
+  return 0;
+}
@@ -0,0 +1,241 @@
+// loudness_scan: measures every track of a music library and prints the
+// per-track gain table for the box (see lib/TrackGain/TrackGain.h).
+//
+//   g++ -std=c++17 -O2 -Ilib/AudioCodec -Ilib/TrackGain -o loudness_scan
+//       tools/loudness_scan.cpp lib/TrackGain/TrackGain.cpp
+//       lib/AudioCodec/AudioCodec.cpp lib/AudioCodec/WavDecoder.cpp
+//       lib/AudioCodec/ImaAdpcm.cpp lib/AudioCodec/Mp3Decoder.cpp
+//   ./loudness_scan <library dir> [gains.txt]
+//
+// The library is laid out like the SD card: playlists in folders 01..99
+// with files starting with a three-digit track number, single tracks in
+// mp3/ or the root starting with their track number. Decoding is the same
+// as tools/audio_convert.cpp: WAV by default, MP3 with -DENABLE_MP3_CODEC
+// and the Helix sources.
+//
+// Loudness is ITU-R BS.1770-4 integrated loudness (K-weighting, 400 ms
+// blocks with 75% overlap, absolute gate at -70 LUFS, relative gate 10 LU
+// below), and the gain brings each track to -18 LUFS like ReplayGain 2.0.
+// Gains that would push the sample peak above full scale are reduced.
+// The table is written as one `gains <hex>` line: paste it into the serial
+// console, or `cat gains.txt > /dev/ttyUSB0`.
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <AudioCodec.h>
+#include <TrackGain.h>
+
+namespace fs = std::filesystem;
+
+class FileSource : public AudioSource {
+ public:
+  explicit FileSource(FILE* file) : file(file) {}
+  size_t read(uint8_t* data, size_t length) override { return fread(data, 1, length, file); }
+  bool seek(uint32_t offset) override { return fseek(file, offset, SEEK_SET) == 0; }
+
+ private:
+  FILE* file;
+};
+
+// Direct form I biquad, a0 normalised to 1
+struct Biquad {
+  double b0, b1, b2, a1, a2;
+  double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  double run(double x) {
+    double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+};
+
+// K-weighting for any sample rate: the high-shelf "pre-filter" and the
+// RLB high-pass of BS.1770, from their analogue prototypes via the
+// bilinear transform. At 48 kHz these are the coefficients in the standard.
+static void kWeighting(double rate, Biquad& shelf, Biquad& highPass) {
+  double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+  double k = tan(M_PI * f0 / rate);
+  double vh = pow(10.0, gainDb / 20.0);
+  double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+           2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan(M_PI * f0 / rate);
+  a0 = 1.0 + k / q + k * k;
+  highPass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+}
+
+struct Measurement {
+  double loudness;  // LUFS, -INFINITY for silence
+  double peak;      // sample peak, 1.0 = full scale
+};
+
+static double blockLoudness(double meanSquare) { return -0.691 + 10.0 * log10(meanSquare); }
+
+// Mean squares are summed per 100 ms step; each gating block is four steps.
+static bool measure(AudioDecoder& decoder, Measurement& result) {
+  uint8_t channels = decoder.channels();
+  double rate = decoder.sampleRate();
+  if (channels == 0 || channels > AUDIO_MAX_CHANNELS || rate <= 0) return false;
+  Biquad shelf[AUDIO_MAX_CHANNELS], highPass[AUDIO_MAX_CHANNELS];
+  for (uint8_t c = 0; c < channels; c++) kWeighting(rate, shelf[c], highPass[c]);
+
+  uint32_t stepFrames = (uint32_t)lround(rate / 10);
+  std::vector<double> steps;
+  double stepEnergy = 0;
+  uint32_t stepFill = 0;
+  result.peak = 0;
+  static int16_t pcm[AUDIO_BLOCK_MAX_FRAMES * AUDIO_MAX_CHANNELS];
+  size_t frames;
+  while ((frames = decoder.decode(pcm)) > 0) {
+    for (size_t i = 0; i < frames; i++) {
+      for (uint8_t c = 0; c < channels; c++) {
+        double x = pcm[i * channels + c] / 32768.0;
+        result.peak = std::max(result.peak, fabs(x));
+        double z = highPass[c].run(shelf[c].run(x));
+        stepEnergy += z * z;  // channel weights are 1 for mono, left and right
+      }
+      if (++stepFill == stepFrames) {
+        steps.push_back(stepEnergy / stepFrames);
+        stepEnergy = 0;
+        stepFill = 0;
+      }
+    }
+  }
+
+  std::vector<double> blocks;
+  for (size_t i = 3; i < steps.size(); i++) {
+    blocks.push_back((steps[i - 3] + steps[i - 2] + steps[i - 1] + steps[i]) / 4);
+  }
+  double sum = 0;
+  size_t count = 0;
+  for (double block : blocks) {
+    if (block > 0 && blockLoudness(block) > -70.0) {
+      sum += block;
+      count++;
+    }
+  }
+  result.loudness = -INFINITY;
+  if (count == 0) return true;
+  double relativeGate = blockLoudness(sum / count) - 10.0;
+  sum = 0;
+  count = 0;
+  for (double block : blocks) {
+    if (block > 0 && blockLoudness(block) > -70.0 && blockLoudness(block) > relativeGate) {
+      sum += block;
+      count++;
+    }
+  }
+  result.loudness = blockLoudness(sum / count);
+  return true;
+}
+
+// Leading digits of the file name, 0 if there are none or too many
+static int trackNumber(const fs::path& file, size_t maxDigits) {
+  std::string name = file.filename().string();
+  size_t digits = 0;
+  while (digits < name.size() && isdigit((unsigned char)name[digits])) digits++;
+  if (digits == 0 || digits > maxDigits) return 0;
+  return std::stoi(name.substr(0, digits));
+}
+
+static TrackGainTable table;
+static int measured = 0;
+static int skipped = 0;
+
+static void scanFile(const fs::path& file, uint8_t folder, int track) {
+  if (track < 1 || track > 255) return;
+  FILE* in = fopen(file.string().c_str(), "rb");
+  if (!in) return;
+  FileSource source(in);
+  AudioCodecType codec = AUDIO_CODEC_UNKNOWN;
+  AudioDecoder* decoder = openAudioDecoder(source, &codec);
+  Measurement m;
+  bool ok = decoder && measure(*decoder, m);
+  fclose(in);
+  if (!ok || !std::isfinite(m.loudness)) {
+    if (codec != AUDIO_CODEC_UNKNOWN) {
+      printf("skip  %s (%s)\n", file.string().c_str(), decoder ? "silent" : "no decoder");
+      skipped++;
+    }
+    return;
+  }
+  double gainDb = TRACK_GAIN_REFERENCE_LUFS - m.loudness;
+  double headroomDb = m.peak > 0 ? -20.0 * log10(m.peak) : gainDb;
+  bool limited = gainDb > headroomDb;
+  if (limited) gainDb = headroomDb;
+  int8_t gain = trackGainFromDb((float)gainDb);
+  if (!table.set(folder, track, gain)) {
+    fprintf(stderr, "table full at %s\n", file.string().c_str());
+    return;
+  }
+  measured++;
+  printf("%02u/%03d  %6.1f LUFS  peak %6.1f dBFS  gain %+6.2f dB%s  %s\n", folder, track, m.loudness,
+         m.peak > 0 ? 20.0 * log10(m.peak) : -INFINITY, trackGainDb(gain), limited ? " (peak)" : "",
+         file.filename().string().c_str());
+}
+
+static std::vector<fs::path> sortedFiles(const fs::path& dir) {
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    if (entry.is_regular_file()) files.push_back(entry.path());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s <library dir> [gains.txt]\n", argv[0]);
+    return 1;
+  }
+  fs::path root = argv[1];
+  if (!fs::is_directory(root)) {
+    fprintf(stderr, "%s is not a directory\n", argv[1]);
+    return 1;
+  }
+  for (const fs::path& file : sortedFiles(root)) scanFile(file, 0, trackNumber(file, 4));
+  for (const char* single : {"mp3", "MP3"}) {
+    if (fs::is_directory(root / single)) {
+      for (const fs::path& file : sortedFiles(root / single)) scanFile(file, 0, trackNumber(file, 4));
+    }
+  }
+  for (int folder = 1; folder <= 99; folder++) {
+    char name[3];
+    snprintf(name, sizeof(name), "%02d", folder);
+    if (!fs::is_directory(root / name)) continue;
+    for (const fs::path& file : sortedFiles(root / name)) scanFile(file, folder, trackNumber(file, 3));
+  }
+
+  std::vector<uint8_t> encoded(TrackGainTable::encodedSize(table.size()));
+  table.encode(encoded.data(), encoded.size());
+  std::string line = "gains ";
+  for (uint8_t b : encoded) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02X", b);
+    line += hex;
+  }
+  printf("%d tracks measured, %d skipped\n", measured, skipped);
+  if (argc == 3) {
+    FILE* out = fopen(argv[2], "w");
+    if (!out) {
+      fprintf(stderr, "cannot write %s\n", argv[2]);
+      return 1;
+    }
+    fprintf(out, "%s\n", line.c_str());
+    fclose(out);
+  } else {
+    printf("%s\n", line.c_str());
+  }
+  return 0;
+}
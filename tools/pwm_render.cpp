@@ -0,0 +1,154 @@
+// pwm_render: runs the PWM output kernel (lib/PwmAudio) over an audio file
+// on a PC, to check it bit for bit and to see what noise shaping buys.
+//
+//   g++ -std=c++17 -O2 -Ilib/AudioCodec -Ilib/PwmAudio -o pwm_render
+//       tools/pwm_render.cpp lib/PwmAudio/PwmRender.cpp
+//       lib/AudioCodec/AudioCodec.cpp lib/AudioCodec/WavDecoder.cpp
+//       lib/AudioCodec/ImaAdpcm.cpp lib/AudioCodec/Mp3Decoder.cpp
+//   ./pwm_render <audio file> <duty file>          write the duty stream
+//   ./pwm_render --check <audio file> <duty file>  compare against one
+//
+// The duty file is the raw stream of 8-bit duty values the sample timer
+// writes to the pin, one per frame at the file's sample rate. A stream
+// written once from a known build is the reference for later changes to
+// the kernel: --check exits 1 at the first byte that differs. Both modes
+// print the noise below 4 kHz, where the speaker is loudest, with and
+// without noise shaping.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <AudioCodec.h>
+#include <PwmRender.h>
+
+class FileSource : public AudioSource {
+ public:
+  explicit FileSource(FILE* file) : file(file) {}
+  size_t read(uint8_t* data, size_t length) override { return fread(data, 1, length, file); }
+  bool seek(uint32_t offset) override { return fseek(file, offset, SEEK_SET) == 0; }
+
+ private:
+  FILE* file;
+};
+
+// Fourth-order Butterworth low-pass (two biquads) for the in-band noise
+struct LowPass {
+  double b[2][3], a[2][3], z[2][2] = {};
+  LowPass(double cutoff, double rate) {
+    const double q[2] = {0.5411961, 1.3065630};
+    for (int s = 0; s < 2; s++) {
+      double w = 2 * M_PI * cutoff / rate, alpha = sin(w) / (2 * q[s]), c = cos(w);
+      double a0 = 1 + alpha;
+      b[s][0] = (1 - c) / 2 / a0;
+      b[s][1] = (1 - c) / a0;
+      b[s][2] = (1 - c) / 2 / a0;
+      a[s][1] = -2 * c / a0;
+      a[s][2] = (1 - alpha) / a0;
+    }
+  }
+  double run(double x) {
+    for (int s = 0; s < 2; s++) {
+      double y = b[s][0] * x + z[s][0];
+      z[s][0] = b[s][1] * x - a[s][1] * y + z[s][1];
+      z[s][1] = b[s][2] * x - a[s][2] * y;
+      x = y;
+    }
+    return x;
+  }
+};
+
+// The error between the mono input and the rendered output, low-passed,
+// relative to full scale
+static double inBandNoiseDb(const std::vector<int16_t>& mono, const std::vector<uint8_t>& duty, uint32_t rate) {
+  LowPass filter(4000, rate);
+  double energy = 0;
+  for (size_t i = 0; i < mono.size(); i++) {
+    double error = ((int)duty[i] - 128) * 256.0 - mono[i];
+    double filtered = filter.run(error / 32768.0);
+    energy += filtered * filtered;
+  }
+  return 10 * log10(energy / mono.size() + 1e-20) + 3.01;  // re a full-scale sine
+}
+
+int main(int argc, char** argv) {
+  bool check = argc == 4 && strcmp(argv[1], "--check") == 0;
+  if (argc != 3 && !check) {
+    fprintf(stderr, "usage: pwm_render [--check] <audio file> <duty file>\n");
+    return 2;
+  }
+  const char* audioPath = argv[check ? 2 : 1];
+  const char* dutyPath = argv[check ? 3 : 2];
+
+  FILE* in = fopen(audioPath, "rb");
+  if (!in) {
+    fprintf(stderr, "cannot open %s\n", audioPath);
+    return 1;
+  }
+  FileSource source(in);
+  AudioDecoder* decoder = openAudioDecoder(source);
+  if (!decoder) {
+    fprintf(stderr, "%s: no decoder\n", audioPath);
+    return 1;
+  }
+  std::vector<int16_t> pcm, mono;
+  static int16_t block[AUDIO_BLOCK_MAX_FRAMES * AUDIO_MAX_CHANNELS];
+  size_t frames;
+  uint8_t channels = decoder->channels();
+  while ((frames = decoder->decode(block)) > 0) {
+    pcm.insert(pcm.end(), block, block + frames * channels);
+    for (size_t i = 0; i < frames; i++) {
+      mono.push_back(channels == 2 ? (block[2 * i] + block[2 * i + 1]) / 2 : block[i]);
+    }
+  }
+  fclose(in);
+  uint32_t rate = decoder->sampleRate();
+
+  // Rendered in device-sized blocks, so state carried between blocks is exercised
+  std::vector<uint8_t> shaped(mono.size()), flat(mono.size());
+  static PwmRenderer renderer;
+  for (bool shaping : {true, false}) {
+    renderer.reset();
+    renderer.setNoiseShaping(shaping);
+    std::vector<uint8_t>& out = shaping ? shaped : flat;
+    for (size_t i = 0; i < mono.size(); i += AUDIO_BLOCK_MAX_FRAMES) {
+      size_t n = std::min<size_t>(AUDIO_BLOCK_MAX_FRAMES, mono.size() - i);
+      renderer.render(pcm.data() + i * channels, n, channels, out.data() + i);
+    }
+  }
+  printf("%zu frames at %u Hz\n", mono.size(), rate);
+  printf("noise below 4 kHz: %.1f dBFS shaped, %.1f dBFS without shaping\n", inBandNoiseDb(mono, shaped, rate),
+         inBandNoiseDb(mono, flat, rate));
+
+  if (!check) {
+    FILE* out = fopen(dutyPath, "wb");
+    if (!out || fwrite(shaped.data(), 1, shaped.size(), out) != shaped.size()) {
+      fprintf(stderr, "cannot write %s\n", dutyPath);
+      return 1;
+    }
+    fclose(out);
+    return 0;
+  }
+  FILE* reference = fopen(dutyPath, "rb");
+  if (!reference) {
+    fprintf(stderr, "cannot open %s\n", dutyPath);
+    return 1;
+  }
+  std::vector<uint8_t> expected;
+  uint8_t chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), reference)) > 0) expected.insert(expected.end(), chunk, chunk + n);
+  fclose(reference);
+  for (size_t i = 0; i < std::min(expected.size(), shaped.size()); i++) {
+    if (expected[i] != shaped[i]) {
+      printf("MISMATCH at frame %zu: %u, expected %u\n", i, shaped[i], expected[i]);
+      return 1;
+    }
+  }
+  if (expected.size() != shaped.size()) {
+    printf("MISMATCH in length: %zu frames, expected %zu\n", shaped.size(), expected.size());
+    return 1;
+  }
+  printf("OK, identical to %s\n", dutyPath);
+  return 0;
+}